@@ -0,0 +1,469 @@
+// Size sweep over the DSP building blocks and the full pipeline.
+//
+//     signalfilter-bench [--min-log2 10] [--max-log2 22] [--ops fft,rfft,...]
+//                        [--time 0.2] [--simd scalar|sse2|avx2|avx512]
+//                        [--four-step-min log2] [--format csv|json]
+//
+// For every operation and size it reports the time per call and per
+// point, the throughput in million points (samples) per second, a GFLOP/s
+// equivalent for the transforms (5 N log2 N flops for a complex FFT, half
+// that for a real one), and heap allocations per call counted by the
+// replaced global operator new. Output goes to stdout.
+//
+// --four-step-min plans transforms from 2^log2 points on as four-step
+// ones; running the fft ops once with a low and once with a high value
+// shows where the four-step layout starts to pay off on this machine.
+
+#include "LiveMonitor.h"
+#include "SignalProcessor.h"
+#include "Spectrogram.h"
+#include "SpectrumFilter.h"
+#include "io/SampleFeed.h"
+#include "io/SyntheticSignal.h"
+#include "math/fft.h"
+#include "math/fir.h"
+#include "math/noise.h"
+#include "math/oscillator.h"
+#include "math/tone_tracker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+std::atomic<size_t> g_Allocations{ 0 };
+
+void* counted_alloc(size_t size)
+{
+    g_Allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+}
+
+void* operator new(size_t size) { return counted_alloc(size); }
+void* operator new[](size_t size) { return counted_alloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace
+{
+struct Options
+{
+    int minLog2 = 10;
+    int maxLog2 = 22;
+    double seconds = 0.2;
+    bool json = false;
+    std::vector<std::string> ops;
+};
+
+// One benchmark case at a fixed size: the factory prepares inputs outside
+// the timed region, run is the measured call.
+struct Case
+{
+    std::function<void()> run;
+    // Flops of one call for the GFLOP/s column; 0 when not meaningful.
+    double flops = 0;
+};
+
+using CaseFactory = std::function<Case(size_t n)>;
+
+struct Operation
+{
+    const char* name;
+    CaseFactory make;
+};
+
+double log2_of(size_t n) { return std::log2(double(n)); }
+
+std::vector<double> random_samples(size_t n)
+{
+    std::vector<double> x(n);
+    gaussian_noise(7, 0, x.data(), n);
+    return x;
+}
+
+// Transforms run in place on the same buffers call after call; their
+// timing does not depend on the values.
+Case fft_case(size_t n, bool inverse)
+{
+    auto re = std::make_shared<std::vector<double>>(random_samples(n));
+    auto im = std::make_shared<std::vector<double>>(random_samples(n));
+    const FftPlan& plan = get_fft_plan(n);
+    auto run = [=, &plan]
+    {
+        if (inverse) plan.Inverse(re->data(), im->data());
+        else plan.Forward(re->data(), im->data());
+    };
+    return { run, 5.0 * n * log2_of(n) };
+}
+
+// Several channels of n points each, transformed by one batch call on
+// interleaved channels or by one plan call per channel of a split array.
+// 64 channels, fewer from 2^16 points on so that a batch stays at 2^21
+// samples.
+Case fft_channels_case(size_t n, bool batched)
+{
+    const size_t channels = std::max<size_t>(1, std::min<size_t>(64, (size_t(1) << 21) / n));
+    auto re = std::make_shared<std::vector<double>>(random_samples(n * channels));
+    auto im = std::make_shared<std::vector<double>>(random_samples(n * channels));
+    const FftPlan& plan = get_fft_plan(n);
+    auto run = [=, &plan]
+    {
+        if (batched)
+        {
+            plan.ForwardBatch(re->data(), im->data(), channels, BatchLayout::Interleaved);
+            return;
+        }
+        for (size_t c = 0; c < channels; ++c) plan.Forward(re->data() + c * n, im->data() + c * n);
+    };
+    return { run, 5.0 * n * log2_of(n) * channels };
+}
+
+template <class T>
+Case rfft_case(size_t n, bool inverse)
+{
+    auto samples = random_samples(n);
+    auto x = std::make_shared<std::vector<T>>(samples.begin(), samples.end());
+    const auto& plan = get_real_fft_plan<T>(n);
+    auto bins = std::make_shared<std::vector<std::complex<T>>>(plan.Bins());
+    plan.Forward(x->data(), bins->data());
+    auto run = [=, &plan]
+    {
+        if (inverse) plan.Inverse(bins->data(), x->data());
+        else plan.Forward(x->data(), bins->data());
+    };
+    return { run, 2.5 * n * log2_of(n) };
+}
+
+// Prepare + Apply on the half spectrum of n noisy samples; the spectrum is
+// restored from a copy outside the kernel so every call sees the same input.
+Case filter_case(size_t n, FilterKind kind)
+{
+    auto x = random_samples(n);
+    const RealFftPlan& plan = get_real_fft_plan(n);
+    auto source = std::make_shared<std::vector<Complex>>(plan.Bins());
+    plan.Forward(x.data(), source->data());
+
+    auto spectrum = std::make_shared<std::vector<Complex>>(*source);
+    auto amplitudes = std::make_shared<std::vector<double>>(plan.Bins());
+    amplitude_spectrum(source->data(), source->size(), n, amplitudes->data());
+
+    std::shared_ptr<SpectrumFilter<double>> filter = SpectrumFilter<double>::Create(kind);
+    FilterParams params{ 0.9, 3.0 };
+    auto run = [=]
+    {
+        std::copy(source->begin(), source->end(), spectrum->begin());
+        filter->Prepare(amplitudes->data(), amplitudes->size(), n);
+        filter->Apply(spectrum->data(), amplitudes->data(), params);
+    };
+    return { run, 0 };
+}
+
+// A whole signal through the FIR filter in the given engine: 63 taps run
+// in direct form and 511 by overlap-save at every SIMD level.
+Case fir_case(size_t n, size_t taps)
+{
+    auto x = std::make_shared<std::vector<double>>(random_samples(n));
+    auto y = std::make_shared<std::vector<double>>(n);
+    auto filter = std::make_shared<FirFilter>(design_fir(0, 0.1, taps));
+    auto run = [=] { filter->Apply(x->data(), y->data(), n); };
+    return { run, 0 };
+}
+
+// Three Hann-windowed tones tracked on each of 64 channels of n samples,
+// one tracker per channel; the time per point covers all 64 channels.
+Case tones_case(size_t n)
+{
+    constexpr size_t kChannels = 64;
+    auto x = std::make_shared<std::vector<double>>(random_samples(n));
+    auto trackers = std::make_shared<std::vector<ToneTracker>>();
+    for (size_t c = 0; c < kChannels; ++c)
+    {
+        trackers->emplace_back(ToneTracker::Config{ 48000, { 50.0 + c, 150.0 + c, 250.0 + c }, 4096 });
+    }
+    auto run = [=]
+    {
+        for (auto& tracker : *trackers) tracker.Process(x->data(), n);
+    };
+    return { run, 0 };
+}
+
+// n more samples of a stream into the default spectrogram: the cost per
+// sample stays flat however long the stream has run.
+Case spectrogram_case(size_t n)
+{
+    auto x = std::make_shared<std::vector<double>>(random_samples(n));
+    auto spectrogram = std::make_shared<Spectrogram>(Spectrogram::Config{});
+    auto run = [=] { spectrogram->Push(x->data(), n); };
+    return { run, 0 };
+}
+
+Case signal_case(size_t n)
+{
+    auto out = std::make_shared<std::vector<double>>(n);
+    auto tones = std::make_shared<std::vector<Sinusoid>>();
+    for (int h = 1; h <= 3; ++h) tones->push_back({ 10.0 / h, 2 * PI * 10 * h / 1024.0, 0.1 * h });
+    auto run = [=] { synthesize_sinusoids(tones->data(), tones->size(), out->data(), n); };
+    return { run, 0 };
+}
+
+Case noise_case(size_t n)
+{
+    auto out = std::make_shared<std::vector<double>>(n);
+    auto run = [=] { gaussian_noise(1, 0, out->data(), n); };
+    return { run, 0 };
+}
+
+// Full recomputation: alternating the sample rate dirties every stage.
+Case update_case(size_t n, Precision precision)
+{
+    auto processor = std::make_shared<SignalProcessor>();
+    auto cfg = std::make_shared<SignalProcessor::Config>();
+    cfg->pointCount = int(n);
+    cfg->precision = precision;
+    processor->Update(*cfg);
+    auto run = [=]
+    {
+        cfg->sampleRate = cfg->sampleRate == 1024 ? 1000 : 1024;
+        processor->Update(*cfg);
+    };
+    return { run, 0 };
+}
+
+// Sustained live throughput: an unpaced feed keeps the ring full and a
+// call waits until the monitor has filtered n more samples, so the time
+// per point is the consumer's cost per sample including the ring.
+struct LiveRig
+{
+    std::unique_ptr<LiveMonitor> monitor;
+    // Declared after the monitor so that it stops first.
+    std::unique_ptr<SampleFeed> feed;
+};
+
+Case live_case(size_t n)
+{
+    auto rig = std::make_shared<LiveRig>();
+    LiveMonitor::Config cfg;
+    cfg.filter.filter = FilterKind::Wiener;
+    rig->monitor = std::make_unique<LiveMonitor>(cfg);
+
+    SampleFeed::Config feedCfg;
+    feedCfg.paced = false;
+    auto source = std::make_shared<SyntheticSignal>(cfg.sampleRate, std::vector<SinParam>{ { 1.0f, 1000.0f, 0.0f } },
+                                                    0.2f, 1);
+    rig->feed = std::make_unique<SampleFeed>(feedCfg, source, rig->monitor->Input());
+
+    auto run = [=]
+    {
+        const uint64_t target = rig->monitor->Consumed() + n;
+        while (rig->monitor->Consumed() < target) std::this_thread::yield();
+    };
+    return { run, 0 };
+}
+
+const Operation kOperations[] = {
+    { "fft", [](size_t n) { return fft_case(n, false); } },
+    { "ifft", [](size_t n) { return fft_case(n, true); } },
+    { "fft_batch", [](size_t n) { return fft_channels_case(n, true); } },
+    { "fft_loop", [](size_t n) { return fft_channels_case(n, false); } },
+    { "rfft", [](size_t n) { return rfft_case<double>(n, false); } },
+    { "irfft", [](size_t n) { return rfft_case<double>(n, true); } },
+    { "rfft_f32", [](size_t n) { return rfft_case<float>(n, false); } },
+    { "irfft_f32", [](size_t n) { return rfft_case<float>(n, true); } },
+    { "filter_cutoff", [](size_t n) { return filter_case(n, FilterKind::EnergyCutoff); } },
+    { "filter_wiener", [](size_t n) { return filter_case(n, FilterKind::Wiener); } },
+    { "fir_direct", [](size_t n) { return fir_case(n, 63); } },
+    { "fir_fft", [](size_t n) { return fir_case(n, 511); } },
+    { "tones", tones_case },
+    { "spectrogram", spectrogram_case },
+    { "signal", signal_case },
+    { "noise", noise_case },
+    { "update", [](size_t n) { return update_case(n, Precision::Double); } },
+    { "update_f32", [](size_t n) { return update_case(n, Precision::Float); } },
+    { "live", live_case },
+};
+
+struct Result
+{
+    const char* op;
+    size_t n;
+    size_t iterations;
+    double nsPerCall;
+    double gflops;
+    double allocsPerCall;
+};
+
+Result measure(const Operation& op, size_t n, double seconds)
+{
+    Case c = op.make(n);
+    // Warm-up: plans, caches and scratch buffers are built here.
+    c.run();
+
+    using Clock = std::chrono::steady_clock;
+    size_t iterations = 0;
+    size_t allocations = g_Allocations.load();
+    auto start = Clock::now();
+    double elapsed = 0;
+    for (size_t batch = 1; elapsed < seconds; batch *= 2)
+    {
+        for (size_t i = 0; i < batch; ++i) c.run();
+        iterations += batch;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    allocations = g_Allocations.load() - allocations;
+
+    double nsPerCall = elapsed * 1e9 / iterations;
+    return { op.name, n, iterations, nsPerCall, c.flops > 0 ? c.flops / nsPerCall : 0,
+             double(allocations) / iterations };
+}
+
+void print_header(const Options& options)
+{
+    if (options.json)
+    {
+        std::printf("{\n  \"simd\": \"%s\",\n  \"results\": [", to_string(fft_simd_level()));
+    }
+    else
+    {
+        std::printf("op,n,simd,iterations,ns_per_call,ns_per_point,msamples_per_s,gflops,allocs_per_call\n");
+    }
+}
+
+void print_result(const Options& options, const Result& r, bool first)
+{
+    if (options.json)
+    {
+        std::printf("%s\n    {\"op\": \"%s\", \"n\": %zu, \"iterations\": %zu, \"ns_per_call\": %.1f, "
+                    "\"ns_per_point\": %.4f, \"msamples_per_s\": %.2f, \"gflops\": ",
+                    first ? "" : ",", r.op, r.n, r.iterations, r.nsPerCall, r.nsPerCall / r.n,
+                    1e3 * r.n / r.nsPerCall);
+        if (r.gflops > 0) std::printf("%.3f", r.gflops);
+        else std::printf("null");
+        std::printf(", \"allocs_per_call\": %.2f}", r.allocsPerCall);
+    }
+    else
+    {
+        std::printf("%s,%zu,%s,%zu,%.1f,%.4f,%.2f,", r.op, r.n, to_string(fft_simd_level()), r.iterations,
+                    r.nsPerCall, r.nsPerCall / r.n, 1e3 * r.n / r.nsPerCall);
+        if (r.gflops > 0) std::printf("%.3f", r.gflops);
+        std::printf(",%.2f\n", r.allocsPerCall);
+    }
+    std::fflush(stdout);
+}
+
+void print_footer(const Options& options)
+{
+    if (options.json) std::printf("\n  ]\n}\n");
+}
+
+bool parse_simd(const char* name, SimdLevel& level)
+{
+    for (SimdLevel l : { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Avx512 })
+    {
+        std::string lower = to_string(l);
+        for (auto& ch : lower) ch = char(std::tolower(ch));
+        lower.erase(std::remove(lower.begin(), lower.end(), '-'), lower.end());
+        if (lower == name)
+        {
+            level = l;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<std::string> split(const std::string& list)
+{
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= list.size())
+    {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos) comma = list.size();
+        if (comma > start) items.push_back(list.substr(start, comma - start));
+        start = comma + 1;
+    }
+    return items;
+}
+
+int usage()
+{
+    std::fprintf(stderr, "usage: signalfilter-bench [--min-log2 N] [--max-log2 N] [--ops a,b,...] "
+                         "[--time seconds] [--simd scalar|sse2|avx2|avx512] [--four-step-min log2] "
+                         "[--format csv|json]\nops:");
+    for (const auto& op : kOperations) std::fprintf(stderr, " %s", op.name);
+    std::fprintf(stderr, "\n");
+    return 2;
+}
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) return usage();
+        const char* value = argv[++i];
+
+        if (arg == "--min-log2") options.minLog2 = std::atoi(value);
+        else if (arg == "--max-log2") options.maxLog2 = std::atoi(value);
+        else if (arg == "--time") options.seconds = std::atof(value);
+        else if (arg == "--ops") options.ops = split(value);
+        else if (arg == "--format" && (std::strcmp(value, "csv") == 0 || std::strcmp(value, "json") == 0))
+            options.json = std::strcmp(value, "json") == 0;
+        else if (arg == "--simd")
+        {
+            SimdLevel level;
+            if (!parse_simd(value, level)) return usage();
+            fft_set_simd_level(level);
+        }
+        else if (arg == "--four-step-min")
+        {
+            int log2n = std::atoi(value);
+            if (log2n < 1 || log2n > 40) return usage();
+            set_four_step_min_size(size_t(1) << log2n);
+        }
+        else return usage();
+    }
+
+    std::vector<const Operation*> selected;
+    for (const auto& op : kOperations)
+    {
+        if (options.ops.empty() || std::find(options.ops.begin(), options.ops.end(), op.name) != options.ops.end())
+        {
+            selected.push_back(&op);
+        }
+    }
+    if (selected.empty() || options.minLog2 < 0 || options.maxLog2 > 30 || options.minLog2 > options.maxLog2)
+    {
+        return usage();
+    }
+
+    print_header(options);
+    bool first = true;
+    for (const Operation* op : selected)
+    {
+        for (int log2n = options.minLog2; log2n <= options.maxLog2; ++log2n)
+        {
+            print_result(options, measure(*op, size_t(1) << log2n, options.seconds), first);
+            first = false;
+        }
+    }
+    print_footer(options);
+    return 0;
+}
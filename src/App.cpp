@@ -1,6 +1,12 @@
 #include "App.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+
+#include "io/SyntheticSignal.h"
+#include "util/Profiler.h"
 
 App::App()
 {
@@ -27,6 +33,10 @@ App::App()
 
 App::~App()
 {
+    // The sweep future joins its thread when destroyed; stop it early.
+    m_SweepCancel = true;
+    m_Waterfall.Release();
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -42,26 +52,48 @@ void App::Run()
     {
         glfwPollEvents();
 
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-
-        RenderControlPanel();
-
-        if (m_NeedsUpdate)
         {
-            m_Processor.Update(m_Config);
-            m_NeedsUpdate = false;
+            PROFILE_SCOPE("Frame");
+            {
+                PROFILE_SCOPE("Frame: new frame");
+                ImGui_ImplOpenGL3_NewFrame();
+                ImGui_ImplGlfw_NewFrame();
+                ImGui::NewFrame();
+            }
+
+            m_Snapshot = m_Worker.Latest();
+
+            {
+                PROFILE_SCOPE("Frame: control panel");
+                RenderControlPanel();
+            }
+
+            if (m_NeedsUpdate)
+            {
+                m_Worker.Submit(m_Config);
+                m_NeedsUpdate = false;
+            }
+
+            {
+                PROFILE_SCOPE("Frame: plots");
+                RenderPlots();
+                RenderSweepPlot();
+                RenderLivePlot();
+                RenderSpectrogram();
+            }
+
+            {
+                PROFILE_SCOPE("Frame: render");
+                ImGui::Render();
+                int display_w, display_h;
+                glfwGetFramebufferSize(m_Window, &display_w, &display_h);
+                glViewport(0, 0, display_w, display_h);
+                glClear(GL_COLOR_BUFFER_BIT);
+                ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            }
         }
 
-        RenderPlots();
-
-        ImGui::Render();
-        int display_w, display_h;
-        glfwGetFramebufferSize(m_Window, &display_w, &display_h);
-        glViewport(0, 0, display_w, display_h);
-        glClear(GL_COLOR_BUFFER_BIT);
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        // Outside the frame scope: swapping blocks on vsync.
         glfwSwapBuffers(m_Window);
     }
 }
@@ -77,72 +109,539 @@ void App::RenderControlPanel()
         ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove |
         ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoTitleBar))
     {
-        int oldPointCount = m_Config.pointCount;
-
-        ImGui::Separator();
-        m_NeedsUpdate |= SinController("First harmonic", m_Config.sin1);
         ImGui::Separator();
-        m_NeedsUpdate |= SinController("Second harmonic", m_Config.sin2);
-        ImGui::Separator();
-        m_NeedsUpdate |= SinController("Third harmonic", m_Config.sin3);
+        auto& harmonics = m_Config.harmonics;
+        for (size_t i = 0; i < harmonics.size(); ++i)
+        {
+            char title[32];
+            std::snprintf(title, sizeof(title), "Harmonic %zu", i + 1);
+            m_NeedsUpdate |= SinController(title, harmonics[i]);
+            ImGui::PushID(title);
+            if (harmonics.size() > 1 && ImGui::SmallButton("Remove"))
+            {
+                harmonics.erase(harmonics.begin() + i);
+                m_NeedsUpdate = true;
+                ImGui::PopID();
+                break;
+            }
+            ImGui::PopID();
+            ImGui::Separator();
+        }
+        if (ImGui::Button("Add harmonic"))
+        {
+            harmonics.push_back({});
+            m_NeedsUpdate = true;
+        }
         ImGui::Separator();
 
         m_NeedsUpdate |= ImGui::InputInt("Sample Rate", &m_Config.sampleRate, 100);
         m_NeedsUpdate |= ImGui::InputInt("Points", &m_Config.pointCount, 100);
         ImGui::Separator();
         m_NeedsUpdate |= ImGui::InputFloat("Noise alpha", &m_Config.noiseAlpha, 0.01f, 0.01f, "%.2f");
-        m_NeedsUpdate |= ImGui::InputFloat("Gamma", &m_Config.gamma, 0.01f, 0.01f, "%.2f");
+        const uint64_t seedStep = 1;
+        m_NeedsUpdate |= ImGui::InputScalar("Noise seed", ImGuiDataType_U64, &m_Config.seed, &seedStep);
+        m_NeedsUpdate |= ImGui::InputInt("Channels", &m_Config.channels, 1, 16);
+        if (m_Config.channels > 1)
+            m_NeedsUpdate |= ImGui::InputInt("Channel", &m_Config.displayChannel);
+
+        int filter = static_cast<int>(m_Config.filter);
+        if (ImGui::Combo("Filter", &filter,
+                         "Energy cutoff\0Hard threshold\0Soft threshold\0Wiener\0Spectral subtraction\0"))
+        {
+            m_Config.filter = static_cast<FilterKind>(filter);
+            m_NeedsUpdate = true;
+        }
+        if (m_Config.filter == FilterKind::EnergyCutoff)
+            m_NeedsUpdate |= ImGui::InputFloat("Gamma", &m_Config.gamma, 0.01f, 0.01f, "%.2f");
+        else
+            m_NeedsUpdate |= ImGui::InputFloat("Threshold", &m_Config.threshold, 0.1f, 1.0f, "%.1f");
+        int clean = static_cast<int>(m_Config.clean);
+        if (ImGui::Combo("Clean signal", &clean, "Spectral filter\0FIR filter\0"))
+        {
+            m_Config.clean = static_cast<CleanSource>(clean);
+            m_NeedsUpdate = true;
+        }
+        if (m_Config.clean == CleanSource::Fir)
+        {
+            m_NeedsUpdate |= ImGui::InputFloat("FIR low, Hz", &m_Config.firLow, 1.0f, 10.0f, "%.1f");
+            m_NeedsUpdate |= ImGui::InputFloat("FIR high, Hz", &m_Config.firHigh, 1.0f, 10.0f, "%.1f");
+            m_NeedsUpdate |= ImGui::InputInt("FIR taps", &m_Config.firTaps, 2, 100);
+        }
         m_NeedsUpdate |= ImGui::Checkbox("Show Noise", &m_Config.showNoise);
 
+        int precision = static_cast<int>(m_Config.precision);
+        if (ImGui::Combo("Precision", &precision, "double\0float\0"))
+        {
+            m_Config.precision = static_cast<Precision>(precision);
+            m_NeedsUpdate = true;
+        }
+        m_NeedsUpdate |= ImGui::Checkbox("Compare precisions", &m_Config.comparePrecision);
+
         m_Config.sampleRate = std::max(1, m_Config.sampleRate);
         m_Config.gamma = std::min(1.0f, m_Config.gamma);
         if (m_Config.gamma < 0.0f) m_Config.gamma = 0.0f;
+        m_Config.threshold = std::max(0.0f, m_Config.threshold);
         m_Config.pointCount = std::max(1024, m_Config.pointCount);
         m_Config.noiseAlpha = std::max(0.0f, m_Config.noiseAlpha);
+        m_Config.channels = std::clamp(m_Config.channels, 1, 256);
+        m_Config.displayChannel = std::clamp(m_Config.displayChannel, 0, m_Config.channels - 1);
+        const float nyquist = 0.5f * float(m_Config.sampleRate);
+        m_Config.firHigh = std::clamp(m_Config.firHigh, 0.0f, nyquist);
+        m_Config.firLow = std::clamp(m_Config.firLow, 0.0f, m_Config.firHigh);
+        m_Config.firTaps = std::clamp(m_Config.firTaps, 1, 1 << 16);
+
+        ImGui::Separator();
 
-        m_Config.pointCount = (oldPointCount < m_Config.pointCount) ? oldPointCount << 1
-            : (oldPointCount > m_Config.pointCount) ? oldPointCount >> 1
-            : oldPointCount;
+        ImGui::Text("Delta: %.2f", m_Snapshot->delta);
+        if (m_Snapshot->config.channels > 1)
+        {
+            ImGui::SameLine();
+            ImGui::TextDisabled("(mean of %d; channel %d: %.2f)", m_Snapshot->config.channels,
+                                m_Snapshot->config.displayChannel, m_Snapshot->channelDelta);
+        }
+        if (m_Worker.IsBusy())
+        {
+            ImGui::SameLine();
+            ImGui::TextDisabled("(computing...)");
+        }
+        if (m_Snapshot->config.clean == CleanSource::Fir)
+        {
+            ImGui::Text("Delta (FIR): %.4g", m_Snapshot->firDelta);
+            ImGui::Text("Delta (%s): %.4g", to_string(m_Snapshot->config.filter), m_Snapshot->spectralDelta);
+        }
+        if (m_Snapshot->config.comparePrecision)
+        {
+            // The difference is far below the displayed precision of Delta.
+            Precision other = m_Snapshot->config.precision == Precision::Float ? Precision::Double
+                                                                               : Precision::Float;
+            ImGui::Text("Delta (%s): %.9g", to_string(m_Snapshot->config.precision), m_Snapshot->delta);
+            ImGui::Text("Delta (%s): %.9g", to_string(other), m_Snapshot->comparedDelta);
+            ImGui::Text("Difference: %.3g", m_Snapshot->delta - m_Snapshot->comparedDelta);
+        }
 
         ImGui::Separator();
+        RenderSweepControls();
+        RenderLiveControls();
+        RenderProfiler();
+
+        ImGui::End();
+    }
+}
+
+void App::RenderProfiler()
+{
+    if (!ImGui::CollapsingHeader("Profiling")) return;
+
+    Profiler& profiler = Profiler::Get();
+    bool enabled = profiler.IsEnabled();
+    if (ImGui::Checkbox("Stage timers", &enabled)) profiler.SetEnabled(enabled);
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Reset")) profiler.ResetStats();
+
+    ImGui::InputText("Trace file", m_TracePath, sizeof(m_TracePath));
+    if (!profiler.IsTracing())
+    {
+        if (ImGui::Button("Start trace"))
+        {
+            profiler.BeginTrace();
+            m_TraceStatus = "Recording...";
+        }
+    }
+    else if (ImGui::Button("Stop and save trace"))
+    {
+        m_TraceStatus = profiler.EndTrace(m_TracePath) ? std::string("Saved ") + m_TracePath
+                                                       : std::string("Cannot write ") + m_TracePath;
+    }
+    if (!m_TraceStatus.empty())
+    {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s", m_TraceStatus.c_str());
+    }
+
+    // Rolling window of the last Profiler::kWindow runs per stage.
+    auto stats = profiler.GetStats();
+    if (!stats.empty() && ImGui::BeginTable("Stage timings", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+    {
+        ImGui::TableSetupColumn("Stage");
+        ImGui::TableSetupColumn("min, ms");
+        ImGui::TableSetupColumn("mean, ms");
+        ImGui::TableSetupColumn("p99, ms");
+        ImGui::TableHeadersRow();
+        for (const auto& s : stats)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(s.name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", s.minMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", s.meanMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", s.p99Ms);
+        }
+        ImGui::EndTable();
+    }
+}
+
+void App::RenderSweepControls()
+{
+    ReceiveSweep();
+    if (!ImGui::CollapsingHeader("Parameter sweep")) return;
+
+    bool cutoff = m_Config.filter == FilterKind::EnergyCutoff;
+    ImGui::InputFloat2(cutoff ? "Gamma range" : "Threshold range", m_SweepParamRange, "%.2f");
+    ImGui::InputInt("Steps##param", &m_SweepParamSteps);
+    ImGui::InputFloat2("Noise alpha range", m_SweepAlphaRange, "%.2f");
+    ImGui::InputInt("Steps##alpha", &m_SweepAlphaSteps);
+    ImGui::InputInt("Seeds", &m_SweepSeeds);
+    m_SweepParamSteps = std::clamp(m_SweepParamSteps, 1, 1000);
+    m_SweepAlphaSteps = std::clamp(m_SweepAlphaSteps, 1, 1000);
+    m_SweepSeeds = std::clamp(m_SweepSeeds, 1, 1000);
+
+    if (const char* reason = ParameterSweep::Unsupported(m_Config))
+    {
+        ImGui::TextDisabled("(cannot sweep: %s)", reason);
+    }
+    else if (!m_SweepJob.valid())
+    {
+        if (ImGui::Button("Run sweep")) StartSweep();
+    }
+    else
+    {
+        if (ImGui::Button("Cancel sweep")) m_SweepCancel = true;
+        ImGui::SameLine();
+        ImGui::TextDisabled("(sweeping...)");
+    }
+    if (m_Sweep)
+    {
+        ImGui::SameLine();
+        ImGui::Checkbox("Show result", &m_ShowSweep);
+    }
+}
+
+void App::StartSweep()
+{
+    // Seeds follow the configured one, so the first matches the plots.
+    ParameterSweep::Grid grid;
+    grid.params = ParameterSweep::Linspace(m_SweepParamRange[0], m_SweepParamRange[1], m_SweepParamSteps);
+    grid.noiseAlphas = ParameterSweep::Linspace(m_SweepAlphaRange[0], m_SweepAlphaRange[1], m_SweepAlphaSteps);
+    for (int s = 0; s < m_SweepSeeds; ++s) grid.seeds.push_back(m_Config.seed + s);
+
+    m_SweepCancel = false;
+    m_SweepJob = std::async(std::launch::async, [this, cfg = m_Config, grid = std::move(grid)]
+    {
+        auto sweep = std::make_unique<ParameterSweep>();
+        if (!sweep->Run(cfg, grid, &m_SweepCancel)) sweep.reset();
+        return sweep;
+    });
+}
+
+void App::ReceiveSweep()
+{
+    if (!m_SweepJob.valid() || m_SweepJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        return;
+    }
+    auto sweep = m_SweepJob.get();
+    // A cancelled sweep keeps the previous result.
+    if (!sweep) return;
+
+    const auto& grid = sweep->GetGrid();
+    size_t params = grid.params.size(), alphas = grid.noiseAlphas.size();
+    m_SweepParams.assign(grid.params.begin(), grid.params.end());
+    m_SweepMean.resize(params);
+    m_SweepMin.resize(params);
+    m_SweepMax.resize(params);
+    for (size_t p = 0; p < params; ++p)
+    {
+        m_SweepMean[p] = sweep->At(0, p).meanDelta;
+        m_SweepMin[p] = sweep->At(0, p).minDelta;
+        m_SweepMax[p] = sweep->At(0, p).maxDelta;
+    }
+    m_SweepHeatmap.resize(alphas * params);
+    for (size_t a = 0; a < alphas; ++a)
+    {
+        for (size_t p = 0; p < params; ++p)
+        {
+            m_SweepHeatmap[(alphas - 1 - a) * params + p] = sweep->At(a, p).meanDelta;
+        }
+    }
+
+    m_Sweep = std::move(sweep);
+    m_ShowSweep = true;
+}
 
-        ImGui::Text("Delta: %.2f", m_Processor.GetDelta());
+void App::RenderSweepPlot()
+{
+    if (!m_Sweep || !m_ShowSweep) return;
 
+    ImGuiViewport* viewport = ImGui::GetMainViewport();
+    ImGui::SetNextWindowPos(ImVec2(viewport->WorkPos.x + 450, viewport->WorkPos.y + 50), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(640, 420), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Sweep result", &m_ShowSweep))
+    {
         ImGui::End();
+        return;
+    }
+
+    const auto& grid = m_Sweep->GetGrid();
+    const char* paramName = m_Sweep->GetFilter() == FilterKind::EnergyCutoff ? "gamma" : "threshold";
+    int params = int(grid.params.size()), alphas = int(grid.noiseAlphas.size());
+
+    auto best = std::min_element(m_Sweep->GetPoints().begin(), m_Sweep->GetPoints().end(),
+                                 [](const auto& a, const auto& b) { return a.meanDelta < b.meanDelta; });
+    ImGui::Text("%s, %zu seeds. Lowest Delta %.4g at %s = %.3g, noise alpha = %.3g",
+                to_string(m_Sweep->GetFilter()), grid.seeds.size(), best->meanDelta, paramName,
+                best->param, best->noiseAlpha);
+
+    if (alphas == 1)
+    {
+        // Error curve; the band is the spread over the seeds.
+        if (ImPlot::BeginPlot("##Sweep curve", ImVec2(-1, -1)))
+        {
+            ImPlot::SetupAxes(paramName, "Delta", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            ImPlot::PlotShaded("min .. max", m_SweepParams.data(), m_SweepMin.data(), m_SweepMax.data(), params);
+            ImPlot::PlotLine("mean", m_SweepParams.data(), m_SweepMean.data(), params);
+            ImPlot::EndPlot();
+        }
+    }
+    else
+    {
+        auto [lo, hi] = std::minmax_element(m_SweepHeatmap.begin(), m_SweepHeatmap.end());
+        // Cells are centered on the grid values.
+        double dp = params > 1 ? (grid.params.back() - grid.params.front()) / (params - 1) : 1.0;
+        double da = (grid.noiseAlphas.back() - grid.noiseAlphas.front()) / (alphas - 1);
+        if (dp == 0) dp = 1;
+        if (da == 0) da = 1;
+        ImPlotPoint boundsMin(grid.params.front() - dp / 2, grid.noiseAlphas.front() - da / 2);
+        ImPlotPoint boundsMax(grid.params.back() + dp / 2, grid.noiseAlphas.back() + da / 2);
+
+        ImPlot::PushColormap(ImPlotColormap_Viridis);
+        if (ImPlot::BeginPlot("##Sweep heatmap", ImVec2(ImGui::GetContentRegionAvail().x - 90, -1)))
+        {
+            ImPlot::SetupAxes(paramName, "noise alpha", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            ImPlot::PlotHeatmap("Delta", m_SweepHeatmap.data(), alphas, params, *lo, *hi, nullptr,
+                                boundsMin, boundsMax);
+            ImPlot::EndPlot();
+        }
+        ImGui::SameLine();
+        ImPlot::ColormapScale("Delta", *lo, *hi, ImVec2(80, -1));
+        ImPlot::PopColormap();
     }
+
+    ImGui::End();
 }
 
-void App::RenderPlots()
+void App::RenderLiveControls()
 {
+    if (m_Live) m_LiveSnapshot = m_Live->Latest();
+    if (!ImGui::CollapsingHeader("Live monitor")) return;
+
+    // Settings apply on the next start.
+    ImGui::InputInt("Feed rate, Hz", &m_LiveSampleRate, 1000, 10000);
+    ImGui::SliderInt("Ring", &m_LiveRingLog2, 10, 24, "2^%d samples");
+    ImGui::SliderInt("Frame", &m_LiveFrameLog2, 6, 16, "2^%d samples");
+    ImGui::SliderInt("Tone window", &m_LiveToneLog2, 8, 20, "2^%d samples");
+    ImGui::Checkbox("Paced", &m_LivePaced);
+    ImGui::SameLine();
+    ImGui::TextDisabled("(unpaced: as fast as the filter reads)");
+    m_LiveSampleRate = std::clamp(m_LiveSampleRate, 1, 10000000);
+
+    if (!m_Live)
+    {
+        if (ImGui::Button("Start feed")) StartLive();
+    }
+    else
+    {
+        if (ImGui::Button("Stop feed"))
+        {
+            m_LiveFeed.reset();
+            m_Live.reset();
+        }
+        ImGui::SameLine();
+        ImGui::Checkbox("Show plot", &m_ShowLive);
+        ImGui::SameLine();
+        ImGui::Checkbox("Spectrogram", &m_ShowSpectrogram);
+
+        // Both apply to the rows kept so far, which are fetched again.
+        bool recolor = ImGui::RadioButton("Input", !m_SpectrogramClean) && m_SpectrogramClean;
+        ImGui::SameLine();
+        recolor |= ImGui::RadioButton("Clean", m_SpectrogramClean) && !m_SpectrogramClean;
+        if (recolor) m_SpectrogramClean = !m_SpectrogramClean;
+        recolor |= ImGui::DragFloatRange2("Levels, dB", &m_Waterfall.minDb, &m_Waterfall.maxDb, 1, -200, 50);
+        if (recolor) m_Waterfall.frames = 0;
+    }
+    if (!m_LiveError.empty()) ImGui::TextDisabled("%s", m_LiveError.c_str());
+
+    if (m_LiveSnapshot)
+    {
+        const LiveSnapshot& s = *m_LiveSnapshot;
+        ImGui::Text("Throughput: %.3g samples/s", s.samplesPerSecond);
+        ImGui::Text("Consumed: %llu, filtered: %llu", (unsigned long long)s.consumed,
+                    (unsigned long long)s.filtered);
+        ImGui::Text("Ring: %zu / %zu", s.ringFill, s.ringCapacity);
+        ImGui::Text("Overruns: %llu samples dropped", (unsigned long long)s.overruns);
+        ImGui::Text("Underruns: %llu late feeds", (unsigned long long)s.underruns);
+
+        // Sliding DFT of the input at the harmonic frequencies.
+        if (!s.tones.empty() &&
+            ImGui::BeginTable("Live tones", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+        {
+            ImGui::TableSetupColumn("f, Hz");
+            ImGui::TableSetupColumn("Ampl");
+            ImGui::TableSetupColumn("Phase");
+            ImGui::TableHeadersRow();
+            for (const auto& tone : s.tones)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%.6g", tone.frequency);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.4f", tone.amplitude);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.4f", tone.phase);
+            }
+            ImGui::EndTable();
+        }
+        if (!s.tones.empty() && !s.tonesSettled) ImGui::TextDisabled("(tone window still filling)");
+    }
+}
+
+void App::StartLive()
+{
+    LiveMonitor::Config cfg;
+    cfg.ringCapacity = size_t(1) << m_LiveRingLog2;
+    cfg.sampleRate = m_LiveSampleRate;
+    cfg.filter.frameSize = 1 << m_LiveFrameLog2;
+    cfg.filter.hopSize = cfg.filter.frameSize / 2;
+    cfg.filter.filter = m_Config.filter;
+    cfg.filter.gamma = m_Config.gamma;
+    cfg.filter.threshold = m_Config.threshold;
+    for (const auto& h : m_Config.harmonics) cfg.tones.push_back(h.frequency);
+    cfg.toneWindow = size_t(1) << m_LiveToneLog2;
+
+    SampleFeed::Config feedCfg;
+    feedCfg.sampleRate = m_LiveSampleRate;
+    feedCfg.paced = m_LivePaced;
+    // Slow feeds deliver blocks further apart than the default allows.
+    cfg.lateSeconds = std::max(cfg.lateSeconds, 2.0 * double(feedCfg.blockSize) / m_LiveSampleRate);
+    auto source = std::make_shared<SyntheticSignal>(m_LiveSampleRate, m_Config.harmonics, m_Config.noiseAlpha,
+                                                    m_Config.seed);
+    try
+    {
+        m_Live = std::make_unique<LiveMonitor>(cfg);
+        m_LiveFeed = std::make_unique<SampleFeed>(feedCfg, source, m_Live->Input());
+        m_LiveError.clear();
+        m_ShowLive = true;
+        m_Waterfall.Release();
+    }
+    catch (const std::exception& e)
+    {
+        m_LiveFeed.reset();
+        m_Live.reset();
+        m_LiveError = e.what();
+    }
+}
+
+void App::RenderLivePlot()
+{
+    if (!m_Live || !m_ShowLive || !m_LiveSnapshot) return;
+
     ImGuiViewport* viewport = ImGui::GetMainViewport();
+    ImGui::SetNextWindowPos(ImVec2(viewport->WorkPos.x + 500, viewport->WorkPos.y + 100), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(640, 360), ImGuiCond_FirstUseEver);
+    if (ImGui::Begin("Live feed", &m_ShowLive))
+    {
+        // A few thousand points; plotted as they are, without decimation.
+        const LiveSnapshot& s = *m_LiveSnapshot;
+        int count = int(s.time.size());
+        if (ImPlot::BeginPlot("##Live", ImVec2(-1, -1)))
+        {
+            ImPlot::SetupAxes("t, sec", "x", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            ImPlot::PlotLine("input", s.time.data(), s.input.data(), count);
+            ImPlot::PlotLine("clean", s.time.data(), s.clean.data(), count);
+            ImPlot::EndPlot();
+        }
+    }
+    ImGui::End();
+}
 
-    int timeCount = m_Processor.GetTime().size();
-    const double* timeData = m_Processor.GetTime().data();
-    const double* cleanSignalData = m_Processor.GetCleanSignal().data();
+void App::RenderSpectrogram()
+{
+    if (!m_Live || !m_ShowSpectrogram) return;
 
-    bool showNoise = m_Processor.IsShowNoise();
-    const double* inputSignalData = showNoise? m_Processor.GetInputSignal().data() :
-                                               m_Processor.GetIdealSignal().data();
+    const LiveMonitor::Config& cfg = m_Live->GetConfig();
+    const int bins = int(m_Live->SpectrogramBins()), rows = int(cfg.spectrogram.rows);
+    if (m_Waterfall.texture == 0 || m_Waterfall.bins != bins || m_Waterfall.rows != rows)
+    {
+        m_Waterfall.Reset(bins, rows);
+    }
+    {
+        PROFILE_SCOPE("Spectrogram: upload");
+        m_WaterfallLevels.resize(size_t(bins) * rows);
+        auto fresh = m_Live->CopySpectrogram(m_SpectrogramClean, m_Waterfall.frames, m_WaterfallLevels.data(), rows);
+        m_Waterfall.Upload(fresh.first, m_WaterfallLevels.data(), fresh.count);
+    }
 
+    ImGuiViewport* viewport = ImGui::GetMainViewport();
+    ImGui::SetNextWindowPos(ImVec2(viewport->WorkPos.x + 540, viewport->WorkPos.y + 140), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(640, 480), ImGuiCond_FirstUseEver);
+    if (ImGui::Begin(m_SpectrogramClean ? "Spectrogram (clean)###Spectrogram" : "Spectrogram (input)###Spectrogram",
+                     &m_ShowSpectrogram))
+    {
+        WaterfallRenderer("##Spectrogram", m_Waterfall, double(cfg.spectrogram.hopSize) / cfg.sampleRate,
+                          double(cfg.sampleRate) / cfg.spectrogram.frameSize);
+    }
+    ImGui::End();
+}
 
-    int frequenciesCount = m_Processor.GetTime().size();
-    const double* frequenciesData = m_Processor.GetFrequencies().data();
-    const double* inputSpectrumData = m_Processor.GetInputSpectrum().data();
-    const double* cleanSpectrumData = m_Processor.GetCleanSpectrum().data();
+void App::RenderPlots()
+{
+    ImGuiViewport* viewport = ImGui::GetMainViewport();
+
+    const SignalSnapshot& snapshot = *m_Snapshot;
+
+    // The pyramids reference the snapshot's arrays, which m_Snapshot keeps
+    // alive until the next generation replaces them here.
+    bool newData = snapshot.generation != m_PlottedGeneration;
+    if (newData)
+    {
+        PROFILE_SCOPE("Plots: decimate");
+        size_t timeCount = snapshot.time.size();
+        const double* timeData = snapshot.time.data();
+        m_CleanPlot.Set(timeData, snapshot.cleanSignal.data(), timeCount);
+
+        // Spectra hold only the non-redundant half of the bins.
+        size_t frequenciesCount = snapshot.frequencies.size();
+        const double* frequenciesData = snapshot.frequencies.data();
+        m_InputSpectrumPlot.Set(frequenciesData, snapshot.inputSpectrum.data(), frequenciesCount);
+        m_CleanSpectrumPlot.Set(frequenciesData, snapshot.cleanSpectrum.data(), frequenciesCount);
+        m_PlottedGeneration = snapshot.generation;
+    }
+
+    // Display-only toggle: read from the live config, not the last result.
+    bool showNoise = m_Config.showNoise;
+    if (newData || showNoise != m_PlottedShowNoise)
+    {
+        m_InputPlot.Set(snapshot.time.data(),
+                        showNoise ? snapshot.inputSignal.data() : snapshot.idealSignal.data(),
+                        snapshot.time.size());
+        m_PlottedShowNoise = showNoise;
+    }
 
     ImGui::SetNextWindowPos(ImVec2(viewport->WorkPos.x + 400, viewport->WorkPos.y));
     ImGui::SetNextWindowSize(ImVec2(viewport->WorkSize.x - 400, viewport->WorkSize.y / 3));
-    PlotRenderer("Input signal", "t, sec", "x", timeData, inputSignalData, timeCount);
+    PlotRenderer("Input signal", "t, sec", "x", m_InputPlot);
 
     ImGui::SetNextWindowPos(ImVec2(viewport->WorkPos.x + 400, viewport->WorkPos.y + (1.0 / 3.0) * viewport->WorkSize.y));
     ImGui::SetNextWindowSize(ImVec2((viewport->WorkSize.x - 400) / 2, viewport->WorkSize.y / 3));
-    PlotRenderer("Spectrum signal (noise)", "f, Hz", "Ampl", frequenciesData, inputSpectrumData, frequenciesCount);
+    PlotRenderer("Spectrum signal (noise)", "f, Hz", "Ampl", m_InputSpectrumPlot);
 
     ImGui::SetNextWindowPos(ImVec2(viewport->WorkPos.x + 400 + (viewport->WorkSize.x - 400) / 2, viewport->WorkPos.y + (1.0 / 3.0) * viewport->WorkSize.y));
     ImGui::SetNextWindowSize(ImVec2((viewport->WorkSize.x - 400) / 2, viewport->WorkSize.y / 3));
-    PlotRenderer("Spectrum signal (clear)", "f, Hz", "Ampl", frequenciesData, cleanSpectrumData, frequenciesCount);
+    PlotRenderer("Spectrum signal (clear)", "f, Hz", "Ampl", m_CleanSpectrumPlot);
 
     ImGui::SetNextWindowPos(ImVec2(viewport->WorkPos.x + 400, viewport->WorkPos.y + (2.0 / 3.0) * viewport->WorkSize.y));
     ImGui::SetNextWindowSize(ImVec2(viewport->WorkSize.x - 400, viewport->WorkSize.y / 3));
-    PlotRenderer("Clear signal", "t, sec", "x", timeData, cleanSignalData, timeCount);
+    PlotRenderer("Clear signal", "t, sec", "x", m_CleanPlot);
 }
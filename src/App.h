@@ -6,8 +6,15 @@
 #include "imgui_impl_opengl3.h"
 #include <GLFW/glfw3.h>
 
-#include "SignalProcessor.h"
+#include <atomic>
+#include <future>
+#include <memory>
+
+#include "LiveMonitor.h"
+#include "ParameterSweep.h"
+#include "ProcessingWorker.h"
 #include "UI/SignalUI.h"
+#include "io/SampleFeed.h"
 
 class App
 {
@@ -19,9 +26,64 @@ public:
 private:
     void RenderControlPanel();
     void RenderPlots();
+    void RenderProfiler();
+    void RenderSweepControls();
+    void RenderSweepPlot();
+    void StartSweep();
+    void ReceiveSweep();
+    void RenderLiveControls();
+    void RenderLivePlot();
+    void RenderSpectrogram();
+    void StartLive();
 
     GLFWwindow* m_Window;
-    SignalProcessor m_Processor;
+    ProcessingWorker m_Worker;
+    // Result drawn this frame; swapped for the worker's latest each frame.
+    std::shared_ptr<const SignalSnapshot> m_Snapshot;
+    // Decimated plots of m_Snapshot, rebuilt when the snapshot or the
+    // noise toggle changes.
+    PlotSeries m_InputPlot, m_InputSpectrumPlot, m_CleanSpectrumPlot, m_CleanPlot;
+    uint64_t m_PlottedGeneration = 0;
+    bool m_PlottedShowNoise = false;
     SignalProcessor::Config m_Config;
     bool m_NeedsUpdate = true;
+
+    char m_TracePath[256] = "signalfilter_trace.json";
+    std::string m_TraceStatus;
+
+    // Parameter sweep of the current config, run off the UI thread.
+    float m_SweepParamRange[2] = { 0.5f, 1.0f };
+    int m_SweepParamSteps = 21;
+    float m_SweepAlphaRange[2] = { 0.1f, 1.0f };
+    int m_SweepAlphaSteps = 1;
+    int m_SweepSeeds = 4;
+    std::atomic<bool> m_SweepCancel{ false };
+    std::future<std::unique_ptr<ParameterSweep>> m_SweepJob;
+    std::unique_ptr<ParameterSweep> m_Sweep;
+    bool m_ShowSweep = false;
+    // Plot arrays of m_Sweep: the curve of the first noiseAlpha and the
+    // mean Delta heatmap with the highest noiseAlpha in the top row.
+    std::vector<double> m_SweepParams, m_SweepMean, m_SweepMin, m_SweepMax;
+    std::vector<double> m_SweepHeatmap;
+
+    // Synthetic live feed of the current harmonics through the ring, a
+    // streaming filter and a tracker of the harmonic frequencies. The feed
+    // is declared after the monitor whose ring it writes to, so it is
+    // destroyed first.
+    int m_LiveSampleRate = 8000;
+    int m_LiveRingLog2 = 16;
+    int m_LiveFrameLog2 = 10;
+    int m_LiveToneLog2 = 13;
+    bool m_LivePaced = true;
+    std::unique_ptr<LiveMonitor> m_Live;
+    std::unique_ptr<SampleFeed> m_LiveFeed;
+    std::shared_ptr<const LiveSnapshot> m_LiveSnapshot;
+    std::string m_LiveError;
+    bool m_ShowLive = false;
+    // Spectrogram of the live input or clean output; each frame uploads
+    // only the rows that were finished since the last one.
+    Waterfall m_Waterfall;
+    std::vector<float> m_WaterfallLevels;
+    bool m_ShowSpectrogram = false;
+    bool m_SpectrogramClean = false;
 };
\ No newline at end of file
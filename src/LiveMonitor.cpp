@@ -0,0 +1,187 @@
+#include "LiveMonitor.h"
+#include "util/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+void LiveMonitor::History::Append(const double* samples, size_t count)
+{
+    const size_t capacity = data.size();
+    // Only the newest capacity samples can survive.
+    if (count > capacity)
+    {
+        end += count - capacity;
+        samples += count - capacity;
+        count = capacity;
+    }
+    for (size_t i = 0; i < count; ++i) data[(end + i) % capacity] = samples[i];
+    end += count;
+}
+
+void LiveMonitor::History::Copy(uint64_t first, size_t count, double* out) const
+{
+    for (size_t i = 0; i < count; ++i) out[i] = data[(first + i) % data.size()];
+}
+
+LiveMonitor::LiveMonitor(const Config& cfg)
+    : m_Config(cfg),
+      m_Ring(cfg.ringCapacity),
+      m_Filter(cfg.filter),
+      m_Tracker({ cfg.sampleRate, cfg.tones, cfg.toneWindow, ToneTracker::Window::Hann }),
+      m_InputSpectrogram(cfg.spectrogram),
+      m_CleanSpectrogram(cfg.spectrogram),
+      m_Front(std::make_shared<LiveSnapshot>()),
+      m_Back(std::make_shared<LiveSnapshot>())
+{
+    m_Config.history = std::max<size_t>(1, m_Config.history);
+    m_Config.sampleRate = std::max(1, m_Config.sampleRate);
+    // The input lags the output by up to the filter's latency plus its
+    // output queue, which holds frameSize + hopSize samples.
+    m_Input.data.resize(m_Config.history + 2 * m_Filter.Latency() + m_Config.filter.hopSize);
+    m_Clean.data.resize(m_Config.history);
+    m_Pulled.resize(m_Filter.Latency() + m_Config.filter.hopSize);
+    m_Front->ringCapacity = m_Ring.Capacity();
+    for (LiveSnapshot* s : { m_Front.get(), m_Back.get() })
+    {
+        s->time.reserve(m_Config.history);
+        s->input.reserve(m_Config.history);
+        s->clean.reserve(m_Config.history);
+        s->tones.reserve(m_Tracker.Tones());
+    }
+
+    m_Thread = std::jthread([this](std::stop_token stop) { Run(stop); });
+}
+
+LiveMonitor::~LiveMonitor()
+{
+    m_Thread.request_stop();
+}
+
+std::shared_ptr<const LiveSnapshot> LiveMonitor::Latest() const
+{
+    std::lock_guard lock(m_Mutex);
+    return m_Front;
+}
+
+LiveMonitor::SpectrogramRows LiveMonitor::CopySpectrogram(bool clean, uint64_t next, float* out,
+                                                           size_t maxRows) const
+{
+    std::lock_guard lock(m_SpectrogramMutex);
+    const Spectrogram& spectrogram = clean ? m_CleanSpectrogram : m_InputSpectrogram;
+    SpectrogramRows rows;
+    rows.first = std::clamp(next, spectrogram.FirstRetained(), spectrogram.Frames());
+    rows.count = size_t(std::min<uint64_t>(maxRows, spectrogram.Frames() - rows.first));
+    for (size_t i = 0; i < rows.count; ++i)
+    {
+        std::copy_n(spectrogram.Row(rows.first + i), spectrogram.Bins(), out + i * spectrogram.Bins());
+    }
+    return rows;
+}
+
+void LiveMonitor::Run(std::stop_token stop)
+{
+    using Clock = std::chrono::steady_clock;
+    auto lastPublish = Clock::now();
+
+    while (!stop.stop_requested())
+    {
+        auto block = m_Ring.Peek();
+        if (block.size > 0)
+        {
+            // The filter reads straight out of the ring's storage.
+            size_t taken = m_Filter.Push(block.data, block.size);
+            m_Tracker.Process(block.data, taken);
+            {
+                std::lock_guard lock(m_SpectrogramMutex);
+                m_InputSpectrogram.Push(block.data, taken);
+            }
+            m_Input.Append(block.data, taken);
+            m_Ring.Consume(taken);
+            m_Consumed.fetch_add(taken, std::memory_order_relaxed);
+
+            while (size_t n = m_Filter.Pull(m_Pulled.data(), m_Pulled.size()))
+            {
+                m_Clean.Append(m_Pulled.data(), n);
+                std::lock_guard lock(m_SpectrogramMutex);
+                m_CleanSpectrogram.Push(m_Pulled.data(), n);
+            }
+        }
+
+        auto now = Clock::now();
+        CheckSchedule(block.size > 0, now);
+        double elapsed = std::chrono::duration<double>(now - lastPublish).count();
+        if (elapsed >= m_Config.publishSeconds)
+        {
+            Publish(elapsed);
+            lastPublish = now;
+        }
+        // Wait for the producer rather than spin on an empty ring.
+        if (block.size == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void LiveMonitor::CheckSchedule(bool received, std::chrono::steady_clock::time_point now)
+{
+    // Dropped samples did arrive on time, so they count as delivered.
+    const uint64_t delivered = m_Consumed.load(std::memory_order_relaxed) + m_Ring.Overruns();
+    if (received)
+    {
+        // The schedule starts at the first arrival and again after each
+        // underrun, so one stall is not held against the samples after it.
+        if (!m_Scheduled || m_Late)
+        {
+            m_ScheduleStart = now;
+            m_ScheduleBase = delivered;
+            m_Scheduled = true;
+            m_Late = false;
+        }
+        return;
+    }
+    if (!m_Scheduled || m_Late) return;
+
+    const double due = std::chrono::duration<double>(now - m_ScheduleStart).count() * m_Config.sampleRate;
+    if (due - double(delivered - m_ScheduleBase) > m_Config.lateSeconds * m_Config.sampleRate)
+    {
+        m_Ring.CountUnderrun();
+        m_Late = true;
+    }
+}
+
+void LiveMonitor::Publish(double seconds)
+{
+    PROFILE_SCOPE("Live publish");
+
+    if (m_Back.use_count() > 1)
+    {
+        m_Back = std::make_shared<LiveSnapshot>();
+    }
+
+    LiveSnapshot& s = *m_Back;
+    const uint64_t consumed = m_Consumed.load(std::memory_order_relaxed);
+    const uint64_t end = m_Clean.end;
+    const size_t count = size_t(std::min<uint64_t>(end, m_Config.history));
+    const uint64_t first = end - count;
+
+    s.time.resize(count);
+    s.input.resize(count);
+    s.clean.resize(count);
+    for (size_t i = 0; i < count; ++i) s.time[i] = double(first + i) / m_Config.sampleRate;
+    m_Input.Copy(first, count, s.input.data());
+    m_Clean.Copy(first, count, s.clean.data());
+    s.tones.resize(m_Tracker.Tones());
+    m_Tracker.Estimates(s.tones.data());
+    s.tonesSettled = m_Tracker.IsSettled();
+
+    s.consumed = consumed;
+    s.filtered = end;
+    s.overruns = m_Ring.Overruns();
+    s.underruns = m_Ring.Underruns();
+    s.ringFill = m_Ring.Size();
+    s.ringCapacity = m_Ring.Capacity();
+    s.samplesPerSecond = double(consumed - m_LastPublished) / seconds;
+    s.generation = ++m_Generation;
+    m_LastPublished = consumed;
+
+    std::lock_guard lock(m_Mutex);
+    std::swap(m_Front, m_Back);
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Spectrogram.h"
+#include "StreamingFilter.h"
+#include "math/tone_tracker.h"
+#include "util/SpscRing.h"
+
+// What the UI draws of a live feed: the last history samples of input and
+// filtered output, aligned by sample index, the tracked tones and the
+// ingestion counters.
+struct LiveSnapshot
+{
+    std::vector<double> time, input, clean;
+    // Over the last toneWindow input samples up to `consumed`.
+    std::vector<ToneEstimate> tones;
+    bool tonesSettled = false;
+    // Samples taken from the ring and samples filtered so far.
+    uint64_t consumed = 0, filtered = 0;
+    // Samples the ring dropped, and times the feed fell behind its rate.
+    uint64_t overruns = 0, underruns = 0;
+    size_t ringFill = 0, ringCapacity = 0;
+    // Consumer throughput over the last publish interval.
+    double samplesPerSecond = 0;
+    uint64_t generation = 0;
+};
+
+// Thread-safe input path for live samples. Any single producer thread
+// writes into Input(); a consumer thread reads the ring in place, without
+// copying, through a StreamingFilter and a ToneTracker and publishes
+// double-buffered snapshots in the manner of ProcessingWorker. It also
+// keeps spectrograms of the input and the filtered output, whose rows are
+// copied out incrementally rather than snapshotted.
+class LiveMonitor
+{
+public:
+    struct Config
+    {
+        size_t ringCapacity = size_t(1) << 16;
+        int sampleRate = 48000;
+        StreamingFilter::Config filter;
+        size_t history = size_t(1) << 13;
+        // Frequencies in Hz whose amplitude and phase are tracked on the
+        // raw input, with a Hann window of toneWindow samples.
+        std::vector<double> tones;
+        size_t toneWindow = size_t(1) << 13;
+        Spectrogram::Config spectrogram;
+        // Minimum time between snapshots.
+        double publishSeconds = 1.0 / 30;
+        // An empty ring counts one underrun when the samples taken, plus
+        // those dropped, fall this far behind sampleRate since the first
+        // one arrived. A paced producer delivers whole blocks, so this
+        // must exceed its block period.
+        double lateSeconds = 0.05;
+    };
+
+    explicit LiveMonitor(const Config& cfg);
+    ~LiveMonitor();
+
+    LiveMonitor(const LiveMonitor&) = delete;
+    LiveMonitor& operator=(const LiveMonitor&) = delete;
+
+    const Config& GetConfig() const { return m_Config; }
+
+    // Producer end of the ring.
+    SpscRing<double>& Input() { return m_Ring; }
+
+    std::shared_ptr<const LiveSnapshot> Latest() const;
+
+    struct SpectrogramRows
+    {
+        uint64_t first = 0;
+        size_t count = 0;
+    };
+    // Copies rows of the input or clean spectrogram, from frame `next` on
+    // or the oldest one still kept, at most maxRows rows of
+    // SpectrogramBins() levels, into out. first + count is the frame to
+    // ask for next time, so a reader only copies what it has not seen.
+    SpectrogramRows CopySpectrogram(bool clean, uint64_t next, float* out, size_t maxRows) const;
+    size_t SpectrogramBins() const { return m_InputSpectrogram.Bins(); }
+    uint64_t Consumed() const { return m_Consumed.load(std::memory_order_relaxed); }
+
+private:
+    // Last `capacity` samples of an unbounded stream.
+    struct History
+    {
+        std::vector<double> data;
+        uint64_t end = 0;
+
+        void Append(const double* samples, size_t count);
+        // Samples [first, first + count), all of which must be retained.
+        void Copy(uint64_t first, size_t count, double* out) const;
+    };
+
+    void Run(std::stop_token stop);
+    // Counts an underrun when the ring is empty after samples were due.
+    void CheckSchedule(bool received, std::chrono::steady_clock::time_point now);
+    void Publish(double seconds);
+
+    Config m_Config;
+    SpscRing<double> m_Ring;
+    StreamingFilter m_Filter;
+    ToneTracker m_Tracker;
+    History m_Input, m_Clean;
+    // Written by the consumer thread frame by frame, read by CopySpectrogram.
+    mutable std::mutex m_SpectrogramMutex;
+    Spectrogram m_InputSpectrogram, m_CleanSpectrogram;
+    std::vector<double> m_Pulled;
+    std::atomic<uint64_t> m_Consumed{ 0 };
+    uint64_t m_LastPublished = 0;
+    // Deadline tracking on the consumer thread: arrival time and count of
+    // the samples the schedule starts from, and whether the current empty
+    // spell already counted its underrun.
+    std::chrono::steady_clock::time_point m_ScheduleStart;
+    uint64_t m_ScheduleBase = 0;
+    bool m_Scheduled = false, m_Late = false;
+    uint64_t m_Generation = 0;
+
+    mutable std::mutex m_Mutex;
+    std::shared_ptr<LiveSnapshot> m_Front, m_Back;
+
+    std::jthread m_Thread;
+};
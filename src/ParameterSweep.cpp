@@ -0,0 +1,188 @@
+#include "ParameterSweep.h"
+#include "SpectrumFilter.h"
+#include "math/fft.h"
+#include "math/noise.h"
+#include "math/oscillator.h"
+#include "util/ParallelFor.h"
+#include "util/Profiler.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+// Weight of bin k in the energy of an n-point real signal: DC and (for
+// even n) Nyquist appear once, every other bin also stands for its
+// negative-frequency twin.
+double bin_weight(size_t k, size_t n)
+{
+    return (k == 0 || 2 * k == n) ? 1.0 : 2.0;
+}
+
+// The noise of one seed, shared by every noiseAlpha.
+struct NoiseInput
+{
+    std::vector<Complex> spectrum;
+    double energy = 0;
+};
+}
+
+std::vector<float> ParameterSweep::Linspace(float first, float last, size_t count)
+{
+    std::vector<float> values(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        values[i] = count > 1 ? first + (last - first) * float(i) / float(count - 1) : first;
+    }
+    return values;
+}
+
+const char* ParameterSweep::Unsupported(const SignalProcessor::Config& base)
+{
+    if (base.precision != Precision::Double) return "the sweep runs in double precision only";
+    if (base.clean != CleanSource::Spectral) return "the sweep models the spectral filter, not the FIR one";
+    if (base.channels > 1) return "the sweep models a single channel";
+    return nullptr;
+}
+
+bool ParameterSweep::Run(const SignalProcessor::Config& base, const Grid& grid, const std::atomic<bool>* cancel)
+{
+    PROFILE_SCOPE("Sweep");
+
+    if (const char* reason = Unsupported(base))
+    {
+        throw std::invalid_argument(std::string("ParameterSweep: ") + reason);
+    }
+
+    m_Grid = grid;
+    if (m_Grid.seeds.empty()) m_Grid.seeds.push_back(base.seed);
+    m_Filter = base.filter;
+    m_Points.clear();
+
+    const size_t n = size_t(std::max(1, base.pointCount));
+    const size_t seeds = m_Grid.seeds.size();
+    const size_t alphas = m_Grid.noiseAlphas.size();
+    const size_t params = m_Grid.params.size();
+    const RealFftPlan& plan = get_real_fft_plan(n);
+    const size_t bins = plan.Bins();
+
+    // The ideal signal exactly as SignalProcessor synthesizes it.
+    std::vector<double> ideal(n);
+    std::vector<Sinusoid> tones;
+    double dt = 1.0 / base.sampleRate;
+    for (const auto& h : base.harmonics)
+    {
+        tones.push_back({ h.amplitude, 2 * PI * h.frequency * dt, h.phase });
+    }
+    synthesize_sinusoids(tones.data(), tones.size(), ideal.data(), n);
+
+    double signalEnergy = 0;
+    for (double x : ideal) signalEnergy += x * x;
+
+    std::vector<Complex> signalSpectrum(bins);
+    plan.Forward(ideal.data(), signalSpectrum.data());
+    double spectralEnergy = 0;
+    for (size_t k = 0; k < bins; ++k)
+    {
+        spectralEnergy += bin_weight(k, n) * std::norm(signalSpectrum[k]);
+    }
+
+    auto filterParams = [&](size_t p)
+    {
+        FilterParams fp{ base.gamma, base.threshold };
+        if (m_Filter == FilterKind::EnergyCutoff) fp.gamma = m_Grid.params[p];
+        else fp.threshold = m_Grid.params[p];
+        return fp;
+    };
+    auto cancelled = [cancel] { return cancel && cancel->load(std::memory_order_relaxed); };
+
+    // Delta of (seed, alpha, param) at ((seed * alphas) + alpha) * params + param.
+    std::vector<double> deltas(seeds * alphas * params);
+
+    // Seeds go in batches of one per thread, which bounds how many noise
+    // spectra are held at once; each (seed, alpha) of a batch is a task.
+    const size_t batch = std::max<size_t>(1, parallel_concurrency());
+    std::vector<NoiseInput> noise(std::min(batch, seeds));
+    for (size_t first = 0; first < seeds; first += batch)
+    {
+        const size_t count = std::min(batch, seeds - first);
+
+        parallel_for(0, count, 1, [&](size_t begin, size_t end)
+        {
+            std::vector<double> samples(n);
+            for (size_t s = begin; s < end && !cancelled(); ++s)
+            {
+                gaussian_noise(m_Grid.seeds[first + s], 0, samples.data(), n);
+                noise[s].energy = 0;
+                for (double x : samples) noise[s].energy += x * x;
+                noise[s].spectrum.resize(bins);
+                plan.Forward(samples.data(), noise[s].spectrum.data());
+            }
+        });
+
+        parallel_for(0, count * alphas, 1, [&](size_t begin, size_t end)
+        {
+            std::vector<Complex> mixed(bins), filtered(bins);
+            std::vector<double> amplitudes(bins);
+            auto filter = SpectrumFilter<double>::Create(m_Filter);
+
+            for (size_t task = begin; task < end && !cancelled(); ++task)
+            {
+                size_t s = task / alphas, a = task % alphas;
+                const NoiseInput& input = noise[s];
+
+                // Mixed and prepared as in SignalProcessor's Mix and
+                // Filter prepare stages.
+                double beta = std::sqrt(signalEnergy * m_Grid.noiseAlphas[a] / input.energy);
+                for (size_t k = 0; k < bins; ++k)
+                {
+                    mixed[k] = signalSpectrum[k] + input.spectrum[k] * beta;
+                }
+                amplitude_spectrum(mixed.data(), bins, n, amplitudes.data());
+                filter->Prepare(amplitudes.data(), bins, n);
+
+                double* out = &deltas[((first + s) * alphas + a) * params];
+                for (size_t p = 0; p < params; ++p)
+                {
+                    filtered.assign(mixed.begin(), mixed.end());
+                    filter->Apply(filtered.data(), amplitudes.data(), filterParams(p));
+
+                    double error = 0;
+                    for (size_t k = 0; k < bins; ++k)
+                    {
+                        error += bin_weight(k, n) * std::norm(filtered[k] - signalSpectrum[k]);
+                    }
+                    out[p] = error / spectralEnergy;
+                }
+            }
+        });
+
+        if (cancelled()) return false;
+    }
+
+    m_Points.resize(alphas * params);
+    for (size_t a = 0; a < alphas; ++a)
+    {
+        for (size_t p = 0; p < params; ++p)
+        {
+            Point& point = m_Points[a * params + p];
+            point.param = m_Grid.params[p];
+            point.noiseAlpha = m_Grid.noiseAlphas[a];
+            point.minDelta = std::numeric_limits<double>::infinity();
+            point.maxDelta = -std::numeric_limits<double>::infinity();
+
+            double sum = 0;
+            for (size_t s = 0; s < seeds; ++s)
+            {
+                double delta = deltas[(s * alphas + a) * params + p];
+                sum += delta;
+                point.minDelta = std::min(point.minDelta, delta);
+                point.maxDelta = std::max(point.maxDelta, delta);
+            }
+            point.meanDelta = sum / seeds;
+        }
+    }
+    return true;
+}
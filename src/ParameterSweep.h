@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "SignalProcessor.h"
+
+// Evaluates Delta over a grid of filter parameter and noiseAlpha values,
+// averaged over several noise seeds, for one SignalProcessor::Config.
+//
+// Work is shared along the grid: the ideal signal and its spectrum are
+// computed once, the noise spectrum once per seed and the mixed spectrum
+// and filter tables once per (seed, noiseAlpha). Each grid point then only
+// applies the filter and measures the error. Delta is taken from the
+// spectra by Parseval's theorem, which equals the time-domain Delta of
+// SignalProcessor without the inverse transform.
+//
+// Inputs are spread over parallel_for; results do not depend on the
+// number of threads.
+//
+// Only the double-precision spectral pipeline of one channel is modelled,
+// and the ideal signal is always synthesized from the harmonics, so a
+// SignalProcessor with an external signal is not reproduced.
+class ParameterSweep
+{
+public:
+    struct Grid
+    {
+        // Filter parameter: gamma for the energy cutoff, threshold for the
+        // other kernels.
+        std::vector<float> params;
+        std::vector<float> noiseAlphas;
+        // Noise seeds averaged per point; empty uses the config's seed.
+        std::vector<uint64_t> seeds;
+    };
+
+    struct Point
+    {
+        float param = 0, noiseAlpha = 0;
+        // Over the seeds.
+        double meanDelta = 0, minDelta = 0, maxDelta = 0;
+    };
+
+    // Evenly spaced values from first to last inclusive; one value when
+    // count is 1.
+    static std::vector<float> Linspace(float first, float last, size_t count);
+
+    // Why base cannot be swept, or null when it can: a float precision,
+    // the FIR clean source or more than one channel.
+    static const char* Unsupported(const SignalProcessor::Config& base);
+
+    // Runs the sweep for the signal, filter kind and sampling of base.
+    // Returns false if cancel was set by another thread; the table is then
+    // left empty. Throws std::invalid_argument for configs Unsupported
+    // rejects.
+    bool Run(const SignalProcessor::Config& base, const Grid& grid, const std::atomic<bool>* cancel = nullptr);
+
+    const Grid& GetGrid() const { return m_Grid; }
+    FilterKind GetFilter() const { return m_Filter; }
+    // One row per grid point, noiseAlphas outer and params inner.
+    const std::vector<Point>& GetPoints() const { return m_Points; }
+    const Point& At(size_t alphaIndex, size_t paramIndex) const
+    {
+        return m_Points[alphaIndex * m_Grid.params.size() + paramIndex];
+    }
+
+private:
+    Grid m_Grid;
+    FilterKind m_Filter = FilterKind::EnergyCutoff;
+    std::vector<Point> m_Points;
+};
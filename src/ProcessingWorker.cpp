@@ -0,0 +1,109 @@
+#include "ProcessingWorker.h"
+#include "util/Profiler.h"
+
+#include <algorithm>
+
+namespace
+{
+// Channel `channel` of `channels` equal-length channels stored back to back.
+void copy_channel(const std::vector<double>& all, size_t channel, size_t channels, std::vector<double>& out)
+{
+    size_t length = all.size() / channels;
+    out.assign(all.begin() + channel * length, all.begin() + (channel + 1) * length);
+}
+}
+
+ProcessingWorker::ProcessingWorker()
+    : m_Front(std::make_shared<SignalSnapshot>()),
+      m_Back(std::make_shared<SignalSnapshot>())
+{
+    // The processor computes its default config on construction.
+    Publish();
+    m_Thread = std::jthread([this](std::stop_token stop) { Run(stop); });
+}
+
+ProcessingWorker::~ProcessingWorker()
+{
+    m_Cancel = true;
+    m_Thread.request_stop();
+}
+
+void ProcessingWorker::Submit(const SignalProcessor::Config& cfg)
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Pending = cfg;
+        m_Cancel = true;
+        m_Busy = true;
+    }
+    m_Wake.notify_one();
+}
+
+std::shared_ptr<const SignalSnapshot> ProcessingWorker::Latest() const
+{
+    std::lock_guard lock(m_Mutex);
+    return m_Front;
+}
+
+void ProcessingWorker::Run(std::stop_token stop)
+{
+    while (true)
+    {
+        SignalProcessor::Config cfg;
+        {
+            std::unique_lock lock(m_Mutex);
+            if (!m_Wake.wait(lock, stop, [this] { return m_Pending.has_value(); })) return;
+
+            cfg = *m_Pending;
+            m_Pending.reset();
+            m_Cancel = false;
+        }
+
+        // Display-only edits such as showNoise leave every stage clean;
+        // picking another channel only needs a new slice.
+        if (m_Processor.Update(cfg, &m_Cancel) &&
+            (m_Processor.GetLastRunStages() != 0 || size_t(cfg.displayChannel) != m_PublishedChannel))
+        {
+            Publish();
+        }
+
+        std::lock_guard lock(m_Mutex);
+        m_Busy = m_Pending.has_value();
+    }
+}
+
+void ProcessingWorker::Publish()
+{
+    PROFILE_SCOPE("Publish");
+
+    // The old front may still be held by a reader; only recycle it once
+    // nobody else references it.
+    if (m_Back.use_count() > 1)
+    {
+        m_Back = std::make_shared<SignalSnapshot>();
+    }
+
+    SignalSnapshot& s = *m_Back;
+    s.config = m_Processor.GetConfig();
+    const size_t channels = m_Processor.GetChannelCount();
+    const size_t channel = std::min(size_t(std::max(0, s.config.displayChannel)), channels - 1);
+    s.config.displayChannel = int(channel);
+    m_PublishedChannel = channel;
+
+    s.time = m_Processor.GetTime();
+    copy_channel(m_Processor.GetInputSignal(), channel, channels, s.inputSignal);
+    copy_channel(m_Processor.GetCleanSignal(), channel, channels, s.cleanSignal);
+    s.idealSignal = m_Processor.GetIdealSignal();
+    s.frequencies = m_Processor.GetFrequencies();
+    copy_channel(m_Processor.GetInputSpectrum(), channel, channels, s.inputSpectrum);
+    copy_channel(m_Processor.GetCleanSpectrum(), channel, channels, s.cleanSpectrum);
+    s.delta = m_Processor.GetDelta();
+    s.channelDelta = m_Processor.GetChannelDelta(channel);
+    s.comparedDelta = m_Processor.GetComparedDelta();
+    s.spectralDelta = m_Processor.GetSpectralDelta();
+    s.firDelta = m_Processor.GetFirDelta();
+    s.generation = ++m_Generation;
+
+    std::lock_guard lock(m_Mutex);
+    std::swap(m_Front, m_Back);
+}
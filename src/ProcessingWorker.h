@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "SignalProcessor.h"
+
+// Everything the UI draws from one completed SignalProcessor::Update.
+// Per-channel arrays hold config.displayChannel only.
+struct SignalSnapshot
+{
+    SignalProcessor::Config config;
+    std::vector<double> time, inputSignal, cleanSignal, idealSignal;
+    std::vector<double> frequencies, inputSpectrum, cleanSpectrum;
+    // Mean over the channels, and the displayed channel's own.
+    double delta = 0;
+    double channelDelta = 0;
+    // Delta of the other precision; NaN unless config.comparePrecision.
+    double comparedDelta = 0;
+    // Both filters' mean Deltas; firDelta is NaN unless config.clean is Fir.
+    double spectralDelta = 0;
+    double firDelta = 0;
+    // Increases with every published snapshot.
+    uint64_t generation = 0;
+};
+
+// Runs SignalProcessor::Update on a background thread. Results are
+// published through two snapshot buffers: the worker fills the back one
+// and swaps it to the front under a short lock, so readers never see a
+// half-written result and never wait for a computation.
+//
+// Only the newest submitted Config matters: a submit replaces any config
+// that has not started yet and cancels the running job at its next stage
+// boundary.
+class ProcessingWorker
+{
+public:
+    ProcessingWorker();
+    ~ProcessingWorker();
+
+    ProcessingWorker(const ProcessingWorker&) = delete;
+    ProcessingWorker& operator=(const ProcessingWorker&) = delete;
+
+    void Submit(const SignalProcessor::Config& cfg);
+
+    // The latest completed result; stays valid while the caller holds it.
+    std::shared_ptr<const SignalSnapshot> Latest() const;
+
+    // True while a job is running or queued.
+    bool IsBusy() const { return m_Busy.load(std::memory_order_relaxed); }
+
+private:
+    void Run(std::stop_token stop);
+    void Publish();
+
+    SignalProcessor m_Processor;
+
+    mutable std::mutex m_Mutex;
+    std::condition_variable_any m_Wake;
+    std::optional<SignalProcessor::Config> m_Pending;
+    std::atomic<bool> m_Cancel{ false };
+    std::atomic<bool> m_Busy{ false };
+
+    std::shared_ptr<SignalSnapshot> m_Front, m_Back;
+    uint64_t m_Generation = 0;
+    size_t m_PublishedChannel = 0;
+
+    std::jthread m_Thread;
+};
@@ -1,134 +1,588 @@
 #include "SignalProcessor.h"
 #include "SpectrumFilter.h"
+#include "math/fir.h"
+#include "math/noise.h"
+#include "math/oscillator.h"
+#include "util/ParallelFor.h"
+#include "util/Profiler.h"
 
-SignalProcessor::SignalProcessor()
-{
-    m_Time.resize(m_Config.pointCount);
-    m_InputSignal.resize(m_Config.pointCount);
-    m_Noise.resize(m_Config.pointCount);
-    m_CleanSignal.resize(m_Config.pointCount);
-    m_IdealSignal.resize(m_Config.pointCount);
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
 
-    GenerateWhiteNoise();
-    GenerateSignal();
-    ComputeSpectrum();
-    FilterSpectrum();
+template <class T>
+class SignalProcessor::Pipeline
+{
+public:
+    using ComplexT = std::complex<T>;
 
-    // IFFT
-    auto ifftRes = ifft(m_FilteredSpectrum);
-    for (size_t i = 0; i < ifftRes.size(); ++i)
+    // Reads the external signal from its owner; starts with every stage
+    // dirty and runs them on the first Update.
+    explicit Pipeline(const std::shared_ptr<const SignalSource>& externalSignal)
+        : m_ExternalSignal(externalSignal)
     {
-        m_CleanSignal[i] = ifftRes[i].real();
+        Invalidate(StageAll);
     }
 
-    CalculateDelta();
-}
+    bool Update(const Config& cfg, const std::atomic<bool>* cancel);
+    void Invalidate(uint32_t stages);
+
+    uint32_t LastRun() const { return m_LastRun; }
+    const std::vector<double>& Time() const { return m_Time; }
+    const std::vector<T>& InputSignal() const { return m_InputSignal; }
+    // The FIR output while it is the clean source, the spectral one
+    // otherwise.
+    const std::vector<T>& CleanSignal() const { return m_FirSignal.empty() ? m_CleanSignal : m_FirSignal; }
+    const std::vector<T>& IdealSignal() const { return m_IdealSignal; }
+    const std::vector<double>& Frequencies() const { return m_Frequencies; }
+    const std::vector<T>& InputSpectrum() const { return m_InputSpectrum; }
+    const std::vector<T>& CleanSpectrum() const { return m_FirSignal.empty() ? m_CleanSpectrum : m_FirSpectrum; }
+    double Delta() const { return m_Delta; }
+    double SpectralDelta() const { return m_SpectralDelta; }
+    double FirDelta() const { return m_FirDelta; }
+    double ChannelDelta(size_t channel) const { return m_Deltas[channel]; }
+
+private:
+    struct StageInfo
+    {
+        Stage id;
+        uint32_t inputs;
+        void (Pipeline::*run)();
+        // Profiler label.
+        const char* name;
+    };
+    static const StageInfo s_Stages[];
+
+    bool RunStages(const std::atomic<bool>* cancel);
+
+    void GenerateWhiteNoise();
+    void TransformNoise();
+    void GenerateSignal();
+    void TransformSignal();
+    void ComputeSpectrum();
+    void PrepareFilter();
+    void FilterSpectrum();
+    void InverseSpectrum();
+    void FilterFir();
+    void CalculateDelta();
+    // Per-channel Deltas of clean into m_Deltas; returns their mean.
+    double ChannelDeltas(const std::vector<T>& clean);
+
+    const std::shared_ptr<const SignalSource>& m_ExternalSignal;
+    Config m_Config;
+    std::vector<double> m_Time, m_Frequencies;
+    std::vector<T> m_InputSignal, m_CleanSignal, m_IdealSignal;
+    std::vector<T> m_Noise;
+    std::vector<Sinusoid> m_Tones;
+    std::vector<T> m_InputSpectrum, m_CleanSpectrum;
+    std::vector<ComplexT> m_NoiseSpectrum, m_SignalSpectrum;
+    std::vector<ComplexT> m_Spectrum, m_FilteredSpectrum;
+    // Kernels per kind and channel, created on first use and kept, so
+    // switching kinds back and forth reuses their tables instead of
+    // reallocating.
+    std::vector<std::unique_ptr<SpectrumFilter<T>>> m_Filters[kFilterKindCount];
+    // FIR kernel and output; the output is empty unless the FIR filter is
+    // the clean source.
+    std::vector<double> m_FirTaps;
+    BasicFirFilter<T> m_Fir;
+    std::vector<T> m_FirSignal, m_FirSpectrum;
+    std::vector<ComplexT> m_FirBins;
+    // Energies and Delta are accumulated in double for both sample types;
+    // noise energies and Deltas per channel.
+    std::vector<double> m_NoiseEnergies, m_Deltas;
+    double m_SignalEnergy = 0;
+    double m_Delta = 0, m_SpectralDelta = 0, m_FirDelta = 0;
+    size_t m_Channels = 1;
+
+    uint32_t m_Dirty = 0;
+    uint32_t m_LastRun = 0;
+};
 
-void SignalProcessor::Update(const Config& cfg)
+// Pipeline stages in topological order with the stages each one reads.
+// A stage reruns when it or any of its inputs is dirty.
+template <class T>
+const typename SignalProcessor::Pipeline<T>::StageInfo SignalProcessor::Pipeline<T>::s_Stages[] = {
+    { StageNoise,          0,                                        &Pipeline::GenerateWhiteNoise, "Noise" },
+    { StageNoiseSpectrum,  StageNoise,                               &Pipeline::TransformNoise,     "Noise FFT" },
+    { StageSignal,         0,                                        &Pipeline::GenerateSignal,     "Signal" },
+    { StageSignalSpectrum, StageSignal,                              &Pipeline::TransformSignal,    "Signal FFT" },
+    { StageMix,            StageNoiseSpectrum | StageSignalSpectrum, &Pipeline::ComputeSpectrum,    "Mix" },
+    { StageFilterPrepare,  StageMix,                                 &Pipeline::PrepareFilter,      "Filter prepare" },
+    { StageFilter,         StageFilterPrepare,                       &Pipeline::FilterSpectrum,     "Filter" },
+    { StageInverse,        StageFilter,                              &Pipeline::InverseSpectrum,    "IFFT" },
+    { StageFir,            StageMix,                                 &Pipeline::FilterFir,          "FIR" },
+    { StageDelta,          StageInverse | StageSignal | StageFir,    &Pipeline::CalculateDelta,     "Delta" },
+};
+
+template <class T>
+bool SignalProcessor::Pipeline<T>::Update(const Config& cfg, const std::atomic<bool>* cancel)
 {
-    if (cfg == m_Config) return;
+    // Map each changed field onto the first stage that reads it.
     if (cfg.pointCount != m_Config.pointCount || cfg.sampleRate != m_Config.sampleRate)
     {
-        m_Noise.resize(cfg.pointCount);
-        GenerateWhiteNoise();
+        Invalidate(StageNoise | StageSignal);
+    }
+    if (cfg.seed != m_Config.seed || cfg.channels != m_Config.channels) Invalidate(StageNoise);
+    if (cfg.harmonics != m_Config.harmonics) Invalidate(StageSignal);
+    if (cfg.noiseAlpha != m_Config.noiseAlpha) Invalidate(StageMix);
+    if (cfg.filter != m_Config.filter) Invalidate(StageFilterPrepare);
+    if (cfg.gamma != m_Config.gamma || cfg.threshold != m_Config.threshold) Invalidate(StageFilter);
+    if (cfg.clean != m_Config.clean || cfg.firLow != m_Config.firLow || cfg.firHigh != m_Config.firHigh ||
+        cfg.firTaps != m_Config.firTaps)
+    {
+        Invalidate(StageFir);
     }
 
     m_Config = cfg;
+    m_Channels = size_t(std::max(1, cfg.channels));
+    return RunStages(cancel);
+}
+
+template <class T>
+void SignalProcessor::Pipeline<T>::Invalidate(uint32_t stages)
+{
+    m_Dirty |= stages;
+    for (const auto& stage : s_Stages)
+    {
+        if (m_Dirty & stage.inputs) m_Dirty |= stage.id;
+    }
+}
+
+template <class T>
+bool SignalProcessor::Pipeline<T>::RunStages(const std::atomic<bool>* cancel)
+{
+    m_LastRun = 0;
+    for (const auto& stage : s_Stages)
+    {
+        if (!(m_Dirty & stage.id)) continue;
 
-    m_Time.resize(m_Config.pointCount);
-    m_InputSignal.resize(m_Config.pointCount);
-    m_CleanSignal.resize(m_Config.pointCount);
-    m_IdealSignal.resize(m_Config.pointCount);
+        // Completed stages stay clean, so a cancelled update resumes
+        // from here on the next call.
+        if (cancel && cancel->load(std::memory_order_relaxed)) return false;
 
-    GenerateSignal();
-    ComputeSpectrum();
-    FilterSpectrum();
+        {
+            PROFILE_SCOPE(stage.name);
+            (this->*stage.run)();
+        }
+        m_Dirty &= ~stage.id;
+        m_LastRun |= stage.id;
+    }
+    return true;
+}
+
+template <class T>
+void SignalProcessor::Pipeline<T>::CalculateDelta()
+{
+    // The FIR Deltas come last so m_Deltas holds the clean source's.
+    m_SpectralDelta = ChannelDeltas(m_CleanSignal);
+    m_FirDelta = std::numeric_limits<double>::quiet_NaN();
+    if (!m_FirSignal.empty()) m_FirDelta = ChannelDeltas(m_FirSignal);
+    m_Delta = m_FirSignal.empty() ? m_SpectralDelta : m_FirDelta;
+}
+
+template <class T>
+double SignalProcessor::Pipeline<T>::ChannelDeltas(const std::vector<T>& cleanSignal)
+{
+    const size_t n = m_IdealSignal.size();
 
-    // IFFT
-    auto ifftRes = ifft(m_FilteredSpectrum);
-    for (size_t i = 0; i < ifftRes.size(); ++i)
+    m_Deltas.resize(m_Channels);
+    double mean = 0;
+    for (size_t c = 0; c < m_Channels; ++c)
     {
-        m_CleanSignal[i] = ifftRes[i].real();
+        const T* clean = cleanSignal.data() + c * n;
+        double delta = 0;
+        double counter = 0.0;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            double error = double(clean[i]) - double(m_IdealSignal[i]);
+            double ideal = m_IdealSignal[i];
+            delta += error * error;
+            counter += ideal * ideal;
+        }
+        m_Deltas[c] = delta / counter;
+        mean += m_Deltas[c];
     }
+    return mean / m_Channels;
+}
+
+template <class T>
+void SignalProcessor::Pipeline<T>::GenerateWhiteNoise()
+{
+    // Chunks are independent slices of one seeded stream, so the result
+    // does not depend on how many threads fill them. The channels are
+    // consecutive pieces of the same stream.
+    constexpr size_t kChunk = 1 << 16;
+    const size_t n = m_Config.pointCount;
+
+    m_Noise.resize(n * m_Channels);
+    parallel_for(0, m_Noise.size(), kChunk, [this](size_t begin, size_t end)
+    {
+        gaussian_noise(m_Config.seed, begin, m_Noise.data() + begin, end - begin);
+    });
 
-    CalculateDelta();
+    m_NoiseEnergies.assign(m_Channels, 0.0);
+    for (size_t c = 0; c < m_Channels; ++c)
+    {
+        double energy = 0;
+        for (size_t i = c * n; i < (c + 1) * n; ++i) energy += double(m_Noise[i]) * double(m_Noise[i]);
+        m_NoiseEnergies[c] = energy;
+    }
 }
 
-void SignalProcessor::CalculateDelta()
+template <class T>
+void SignalProcessor::Pipeline<T>::TransformNoise()
 {
-    m_Delta = 0;
+    const auto& plan = get_real_fft_plan<T>(m_Noise.size() / m_Channels);
+    m_NoiseSpectrum.resize(plan.Bins() * m_Channels);
+    plan.ForwardBatch(m_Noise.data(), m_NoiseSpectrum.data(), m_Channels, BatchLayout::Split);
+}
+
+template <class T>
+void SignalProcessor::Pipeline<T>::GenerateSignal()
+{
+    const size_t n = m_Config.pointCount;
+    double dt = 1.0 / m_Config.sampleRate;
 
-    double counter = 0.0;
+    m_Time.resize(n);
+    m_IdealSignal.resize(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        m_Time[i] = i * dt;
+    }
 
-    for (size_t i = 0; i < m_Config.pointCount; i++)
+    if (m_ExternalSignal)
     {
-        m_Delta += (m_CleanSignal[i] - m_IdealSignal[i]) * (m_CleanSignal[i] - m_IdealSignal[i]);
-        counter += m_IdealSignal[i] * m_IdealSignal[i];
+        size_t copied = m_ExternalSignal->Read(0, m_IdealSignal.data(), n);
+        std::fill(m_IdealSignal.begin() + copied, m_IdealSignal.end(), T(0));
     }
-    m_Delta /= counter;
+    else
+    {
+        m_Tones.clear();
+        for (const auto& h : m_Config.harmonics)
+        {
+            m_Tones.push_back({ h.amplitude, 2 * PI * h.frequency * dt, h.phase });
+        }
+        synthesize_sinusoids(m_Tones.data(), m_Tones.size(), m_IdealSignal.data(), n);
+    }
+
+    m_SignalEnergy = 0;
+    for (double x : m_IdealSignal)
+    {
+        m_SignalEnergy += x * x;
+    }
+}
+
+template <class T>
+void SignalProcessor::Pipeline<T>::TransformSignal()
+{
+    const auto& plan = get_real_fft_plan<T>(m_IdealSignal.size());
+    m_SignalSpectrum.resize(plan.Bins());
+    plan.Forward(m_IdealSignal.data(), m_SignalSpectrum.data());
 }
 
-void SignalProcessor::GenerateWhiteNoise()
+template <class T>
+void SignalProcessor::Pipeline<T>::ComputeSpectrum()
 {
-    for (size_t i = 0; i < m_Noise.size(); i++)
+    auto N = m_IdealSignal.size();
+    // The input is real, so only the N/2+1 Hermitian-half bins are kept.
+    const size_t bins = m_SignalSpectrum.size();
+
+    m_InputSignal.resize(N * m_Channels);
+    m_Spectrum.resize(bins * m_Channels);
+    m_InputSpectrum.resize(bins * m_Channels);
+    for (size_t c = 0; c < m_Channels; ++c)
     {
-        int noise = 0;
-        for (size_t s = 0; s < 12; s++)
+        // The FFT is linear, so the noisy spectrum is mixed from the cached
+        // signal and noise spectra instead of transforming the sum again.
+        T beta = T(std::sqrt(m_SignalEnergy * m_Config.noiseAlpha / m_NoiseEnergies[c]));
+
+        T* input = m_InputSignal.data() + c * N;
+        const T* noise = m_Noise.data() + c * N;
+        for (size_t i = 0; i < N; ++i)
+        {
+            input[i] = m_IdealSignal[i] + noise[i] * beta;
+        }
+
+        ComplexT* spectrum = m_Spectrum.data() + c * bins;
+        const ComplexT* noiseSpectrum = m_NoiseSpectrum.data() + c * bins;
+        for (size_t k = 0; k < bins; ++k)
         {
-            noise += rand();
+            spectrum[k] = m_SignalSpectrum[k] + noiseSpectrum[k] * beta;
         }
-        m_Noise[i] = (noise - static_cast<double>(RAND_MAX * 6)) / (12 * RAND_MAX);
+        amplitude_spectrum(spectrum, bins, N, m_InputSpectrum.data() + c * bins);
+    }
+
+    m_Frequencies.resize(bins);
+    for (size_t k = 0; k < bins; k++)
+    {
+        m_Frequencies[k] = static_cast<float>(k * m_Config.sampleRate) / N;
     }
 }
 
-void SignalProcessor::GenerateSignal()
+template <class T>
+void SignalProcessor::Pipeline<T>::PrepareFilter()
 {
-    double dt = 1.0 / m_Config.sampleRate;
-    double signalEnergy = 0;
+    auto& filters = m_Filters[static_cast<size_t>(m_Config.filter)];
+    if (filters.size() < m_Channels) filters.resize(m_Channels);
+    for (size_t c = 0; c < m_Channels; ++c)
+    {
+        if (!filters[c]) filters[c] = SpectrumFilter<T>::Create(m_Config.filter);
+    }
+
+    parallel_for(0, m_Channels, 1, [this](size_t begin, size_t end)
+    {
+        auto& filters = m_Filters[static_cast<size_t>(m_Config.filter)];
+        const size_t n = m_IdealSignal.size();
+        const size_t bins = m_SignalSpectrum.size();
+        for (size_t c = begin; c < end; ++c)
+        {
+            filters[c]->Prepare(m_InputSpectrum.data() + c * bins, bins, n);
+        }
+    });
+}
 
-    for (int i = 0; i < m_Config.pointCount; ++i)
+template <class T>
+void SignalProcessor::Pipeline<T>::FilterSpectrum()
+{
+    // Copy into the existing buffer and filter in place; no allocation
+    // once the size is stable.
+    m_FilteredSpectrum.assign(m_Spectrum.begin(), m_Spectrum.end());
+    m_CleanSpectrum.resize(m_FilteredSpectrum.size());
+
+    parallel_for(0, m_Channels, 1, [this](size_t begin, size_t end)
     {
-        double t = i * dt;
-        double s1 = m_Config.sin1.amplitude * sin(2 * PI * m_Config.sin1.frequency * t + m_Config.sin1.phase);
-        double s2 = m_Config.sin2.amplitude * sin(2 * PI * m_Config.sin2.frequency * t + m_Config.sin2.phase);
-        double s3 = m_Config.sin3.amplitude * sin(2 * PI * m_Config.sin3.frequency * t + m_Config.sin3.phase);
+        const auto& filters = m_Filters[static_cast<size_t>(m_Config.filter)];
+        const size_t n = m_IdealSignal.size();
+        const size_t bins = m_SignalSpectrum.size();
+        for (size_t c = begin; c < end; ++c)
+        {
+            ComplexT* filtered = m_FilteredSpectrum.data() + c * bins;
+            filters[c]->Apply(filtered, m_InputSpectrum.data() + c * bins, { m_Config.gamma, m_Config.threshold });
+            amplitude_spectrum(filtered, bins, n, m_CleanSpectrum.data() + c * bins);
+        }
+    });
+}
+
+template <class T>
+void SignalProcessor::Pipeline<T>::InverseSpectrum()
+{
+    m_CleanSignal.resize(m_InputSignal.size());
+    get_real_fft_plan<T>(m_IdealSignal.size())
+        .InverseBatch(m_FilteredSpectrum.data(), m_CleanSignal.data(), m_Channels, BatchLayout::Split);
+}
 
-        m_Time[i] = t;
-        m_InputSignal[i] = s1 + s2 + s3;
-        m_IdealSignal[i] = s1 + s2 + s3;
-        signalEnergy += m_InputSignal[i] * m_InputSignal[i];
+template <class T>
+void SignalProcessor::Pipeline<T>::FilterFir()
+{
+    // Cleared, not freed, so switching back does not allocate.
+    if (m_Config.clean != CleanSource::Fir)
+    {
+        m_FirSignal.clear();
+        m_FirSpectrum.clear();
+        return;
     }
 
-    double noiseEnergy = 0;
-    for (double n : m_Noise) noiseEnergy += n * n;
+    const size_t n = m_IdealSignal.size();
+    const size_t bins = m_SignalSpectrum.size();
+    DesignFir(m_Config, m_FirTaps);
+    m_Fir.SetTaps(m_FirTaps.data(), m_FirTaps.size());
+
+    m_FirSignal.resize(m_InputSignal.size());
+    parallel_for(0, m_Channels, 1, [this, n](size_t begin, size_t end)
+    {
+        for (size_t c = begin; c < end; ++c) m_Fir.Apply(m_InputSignal.data() + c * n, m_FirSignal.data() + c * n, n);
+    });
 
-    double beta = std::sqrt(signalEnergy * m_Config.noiseAlpha / noiseEnergy);
-    for (int i = 0; i < m_Config.pointCount; ++i)
+    m_FirBins.resize(bins * m_Channels);
+    m_FirSpectrum.resize(bins * m_Channels);
+    get_real_fft_plan<T>(n).ForwardBatch(m_FirSignal.data(), m_FirBins.data(), m_Channels, BatchLayout::Split);
+    for (size_t c = 0; c < m_Channels; ++c)
     {
-        m_InputSignal[i] += m_Noise[i] * beta;
+        amplitude_spectrum(m_FirBins.data() + c * bins, bins, n, m_FirSpectrum.data() + c * bins);
     }
 }
 
-void SignalProcessor::ComputeSpectrum()
+std::vector<SinParam> default_harmonics()
 {
-    auto N = m_InputSignal.size();
+    static const SinParam harmonics[] = { { 10, 10, 0 } };
+    return { std::begin(harmonics), std::end(harmonics) };
+}
 
-    auto fft_res = fft_real(m_InputSignal);
-    m_Spectrum = fft_res;
-    m_InputSpectrum = amplitude_spectrum(fft_res);
+const char* to_string(Precision precision)
+{
+    return precision == Precision::Float ? "float" : "double";
+}
 
-    m_Frequencies.resize(N);
-    m_InputSpectrum.resize(N);
-    for (int k = 0; k < N; k++)
+const char* to_string(CleanSource source)
+{
+    return source == CleanSource::Fir ? "fir" : "spectral";
+}
+
+void SignalProcessor::DesignFir(const Config& cfg, std::vector<double>& taps)
+{
+    const double rate = std::max(1, cfg.sampleRate);
+    const double high = std::clamp(cfg.firHigh / rate, 0.0, 0.5);
+    const double low = std::clamp(cfg.firLow / rate, 0.0, high);
+    taps.resize(size_t(std::max(1, cfg.firTaps)) | 1);
+    design_fir(low, high, taps.data(), taps.size());
+}
+
+SignalProcessor::SignalProcessor()
+    : m_Double(std::make_unique<Pipeline<double>>(m_ExternalSignal)),
+      m_ComparedDelta(std::numeric_limits<double>::quiet_NaN())
+{
+    m_Double->Update(m_Config, nullptr);
+}
+
+SignalProcessor::~SignalProcessor() = default;
+
+template <class T>
+SignalProcessor::Pipeline<T>& SignalProcessor::GetPipeline()
+{
+    if constexpr (std::is_same_v<T, float>)
     {
-        m_Frequencies[k] = static_cast<float>(k * m_Config.sampleRate) / N;
+        if (!m_Float) m_Float = std::make_unique<Pipeline<float>>(m_ExternalSignal);
+        return *m_Float;
+    }
+    else
+    {
+        return *m_Double;
+    }
+}
+
+template <class T>
+bool SignalProcessor::UpdatePipeline(const std::atomic<bool>* cancel, uint32_t& ran)
+{
+    auto& pipeline = GetPipeline<T>();
+    bool done = pipeline.Update(m_Config, cancel);
+    ran = pipeline.LastRun();
+    return done;
+}
+
+bool SignalProcessor::Update(const Config& cfg, const std::atomic<bool>* cancel)
+{
+    PROFILE_SCOPE("Update");
+
+    bool compareChanged = cfg.comparePrecision != m_Config.comparePrecision;
+    m_Config = cfg;
+
+    bool useFloat = cfg.precision == Precision::Float;
+    uint32_t ran = 0;
+    bool done = useFloat ? UpdatePipeline<float>(cancel, ran) : UpdatePipeline<double>(cancel, ran);
+
+    // Until an update in the new precision completes, every result is
+    // treated as changed.
+    if (cfg.precision != m_Completed) ran = StageAll;
+    if (useFloat) WidenFloatResults(ran);
+    m_LastRun = ran;
+    if (!done) return false;
+    m_Completed = cfg.precision;
+
+    if (cfg.comparePrecision)
+    {
+        uint32_t comparedRan = 0;
+        done = useFloat ? UpdatePipeline<double>(cancel, comparedRan) : UpdatePipeline<float>(cancel, comparedRan);
+        if (comparedRan & StageDelta) m_LastRun |= StageDelta;
+        if (!done) return false;
+        m_ComparedDelta = useFloat ? m_Double->Delta() : m_Float->Delta();
+    }
+    else
+    {
+        m_ComparedDelta = std::numeric_limits<double>::quiet_NaN();
+    }
+    if (compareChanged) m_LastRun |= StageDelta;
+    return true;
+}
+
+void SignalProcessor::WidenFloatResults(uint32_t stages)
+{
+    // Only the arrays whose stages ran are converted again.
+    const auto& p = *m_Float;
+    if (stages & StageSignal) m_WideIdealSignal.assign(p.IdealSignal().begin(), p.IdealSignal().end());
+    if (stages & StageMix)
+    {
+        m_WideInputSignal.assign(p.InputSignal().begin(), p.InputSignal().end());
+        m_WideInputSpectrum.assign(p.InputSpectrum().begin(), p.InputSpectrum().end());
+    }
+    // The clean results come from either filter.
+    if (stages & (StageFilter | StageFir))
+    {
+        m_WideCleanSpectrum.assign(p.CleanSpectrum().begin(), p.CleanSpectrum().end());
     }
+    if (stages & (StageInverse | StageFir))
+    {
+        m_WideCleanSignal.assign(p.CleanSignal().begin(), p.CleanSignal().end());
+    }
+}
+
+void SignalProcessor::SetExternalSignal(std::vector<double> samples)
+{
+    SetExternalSignal(samples.empty() ? nullptr : std::make_shared<MemorySignal>(std::move(samples)));
+}
+
+void SignalProcessor::SetExternalSignal(std::shared_ptr<const SignalSource> source)
+{
+    m_ExternalSignal = std::move(source);
+    m_Double->Invalidate(StageSignal);
+    if (m_Float) m_Float->Invalidate(StageSignal);
+}
+
+const std::vector<double>& SignalProcessor::GetTime() const
+{
+    return m_Config.precision == Precision::Float ? m_Float->Time() : m_Double->Time();
+}
+
+const std::vector<double>& SignalProcessor::GetInputSignal() const
+{
+    return m_Config.precision == Precision::Float ? m_WideInputSignal : m_Double->InputSignal();
+}
+
+const std::vector<double>& SignalProcessor::GetCleanSignal() const
+{
+    return m_Config.precision == Precision::Float ? m_WideCleanSignal : m_Double->CleanSignal();
+}
+
+const std::vector<double>& SignalProcessor::GetIdealSignal() const
+{
+    return m_Config.precision == Precision::Float ? m_WideIdealSignal : m_Double->IdealSignal();
+}
+
+const std::vector<double>& SignalProcessor::GetFrequencies() const
+{
+    return m_Config.precision == Precision::Float ? m_Float->Frequencies() : m_Double->Frequencies();
+}
+
+const std::vector<double>& SignalProcessor::GetInputSpectrum() const
+{
+    return m_Config.precision == Precision::Float ? m_WideInputSpectrum : m_Double->InputSpectrum();
+}
+
+const std::vector<double>& SignalProcessor::GetCleanSpectrum() const
+{
+    return m_Config.precision == Precision::Float ? m_WideCleanSpectrum : m_Double->CleanSpectrum();
+}
+
+double SignalProcessor::GetDelta() const
+{
+    return m_Config.precision == Precision::Float ? m_Float->Delta() : m_Double->Delta();
+}
+
+double SignalProcessor::GetSpectralDelta() const
+{
+    return m_Config.precision == Precision::Float ? m_Float->SpectralDelta() : m_Double->SpectralDelta();
+}
+
+double SignalProcessor::GetFirDelta() const
+{
+    return m_Config.precision == Precision::Float ? m_Float->FirDelta() : m_Double->FirDelta();
 }
 
-void SignalProcessor::FilterSpectrum()
+double SignalProcessor::GetChannelDelta(size_t channel) const
 {
-    m_FilteredSpectrum = SpectrumFilter::Apply(m_Spectrum, m_InputSpectrum, m_Config.gamma);
-    m_CleanSpectrum = amplitude_spectrum(m_FilteredSpectrum);
+    return m_Config.precision == Precision::Float ? m_Float->ChannelDelta(channel)
+                                                  : m_Double->ChannelDelta(channel);
 }
 
 bool operator==(const SinParam &rhs, const SinParam &lhs)
@@ -146,8 +600,17 @@ bool operator==(const SignalProcessor::Config &rhs, const SignalProcessor::Confi
         (rhs.sampleRate == lhs.sampleRate) &&
         (rhs.pointCount == lhs.pointCount) &&
         (rhs.noiseAlpha == lhs.noiseAlpha) &&
+        (rhs.seed == lhs.seed) &&
         (rhs.gamma == lhs.gamma) &&
-        (rhs.sin1 == lhs.sin1) &&
-        (rhs.sin2 == lhs.sin2) &&
-        (rhs.sin3 == lhs.sin3);
+        (rhs.filter == lhs.filter) &&
+        (rhs.threshold == lhs.threshold) &&
+        (rhs.harmonics == lhs.harmonics) &&
+        (rhs.precision == lhs.precision) &&
+        (rhs.comparePrecision == lhs.comparePrecision) &&
+        (rhs.channels == lhs.channels) &&
+        (rhs.displayChannel == lhs.displayChannel) &&
+        (rhs.clean == lhs.clean) &&
+        (rhs.firLow == lhs.firLow) &&
+        (rhs.firHigh == lhs.firHigh) &&
+        (rhs.firTaps == lhs.firTaps);
 }
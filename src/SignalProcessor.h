@@ -1,12 +1,40 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <vector>
+#include "io/SignalSource.h"
 #include "math/fft.h"
+#include "SpectrumFilter.h"
 
 struct SinParam
 {
     float amplitude = 0, frequency = 0, phase = 0;
 };
 
+// The single 10 Hz tone a default Config starts with.
+std::vector<SinParam> default_harmonics();
+
+// Sample type the pipeline computes in. Float halves the memory traffic
+// and doubles the SIMD width at about 1e-7 relative rounding per step.
+enum class Precision
+{
+    Double,
+    Float,
+};
+
+const char* to_string(Precision precision);
+
+// Filter that produces the clean signal and its Delta.
+enum class CleanSource
+{
+    Spectral, // the FilterKind kernel on the whole spectrum
+    Fir,      // a windowed-sinc FIR filter, by fast convolution
+};
+
+const char* to_string(CleanSource source);
+
 class SignalProcessor
 {
 public:
@@ -16,40 +44,135 @@ public:
         int sampleRate = 1024;
         int pointCount = 1024;
         float noiseAlpha = 0.2;
+        // Noise stream; the same seed reproduces the same noise.
+        uint64_t seed = 1;
         float gamma = 1.0;
-        SinParam sin1{10, 10, 0};
-        SinParam sin2{0, 0, 0};
-        SinParam sin3{0, 0, 0};
+        FilterKind filter = FilterKind::EnergyCutoff;
+        float threshold = 3.0;
+        // Summed into the ideal signal; any number of components.
+        std::vector<SinParam> harmonics = default_harmonics();
+        Precision precision = Precision::Double;
+        // Also keeps the other precision up to date and reports its Delta.
+        bool comparePrecision = false;
+        // Independent noise realizations of the signal, transformed and
+        // filtered as one batch. Channel c draws samples [c * pointCount,
+        // (c + 1) * pointCount) of the seed's stream, so channel 0 is the
+        // single-channel result.
+        int channels = 1;
+        // Channel the UI shows; no stage reads it.
+        int displayChannel = 0;
+        // With CleanSource::Fir the spectral filter still runs, so both
+        // Deltas can be compared.
+        CleanSource clean = CleanSource::Spectral;
+        // FIR passband in Hz; firLow = 0 designs a low-pass. The band is
+        // clamped to [0, sampleRate / 2] and firTaps rounded up to odd, so
+        // the delay is a whole number of samples.
+        float firLow = 0, firHigh = 50;
+        int firTaps = 101;
+    };
+
+    // Pipeline stages. Update only reruns the stages whose Config inputs
+    // changed and everything downstream of them.
+    enum Stage : uint32_t
+    {
+        StageNoise          = 1 << 0, // white noise for pointCount
+        StageNoiseSpectrum  = 1 << 1, // FFT of the noise alone
+        StageSignal         = 1 << 2, // time axis, ideal signal and its energy
+        StageSignalSpectrum = 1 << 3, // FFT of the ideal signal alone
+        StageMix            = 1 << 4, // noisy input and its spectrum, scaled by noiseAlpha
+        StageFilterPrepare  = 1 << 5, // filter kernel and its parameter-independent tables
+        StageFilter         = 1 << 6, // kernel applied at gamma / threshold
+        StageInverse        = 1 << 7, // clean signal
+        StageDelta          = 1 << 8,
+        StageFir            = 1 << 9, // FIR-filtered signal and its spectrum
+        StageAll            = (1 << 10) - 1,
     };
 
     SignalProcessor();
+    ~SignalProcessor();
+
+    // Brings the results up to date with cfg. When cancel is set by
+    // another thread, the update stops at the next stage boundary and
+    // returns false; finished stages are kept and the rest runs on the
+    // next call.
+    //
+    // All buffers are members sized on pointCount changes, filter kernels
+    // are kept per kind and FFT scratch is per thread, so once every stage
+    // has run at a size, further updates at that size do not allocate.
+    //
+    // The stages run in Config::precision. Each precision keeps its own
+    // pipeline, so switching back reuses the other one's results.
+    bool Update(const Config& cfg, const std::atomic<bool>* cancel = nullptr);
 
-    void Update(const Config& cfg);
+    // Stages that ran during the last Update, as a Stage mask. A precision
+    // switch reports every stage, since all results change.
+    uint32_t GetLastRunStages() const { return m_LastRun; }
+
+    // Replaces the synthetic harmonics with recorded samples, which then
+    // also serve as the reference for Delta. Samples beyond pointCount are
+    // ignored, missing ones read as zero. An empty vector or a null source
+    // restores the generator. Takes effect on the next Update.
+    //
+    // Only the first pointCount samples of a source are read, so a mapped
+    // file is never loaded as a whole.
+    void SetExternalSignal(std::vector<double> samples);
+    void SetExternalSignal(std::shared_ptr<const SignalSource> source);
+    bool HasExternalSignal() const { return m_ExternalSignal != nullptr; }
 
     bool IsShowNoise() const { return m_Config.showNoise; }
+    const Config& GetConfig() const { return m_Config; }
+    size_t GetChannelCount() const { return size_t(std::max(1, m_Config.channels)); }
+
+    // Results of the active precision; float results are widened to
+    // double here, the time and frequency axes are double in both.
+    //
+    // The input and clean signals and spectra hold every channel back to
+    // back, channel c at c * pointCount (signals) or c * bins (spectra).
+    // The time axis, the ideal signal and the frequencies are shared.
+    const std::vector<double>& GetTime() const;
+    const std::vector<double>& GetInputSignal() const;
+    const std::vector<double>& GetCleanSignal() const;
+    const std::vector<double>& GetIdealSignal() const;
+    const std::vector<double>& GetFrequencies() const;
+    const std::vector<double>& GetInputSpectrum() const;
+    const std::vector<double>& GetCleanSpectrum() const;
+    // Mean of the channels' Deltas, measured on the Config::clean output.
+    double GetDelta() const;
+    double GetChannelDelta(size_t channel) const;
+    // Deltas of both filters while Config::clean is Fir: the spectral one
+    // is always computed, the FIR one is NaN otherwise.
+    double GetSpectralDelta() const;
+    double GetFirDelta() const;
+    // Delta of the other precision while comparePrecision is set, NaN
+    // otherwise.
+    double GetComparedDelta() const { return m_ComparedDelta; }
 
-    const std::vector<double>& GetTime() const { return m_Time; }
-    const std::vector<double>& GetInputSignal() const { return m_InputSignal; }
-    const std::vector<double>& GetCleanSignal() const { return m_CleanSignal; }
-    const std::vector<double>& GetIdealSignal() const { return m_IdealSignal; }
-    const std::vector<double>& GetFrequencies() const { return m_Frequencies; }
-    const std::vector<double>& GetInputSpectrum() const { return m_InputSpectrum; }
-    const std::vector<double>& GetCleanSpectrum() const { return m_CleanSpectrum; }
-    double GetDelta() const { return m_Delta; }
+    // The FIR kernel of cfg, as the pipeline designs it.
+    static void DesignFir(const Config& cfg, std::vector<double>& taps);
 
 private:
-    void GenerateWhiteNoise();
-    void GenerateSignal();
-    void ComputeSpectrum();
-    void FilterSpectrum();
-    void CalculateDelta();
+    // The stage graph for one sample type; defined in SignalProcessor.cpp.
+    template <class T>
+    class Pipeline;
+
+    template <class T>
+    Pipeline<T>& GetPipeline();
+    template <class T>
+    bool UpdatePipeline(const std::atomic<bool>* cancel, uint32_t& ran);
+    void WidenFloatResults(uint32_t stages);
 
     Config m_Config;
-    std::vector<double> m_Time, m_InputSignal, m_CleanSignal, m_IdealSignal;
-    std::vector<double> m_Noise;
-    std::vector<double> m_Frequencies, m_InputSpectrum, m_CleanSpectrum;
-    std::vector<Complex> m_Spectrum, m_FilteredSpectrum;
-    double m_Delta;
+    std::shared_ptr<const SignalSource> m_ExternalSignal;
+    // The double pipeline always exists; the float one from first use.
+    std::unique_ptr<Pipeline<double>> m_Double;
+    std::unique_ptr<Pipeline<float>> m_Float;
+    std::vector<double> m_WideInputSignal, m_WideCleanSignal, m_WideIdealSignal;
+    std::vector<double> m_WideInputSpectrum, m_WideCleanSpectrum;
+    // Precision of the last update that completed.
+    Precision m_Completed = Precision::Double;
+    double m_ComparedDelta;
+
+    uint32_t m_LastRun = 0;
 };
 
 bool operator==(const SinParam& rhs, const SinParam& lhs);
@@ -0,0 +1,78 @@
+#include "Spectrogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+Spectrogram::Spectrogram(const Config& cfg)
+    : m_Config(cfg),
+      m_FrameSize(cfg.frameSize > 0 ? cfg.frameSize : 0),
+      m_HopSize(cfg.hopSize > 0 ? cfg.hopSize : 0),
+      m_Plan(get_real_fft_plan<float>(m_FrameSize > 0 ? m_FrameSize : 1))
+{
+    if (m_FrameSize == 0 || m_HopSize == 0 || m_HopSize > m_FrameSize)
+    {
+        throw std::invalid_argument("Spectrogram: need 0 < hopSize <= frameSize");
+    }
+    m_Config.rows = std::max<size_t>(1, m_Config.rows);
+
+    // Periodic Hann, as in StreamingFilter.
+    double sum = 0;
+    m_Window.resize(m_FrameSize);
+    for (size_t i = 0; i < m_FrameSize; ++i)
+    {
+        double w = 0.5 - 0.5 * std::cos(2.0 * PI * i / m_FrameSize);
+        m_Window[i] = float(w);
+        sum += w;
+    }
+    m_Scale = float(2 / sum);
+
+    m_Frame.resize(m_FrameSize);
+    m_Windowed.resize(m_FrameSize);
+    m_Spectrum.resize(m_Plan.Bins());
+    m_Rows.resize(m_Config.rows * m_Plan.Bins());
+    Reset();
+}
+
+void Spectrogram::Reset()
+{
+    m_Filled = 0;
+    m_Frames = 0;
+    std::fill(m_Rows.begin(), m_Rows.end(), m_Config.floorDb);
+}
+
+void Spectrogram::Push(const double* samples, size_t count)
+{
+    while (count > 0)
+    {
+        size_t n = std::min(count, m_FrameSize - m_Filled);
+        std::transform(samples, samples + n, m_Frame.begin() + m_Filled, [](double x) { return float(x); });
+        m_Filled += n;
+        samples += n;
+        count -= n;
+
+        if (m_Filled == m_FrameSize)
+        {
+            ProcessFrame();
+            std::copy(m_Frame.begin() + m_HopSize, m_Frame.end(), m_Frame.begin());
+            m_Filled = m_FrameSize - m_HopSize;
+        }
+    }
+}
+
+void Spectrogram::ProcessFrame()
+{
+    for (size_t i = 0; i < m_FrameSize; ++i) m_Windowed[i] = m_Frame[i] * m_Window[i];
+    m_Plan.Forward(m_Windowed.data(), m_Spectrum.data());
+
+    // 10 log10 of the squared amplitude saves a square root per bin.
+    const float floor = std::pow(10.0f, m_Config.floorDb / 10) / (m_Scale * m_Scale);
+    const float offset = 20 * std::log10(m_Scale);
+    float* row = m_Rows.data() + size_t(m_Frames % m_Config.rows) * m_Spectrum.size();
+    for (size_t k = 0; k < m_Spectrum.size(); ++k)
+    {
+        float power = std::norm(m_Spectrum[k]);
+        row[k] = 10 * std::log10(std::max(power, floor)) + offset;
+    }
+    ++m_Frames;
+}
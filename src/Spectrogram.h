@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "math/fft.h"
+
+// Short-time spectrum of an unbounded stream for waterfall displays. Each
+// time hopSize new samples complete a frame, the last frameSize samples
+// are Hann-windowed and transformed, and their amplitudes in dB become one
+// row of a ring that keeps the last `rows` frames. Only new frames are
+// ever transformed, so a sample costs the same however long the stream
+// runs, and memory is fixed by frameSize and rows.
+//
+// Frame f covers samples [f * hopSize, f * hopSize + frameSize). The
+// transforms run in float: the rows are for display, and the amplitudes
+// read as for a sinusoid, 20 log10 of its amplitude at its bin.
+class Spectrogram
+{
+public:
+    struct Config
+    {
+        int frameSize = 512;
+        int hopSize = 256;
+        size_t rows = 512;
+        // Amplitudes below this level are raised to it.
+        float floorDb = -120;
+    };
+
+    // Throws std::invalid_argument unless 0 < hopSize <= frameSize.
+    explicit Spectrogram(const Config& cfg);
+
+    const Config& GetConfig() const { return m_Config; }
+
+    void Push(const double* samples, size_t count);
+    void Reset();
+
+    size_t Bins() const { return m_Plan.Bins(); }
+    size_t Rows() const { return m_Config.rows; }
+    // Frames finished so far; the newest min(Frames(), Rows()) are kept.
+    uint64_t Frames() const { return m_Frames; }
+    uint64_t FirstRetained() const { return m_Frames > m_Config.rows ? m_Frames - m_Config.rows : 0; }
+    // Bins() levels in dB of a retained frame.
+    const float* Row(uint64_t frame) const { return m_Rows.data() + size_t(frame % m_Config.rows) * Bins(); }
+
+private:
+    void ProcessFrame();
+
+    Config m_Config;
+    size_t m_FrameSize, m_HopSize;
+    const BasicRealFftPlan<float>& m_Plan;
+    std::vector<float> m_Window;
+    // 2 / sum of the window: the amplitude of a sinusoid at its bin.
+    float m_Scale = 0;
+
+    // The frame being filled; m_Filled samples are valid.
+    std::vector<float> m_Frame;
+    size_t m_Filled = 0;
+    std::vector<float> m_Windowed;
+    std::vector<ComplexF> m_Spectrum;
+
+    std::vector<float> m_Rows;
+    uint64_t m_Frames = 0;
+};
@@ -1,31 +1,183 @@
 #include "SpectrumFilter.h"
 
-std::vector<Complex>
-SpectrumFilter::Apply(const std::vector<Complex>& spectrum,
-                      const std::vector<double>& amplitudes,
-                      double ratio)
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+template <class T>
+class EnergyCutoffFilter : public SpectrumFilter<T>
 {
-    auto filtered = spectrum;
-    double totalEnergy = 0;
-    for (double a : amplitudes) totalEnergy += a * a;
+public:
+    using typename SpectrumFilter<T>::ComplexT;
+
+    void Prepare(const T* amplitudes, size_t bins, size_t n) override
+    {
+        // Hermitian half: every bin except DC and (for even N) Nyquist also
+        // stands for its mirrored negative-frequency twin, so it carries
+        // twice the energy.
+        size_t nyquist = (n % 2 == 0) ? bins - 1 : bins;
 
-    double targetEnergy = totalEnergy * ratio;
-    double accumulated = 0;
-    size_t k = 0;
+        m_Prefix.resize(bins);
+        double accumulated = 0;
+        for (size_t k = 0; k < bins; k++)
+        {
+            double weight = (k == 0 || k == nyquist) ? 1.0 : 2.0;
+            double a = amplitudes[k];
+            accumulated += weight * a * a;
+            m_Prefix[k] = accumulated;
+        }
+    }
 
-    for (; k < amplitudes.size(); k++)
+    void Apply(ComplexT* spectrum, const T*, const FilterParams& params) const override
     {
-        accumulated += amplitudes[k] * amplitudes[k];
-        accumulated += amplitudes[amplitudes.size() - k - 1] * amplitudes[amplitudes.size() - k - 1];
-        
-        if (accumulated > targetEnergy) break;
+        if (m_Prefix.empty()) return;
+
+        // First bin whose running energy exceeds the target; it and
+        // everything above it is cut.
+        double targetEnergy = m_Prefix.back() * params.gamma;
+        size_t k = std::upper_bound(m_Prefix.begin(), m_Prefix.end(), targetEnergy) - m_Prefix.begin();
+
+        std::fill(spectrum + k, spectrum + m_Prefix.size(), ComplexT(0, 0));
     }
 
-    if (k == 1024) return filtered;
-    for (size_t i = k; i < amplitudes.size() - k; ++i)
+private:
+    // Running weighted bin energy; reused for every gamma.
+    std::vector<double> m_Prefix;
+};
+
+// Base for kernels that compare each bin against a noise floor estimated
+// as the median bin amplitude.
+template <class T>
+class NoiseFloorFilter : public SpectrumFilter<T>
+{
+public:
+    using typename SpectrumFilter<T>::ComplexT;
+
+    void Prepare(const T* amplitudes, size_t bins, size_t n) override
+    {
+        m_Bins = bins;
+        m_N = n;
+        m_Scratch.assign(amplitudes, amplitudes + bins);
+        auto middle = m_Scratch.begin() + bins / 2;
+        std::nth_element(m_Scratch.begin(), middle, m_Scratch.end());
+        m_Median = bins > 0 ? *middle : T(0);
+    }
+
+protected:
+    T Cut(const FilterParams& params) const { return T(params.threshold * m_Median); }
+
+    // Multiplies every bin by gain(amplitude). The amplitude spectrum
+    // shows DC as zero, which would put any offset under the cut, so bin 0
+    // is judged by its real level |X0| / n.
+    template <class Gain>
+    void Scale(ComplexT* spectrum, const T* amplitudes, Gain gain) const
+    {
+        if (m_Bins == 0) return;
+        spectrum[0] *= gain(std::abs(spectrum[0]) / T(m_N));
+        for (size_t k = 1; k < m_Bins; ++k) spectrum[k] *= gain(amplitudes[k]);
+    }
+
+    size_t m_Bins = 0, m_N = 0;
+    T m_Median = 0;
+
+private:
+    std::vector<T> m_Scratch;
+};
+
+// With threshold = 0 each kernel's gain is exactly 1 for every bin that
+// is not zero already, so they all pass the spectrum through unchanged.
+
+template <class T>
+class HardThresholdFilter : public NoiseFloorFilter<T>
+{
+public:
+    using typename SpectrumFilter<T>::ComplexT;
+
+    void Apply(ComplexT* spectrum, const T* amplitudes, const FilterParams& params) const override
+    {
+        T cut = this->Cut(params);
+        this->Scale(spectrum, amplitudes, [cut](T a) { return a < cut ? T(0) : T(1); });
+    }
+};
+
+template <class T>
+class SoftThresholdFilter : public NoiseFloorFilter<T>
+{
+public:
+    using typename SpectrumFilter<T>::ComplexT;
+
+    void Apply(ComplexT* spectrum, const T* amplitudes, const FilterParams& params) const override
+    {
+        T cut = this->Cut(params);
+        this->Scale(spectrum, amplitudes, [cut](T a) { return a > cut ? (a - cut) / a : T(0); });
+    }
+};
+
+template <class T>
+class WienerFilter : public NoiseFloorFilter<T>
+{
+public:
+    using typename SpectrumFilter<T>::ComplexT;
+
+    void Apply(ComplexT* spectrum, const T* amplitudes, const FilterParams& params) const override
+    {
+        // With SNR = P / Pn - 1 the gain SNR / (1 + SNR) is 1 - Pn / P.
+        T noisePower = this->Cut(params) * this->Cut(params);
+        this->Scale(spectrum, amplitudes, [noisePower](T a)
+        {
+            T power = a * a;
+            return power > noisePower ? T(1) - noisePower / power : T(0);
+        });
+    }
+};
+
+template <class T>
+class SpectralSubtractionFilter : public NoiseFloorFilter<T>
+{
+public:
+    using typename SpectrumFilter<T>::ComplexT;
+
+    void Apply(ComplexT* spectrum, const T* amplitudes, const FilterParams& params) const override
+    {
+        // Power subtraction with a floor, which avoids the isolated
+        // "musical noise" peaks of a hard zero.
+        constexpr T kFloor = T(0.01);
+        T noisePower = this->Cut(params) * this->Cut(params);
+        this->Scale(spectrum, amplitudes, [noisePower, kFloor](T a)
+        {
+            T power = a * a;
+            T remaining = power > 0 ? T(1) - noisePower / power : T(0);
+            return std::sqrt(std::max(remaining, kFloor));
+        });
+    }
+};
+}
+
+const char* to_string(FilterKind kind)
+{
+    switch (kind)
+    {
+    case FilterKind::HardThreshold: return "Hard threshold";
+    case FilterKind::SoftThreshold: return "Soft threshold";
+    case FilterKind::Wiener: return "Wiener";
+    case FilterKind::SpectralSubtraction: return "Spectral subtraction";
+    default: return "Energy cutoff";
+    }
+}
+
+template <class T>
+std::unique_ptr<SpectrumFilter<T>> SpectrumFilter<T>::Create(FilterKind kind)
+{
+    switch (kind)
     {
-        filtered[i] = 0;
+    case FilterKind::HardThreshold: return std::make_unique<HardThresholdFilter<T>>();
+    case FilterKind::SoftThreshold: return std::make_unique<SoftThresholdFilter<T>>();
+    case FilterKind::Wiener: return std::make_unique<WienerFilter<T>>();
+    case FilterKind::SpectralSubtraction: return std::make_unique<SpectralSubtractionFilter<T>>();
+    default: return std::make_unique<EnergyCutoffFilter<T>>();
     }
+}
 
-    return filtered;
-}
\ No newline at end of file
+template class SpectrumFilter<double>;
+template class SpectrumFilter<float>;
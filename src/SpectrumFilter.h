@@ -1,13 +1,49 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 #include "math/fft.h"
 
+enum class FilterKind
+{
+    EnergyCutoff,        // keep the lowest bins holding a gamma share of the energy
+    HardThreshold,       // zero bins below the noise threshold
+    SoftThreshold,       // shrink every magnitude by the noise threshold
+    Wiener,              // gain SNR / (1 + SNR) from the estimated noise power
+    SpectralSubtraction, // subtract the noise power, keep a small spectral floor
+};
+
+constexpr size_t kFilterKindCount = 5;
+
+const char* to_string(FilterKind kind);
+
+struct FilterParams
+{
+    // Energy ratio for EnergyCutoff, 0..1.
+    double gamma = 1.0;
+    // Noise threshold for the other kernels, in multiples of the median
+    // bin amplitude (a robust noise floor when the signal is sparse).
+    double threshold = 3.0;
+};
+
+// Filter kernel working on the N/2+1 bins of a real signal's spectrum.
+// Prepare runs whenever the amplitudes change and caches everything that
+// does not depend on FilterParams; Apply then filters a caller-owned
+// spectrum in place. Neither allocates once the bin count is stable.
+//
+// T is the sample type, double or float; running sums are kept in double
+// either way. Instantiated for both in SpectrumFilter.cpp.
+template <class T>
 class SpectrumFilter
 {
 public:
-    static std::vector<Complex>
-    Apply(const std::vector<Complex>& spectrum,
-          const std::vector<double>& amplitudes,
-          double signalEnergyRatio);
-};
\ No newline at end of file
+    using ComplexT = std::complex<T>;
+
+    virtual ~SpectrumFilter() = default;
+
+    // amplitudes holds `bins` values from an n-point real transform.
+    virtual void Prepare(const T* amplitudes, size_t bins, size_t n) = 0;
+    virtual void Apply(ComplexT* spectrum, const T* amplitudes, const FilterParams& params) const = 0;
+
+    static std::unique_ptr<SpectrumFilter> Create(FilterKind kind);
+};
@@ -0,0 +1,182 @@
+#include "StreamingFilter.h"
+#include "SpectrumFilter.h"
+
+#include <stdexcept>
+
+namespace
+{
+// Summed window weight below which a sample counts as uncovered.
+constexpr double kMinWeight = 1e-12;
+}
+
+StreamingFilter::StreamingFilter(const Config& cfg)
+    : m_Config(cfg),
+      m_FrameSize(cfg.frameSize > 0 ? cfg.frameSize : 0),
+      m_HopSize(cfg.hopSize > 0 ? cfg.hopSize : 0),
+      m_Plan(get_real_fft_plan(m_FrameSize > 0 ? m_FrameSize : 1))
+{
+    if (m_FrameSize == 0 || m_HopSize == 0 || m_HopSize > m_FrameSize)
+    {
+        throw std::invalid_argument("StreamingFilter: need 0 < hopSize <= frameSize");
+    }
+
+    m_Window.resize(m_FrameSize, 1.0);
+    if (cfg.window == Window::Hann)
+    {
+        // Periodic Hann: overlapping copies sum to a constant for hop N/2, N/4, ...
+        for (size_t i = 0; i < m_FrameSize; ++i)
+        {
+            m_Window[i] = 0.5 - 0.5 * std::cos(2.0 * PI * i / m_FrameSize);
+        }
+    }
+
+    // Every sample lies in the frames at its offsets i, i + hop, ... and
+    // is normalized by their summed weight. A zero sum, as at the Hann
+    // zero when nothing overlaps, would silently output 0 there.
+    for (size_t i = 0; i < m_HopSize; ++i)
+    {
+        double sum = 0;
+        for (size_t j = i; j < m_FrameSize; j += m_HopSize) sum += m_Window[j];
+        if (sum <= kMinWeight)
+        {
+            throw std::invalid_argument("StreamingFilter: the windows leave samples uncovered; lower hopSize");
+        }
+    }
+
+    m_Frame.resize(m_FrameSize);
+    m_Windowed.resize(m_FrameSize);
+    m_Spectrum.resize(m_Plan.Bins());
+    m_Amplitudes.resize(m_Plan.Bins());
+    m_Filter = SpectrumFilter<double>::Create(cfg.filter);
+    m_Accumulator.resize(m_FrameSize);
+    m_Weight.resize(m_FrameSize);
+    m_Output.resize(m_FrameSize + m_HopSize);
+
+    Reset();
+}
+
+void StreamingFilter::Reset()
+{
+    std::fill(m_Frame.begin(), m_Frame.end(), 0.0);
+    std::fill(m_Accumulator.begin(), m_Accumulator.end(), 0.0);
+    std::fill(m_Weight.begin(), m_Weight.end(), 0.0);
+
+    m_Filled = m_FrameSize - m_HopSize;
+    m_Skip = m_Filled;
+    m_Remaining = 0;
+    m_OutputHead = 0;
+    m_OutputSize = 0;
+    m_Finished = false;
+}
+
+size_t StreamingFilter::Push(const double* samples, size_t count)
+{
+    if (m_Finished)
+    {
+        throw std::logic_error("StreamingFilter: Push after Finish");
+    }
+
+    size_t taken = 0;
+    while (taken < count)
+    {
+        Advance();
+        if (m_Filled == m_FrameSize) break;
+
+        size_t n = std::min(count - taken, m_FrameSize - m_Filled);
+        std::copy_n(samples + taken, n, m_Frame.begin() + m_Filled);
+        m_Filled += n;
+        m_Remaining += n;
+        taken += n;
+    }
+
+    Advance();
+    return taken;
+}
+
+void StreamingFilter::Finish()
+{
+    m_Finished = true;
+    Advance();
+}
+
+size_t StreamingFilter::Pull(double* out, size_t maxCount)
+{
+    size_t n = std::min(maxCount, m_OutputSize);
+    for (size_t i = 0; i < n; ++i)
+    {
+        out[i] = m_Output[(m_OutputHead + i) % m_Output.size()];
+    }
+    m_OutputHead = (m_OutputHead + n) % m_Output.size();
+    m_OutputSize -= n;
+
+    // Frames held back by a full queue can proceed now.
+    Advance();
+    return n;
+}
+
+void StreamingFilter::Advance()
+{
+    // A frame releases hopSize samples, so it only runs when they fit.
+    // After Finish the partial frame is zero-padded until every real
+    // sample has been covered by all of its frames.
+    while (OutputSpace() >= m_HopSize)
+    {
+        if (m_Finished && m_Remaining > 0)
+        {
+            std::fill(m_Frame.begin() + m_Filled, m_Frame.end(), 0.0);
+            m_Filled = m_FrameSize;
+        }
+        if (m_Filled < m_FrameSize) break;
+
+        ProcessFrame();
+    }
+}
+
+void StreamingFilter::ProcessFrame()
+{
+    for (size_t i = 0; i < m_FrameSize; ++i)
+    {
+        m_Windowed[i] = m_Frame[i] * m_Window[i];
+    }
+
+    m_Plan.Forward(m_Windowed.data(), m_Spectrum.data());
+    amplitude_spectrum(m_Spectrum.data(), m_Spectrum.size(), m_FrameSize, m_Amplitudes.data());
+    m_Filter->Prepare(m_Amplitudes.data(), m_Amplitudes.size(), m_FrameSize);
+    m_Filter->Apply(m_Spectrum.data(), m_Amplitudes.data(), { m_Config.gamma, m_Config.threshold });
+    m_Plan.Inverse(m_Spectrum.data(), m_Windowed.data());
+
+    for (size_t i = 0; i < m_FrameSize; ++i)
+    {
+        m_Accumulator[i] += m_Windowed[i];
+        m_Weight[i] += m_Window[i];
+    }
+
+    Emit(m_HopSize);
+
+    // Slide the frame and the accumulators by one hop.
+    std::copy(m_Frame.begin() + m_HopSize, m_Frame.end(), m_Frame.begin());
+    std::copy(m_Accumulator.begin() + m_HopSize, m_Accumulator.end(), m_Accumulator.begin());
+    std::copy(m_Weight.begin() + m_HopSize, m_Weight.end(), m_Weight.begin());
+    std::fill(m_Accumulator.end() - m_HopSize, m_Accumulator.end(), 0.0);
+    std::fill(m_Weight.end() - m_HopSize, m_Weight.end(), 0.0);
+    m_Filled = m_FrameSize - m_HopSize;
+}
+
+void StreamingFilter::Emit(size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (m_Skip > 0)
+        {
+            --m_Skip;
+            continue;
+        }
+        if (m_Remaining == 0) continue;
+        --m_Remaining;
+
+        double weight = m_Weight[i];
+        double value = weight > kMinWeight ? m_Accumulator[i] / weight : 0.0;
+        m_Output[(m_OutputHead + m_OutputSize) % m_Output.size()] = value;
+        ++m_OutputSize;
+    }
+}
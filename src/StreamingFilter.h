@@ -0,0 +1,90 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "math/fft.h"
+#include "SpectrumFilter.h"
+
+// Short-time version of the SignalProcessor filter for unbounded input.
+// The stream is cut into overlapping frames, each frame is windowed,
+// transformed, passed through a SpectrumFilter kernel and transformed
+// back, and the frames are overlap-added and normalized by the summed
+// window weight. Memory is fixed by frameSize; a sample leaves the filter
+// at most frameSize samples after it was pushed.
+//
+// With a rectangular window and frameSize == hopSize == signal length the
+// single frame sees the whole signal and the output matches block mode.
+class StreamingFilter
+{
+public:
+    enum class Window
+    {
+        Rectangular,
+        Hann,
+    };
+
+    struct Config
+    {
+        int frameSize = 1024;
+        int hopSize = 512;
+        Window window = Window::Hann;
+        FilterKind filter = FilterKind::EnergyCutoff;
+        float gamma = 1.0;
+        float threshold = 3.0;
+    };
+
+    // Throws std::invalid_argument unless 0 < hopSize <= frameSize and the
+    // overlapping windows cover every sample, which rules out a Hann
+    // window with hopSize == frameSize.
+    explicit StreamingFilter(const Config& cfg);
+
+    const Config& GetConfig() const { return m_Config; }
+
+    // Consumes samples until the output queue is full and returns how many
+    // were taken; Pull the results and push the rest again.
+    size_t Push(const double* samples, size_t count);
+    // Moves up to maxCount filtered samples into out, returns how many.
+    size_t Pull(double* out, size_t maxCount);
+    // Ends the stream: the partial last frame is flushed as room allows,
+    // and the output ends exactly at the last pushed sample. Push is not
+    // allowed afterwards until Reset.
+    void Finish();
+    void Reset();
+
+    size_t Available() const { return m_OutputSize; }
+    // True once Finish was called and every sample has been pulled.
+    bool IsDrained() const { return m_Finished && m_Remaining == 0 && m_OutputSize == 0; }
+    size_t Latency() const { return m_Config.frameSize; }
+
+private:
+    void Advance();
+    void ProcessFrame();
+    void Emit(size_t count);
+    size_t OutputSpace() const { return m_Output.size() - m_OutputSize; }
+
+    Config m_Config;
+    size_t m_FrameSize, m_HopSize;
+    const RealFftPlan& m_Plan;
+    std::vector<double> m_Window;
+
+    // Input samples of the frame being filled; m_Filled of them are valid.
+    std::vector<double> m_Frame;
+    size_t m_Filled = 0;
+
+    std::vector<double> m_Windowed;
+    std::vector<Complex> m_Spectrum;
+    std::vector<double> m_Amplitudes;
+    std::unique_ptr<SpectrumFilter<double>> m_Filter;
+    std::vector<double> m_Accumulator, m_Weight;
+
+    // Ring of finished samples waiting for Pull.
+    std::vector<double> m_Output;
+    size_t m_OutputHead = 0, m_OutputSize = 0;
+
+    // The stream is primed with frameSize - hopSize zeros so the first
+    // samples get the same window coverage as the rest; their output is
+    // dropped, as is everything past the last real sample after Finish.
+    size_t m_Skip = 0;
+    size_t m_Remaining = 0;
+    bool m_Finished = false;
+};
@@ -2,6 +2,9 @@
 
 #include "imgui.h"
 #include "implot.h"
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
 
 bool SinController(const char* title, SinParam& paramRef)
 {
@@ -18,22 +21,132 @@ bool SinController(const char* title, SinParam& paramRef)
     return flag;
 }
 
-void PlotRenderer(const char* title, const char* x_lable, const char* y_lable,
-                  const double* x_data, const double* y_data, int count)
+void PlotSeries::Set(const double* x, const double* y, size_t count)
+{
+    // The previous arrays may already be gone; compare against the copy.
+    double first = count > 0 ? x[0] : 0, last = count > 0 ? x[count - 1] : 0;
+    refit |= first != xFirst || last != xLast;
+    xFirst = first;
+    xLast = last;
+
+    pyramid.Build(x, y, count);
+}
+
+void PlotRenderer(const char* title, const char* x_lable, const char* y_lable, PlotSeries& series)
 {
     if (ImGui::Begin(title, nullptr,
         ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove |
         ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoTitleBar))
     {
         auto plotFlags = ImPlotFlags_NoMenus | ImPlotFlags_NoLegend;
-        auto axisFlags = ImPlotAxisFlags_AutoFit;
 
-        if (ImPlot::BeginPlot(title, x_lable, y_lable, ImGui::GetContentRegionAvail(),
-            plotFlags, axisFlags, axisFlags))
+        if (ImPlot::BeginPlot(title, ImGui::GetContentRegionAvail(), plotFlags))
         {
-            ImPlot::PlotLine(title, x_data, y_data, count);
+            // X follows the data only when its range changes, so zoom and
+            // pan survive parameter edits; Y fits whatever is visible.
+            ImPlot::SetupAxes(x_lable, y_lable, ImPlotAxisFlags_None, ImPlotAxisFlags_AutoFit);
+            size_t count = series.pyramid.Size();
+            if (series.refit && count > 0)
+            {
+                const double* x = series.pyramid.X();
+                ImPlot::SetupAxisLimits(ImAxis_X1, x[0], x[count - 1], ImPlotCond_Always);
+                series.refit = false;
+            }
+
+            ImPlotRect limits = ImPlot::GetPlotLimits();
+            series.pyramid.Query(limits.X.Min, limits.X.Max, size_t(ImPlot::GetPlotSize().x),
+                                 series.xs, series.ys);
+            ImPlot::PlotLine(title, series.xs.data(), series.ys.data(), int(series.xs.size()));
             ImPlot::EndPlot();
         }
     }
     ImGui::End();
-}
\ No newline at end of file
+}
+
+void Waterfall::Reset(int newBins, int newRows)
+{
+    Release();
+    bins = std::max(1, newBins);
+    rows = std::max(1, newRows);
+    frames = 0;
+    pixels.assign(size_t(bins) * rows, ImGui::ColorConvertFloat4ToU32(ImPlot::SampleColormap(0, ImPlotColormap_Viridis)));
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, bins, rows, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+}
+
+void Waterfall::Upload(uint64_t first, const float* levels, size_t count)
+{
+    if (texture == 0 || count == 0) return;
+    // Only the newest rows frames can be shown.
+    if (count > size_t(rows))
+    {
+        levels += (count - rows) * bins;
+        first += count - rows;
+        count = rows;
+    }
+
+    ImU32 colors[256];
+    for (int i = 0; i < 256; ++i)
+    {
+        colors[i] = ImGui::ColorConvertFloat4ToU32(ImPlot::SampleColormap(i / 255.0f, ImPlotColormap_Viridis));
+    }
+    const float scale = 255 / std::max(maxDb - minDb, 1e-3f);
+
+    // Consecutive frames sit in consecutive texture rows up to the end of
+    // the ring; each such run is one glTexSubImage2D.
+    glBindTexture(GL_TEXTURE_2D, texture);
+    for (size_t done = 0; done < count;)
+    {
+        const int row = int((first + done) % rows);
+        const size_t n = std::min(count - done, size_t(rows - row));
+        uint32_t* out = pixels.data() + size_t(row) * bins;
+        const float* in = levels + done * bins;
+        for (size_t i = 0; i < n * bins; ++i)
+        {
+            out[i] = colors[int(std::clamp((in[i] - minDb) * scale, 0.0f, 255.0f))];
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row, bins, int(n), GL_RGBA, GL_UNSIGNED_BYTE, out);
+        done += n;
+    }
+    frames = first + count;
+}
+
+void Waterfall::Release()
+{
+    if (texture != 0) glDeleteTextures(1, &texture);
+    texture = 0;
+}
+
+void WaterfallRenderer(const char* title, const Waterfall& waterfall, double hopSeconds, double binHz)
+{
+    ImGui::PushID(title);
+    ImPlot::ColormapScale("dB", waterfall.minDb, waterfall.maxDb, ImVec2(0, -1), "%g", 0, ImPlotColormap_Viridis);
+    ImGui::SameLine();
+    if (ImPlot::BeginPlot(title, ImGui::GetContentRegionAvail(), ImPlotFlags_NoMenus | ImPlotFlags_NoLegend))
+    {
+        ImPlot::SetupAxes("f, Hz", "t, sec", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+        if (waterfall.texture != 0)
+        {
+            // At most two runs of texture rows: the oldest frames up to the
+            // end of the ring, then the newest from its start.
+            const uint64_t kept = std::min<uint64_t>(waterfall.frames, waterfall.rows);
+            const double left = -0.5 * binHz, right = (waterfall.bins - 0.5) * binHz;
+            for (uint64_t f = waterfall.frames - kept; f < waterfall.frames;)
+            {
+                const int row = int(f % waterfall.rows);
+                const uint64_t n = std::min<uint64_t>(waterfall.frames - f, waterfall.rows - row);
+                // The top of the image, the later frame, is uv0.
+                ImPlot::PlotImage("##rows", ImTextureID(waterfall.texture), ImPlotPoint(left, double(f) * hopSeconds),
+                                  ImPlotPoint(right, double(f + n) * hopSeconds),
+                                  ImVec2(0, float(row + n) / waterfall.rows), ImVec2(1, float(row) / waterfall.rows));
+                f += n;
+            }
+        }
+        ImPlot::EndPlot();
+    }
+    ImGui::PopID();
+}
@@ -1,7 +1,47 @@
 #pragma once
 
 #include "../SignalProcessor.h"
+#include "../util/MinMaxPyramid.h"
+
+#include <cstdint>
+
+// A plotted series and the per-frame buffers its visible part is
+// decimated into. Set only when the data changes.
+struct PlotSeries
+{
+    MinMaxPyramid pyramid;
+    std::vector<double> xs, ys;
+    // Set when the x range changed and the axis should follow it.
+    bool refit = true;
+    double xFirst = 0, xLast = 0;
+
+    void Set(const double* x, const double* y, size_t count);
+};
+
+// Spectrogram rows in a GL texture used as a ring: frame f lives in
+// texture row f % rows, so each new frame is colored and uploaded on its
+// own and older rows are never touched again. Levels map onto the Viridis
+// colormap between minDb and maxDb; changing them needs a new upload.
+struct Waterfall
+{
+    unsigned texture = 0;
+    int bins = 0, rows = 0;
+    // Frames uploaded so far: the next frame to fetch.
+    uint64_t frames = 0;
+    float minDb = -100, maxDb = 0;
+    std::vector<uint32_t> pixels;
+
+    // (Re)creates the texture for rows frames of bins levels, all at the
+    // bottom of the scale.
+    void Reset(int bins, int rows);
+    // Colors and uploads count rows of levels for frames [first, first + count).
+    void Upload(uint64_t first, const float* levels, size_t count);
+    // Needs the GL context, so it is called explicitly before it goes.
+    void Release();
+};
 
 bool SinController(const char* title, SinParam& paramRef);
-void PlotRenderer(const char* title, const char* x_lable, const char* y_lable,
-				  const double* x_data, const double* y_data, int count);
\ No newline at end of file
+void PlotRenderer(const char* title, const char* x_lable, const char* y_lable, PlotSeries& series);
+// The retained frames of a waterfall, the newest at the top; a row spans
+// hopSeconds and a bin binHz.
+void WaterfallRenderer(const char* title, const Waterfall& waterfall, double hopSeconds, double binHz);
\ No newline at end of file
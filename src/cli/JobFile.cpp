@@ -0,0 +1,240 @@
+#include "JobFile.h"
+#include "../io/SignalFile.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+std::string Trim(const std::string& s)
+{
+    size_t begin = s.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) return {};
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+std::runtime_error ParseError(const std::string& path, int line, const std::string& what)
+{
+    return std::runtime_error(path + ":" + std::to_string(line) + ": " + what);
+}
+
+template <class T>
+T ParseValue(const std::string& value, const std::string& path, int line)
+{
+    std::istringstream in(value);
+    T result{};
+    if (!(in >> result) || !(in >> std::ws).eof())
+    {
+        throw ParseError(path, line, "invalid value '" + value + "'");
+    }
+    return result;
+}
+
+SinParam ParseSin(const std::string& value, const std::string& path, int line)
+{
+    std::istringstream in(value);
+    SinParam param;
+    if (!(in >> param.amplitude >> param.frequency >> param.phase) || !(in >> std::ws).eof())
+    {
+        throw ParseError(path, line, "expected 'amplitude frequency phase', got '" + value + "'");
+    }
+    return param;
+}
+
+FilterKind ParseFilter(const std::string& value, const std::string& path, int line)
+{
+    if (value == "cutoff") return FilterKind::EnergyCutoff;
+    if (value == "hard") return FilterKind::HardThreshold;
+    if (value == "soft") return FilterKind::SoftThreshold;
+    if (value == "wiener") return FilterKind::Wiener;
+    if (value == "subtraction") return FilterKind::SpectralSubtraction;
+    throw ParseError(path, line, "unknown filter '" + value + "'");
+}
+
+StreamingFilter::Window ParseWindow(const std::string& value, const std::string& path, int line)
+{
+    if (value == "hann") return StreamingFilter::Window::Hann;
+    if (value == "rect") return StreamingFilter::Window::Rectangular;
+    throw ParseError(path, line, "unknown window '" + value + "'");
+}
+
+std::string ParseFormat(const std::string& value, const char* extra, const std::string& path, int line)
+{
+    SignalFileFormat format;
+    if (value != extra && !parse_signal_format(value, format))
+    {
+        throw ParseError(path, line, "unknown format '" + value + "'");
+    }
+    return value;
+}
+
+CleanSource ParseClean(const std::string& value, const std::string& path, int line)
+{
+    if (value == "spectral") return CleanSource::Spectral;
+    if (value == "fir") return CleanSource::Fir;
+    throw ParseError(path, line, "unknown clean source '" + value + "'");
+}
+
+Precision ParsePrecision(const std::string& value, const std::string& path, int line)
+{
+    if (value == "double") return Precision::Double;
+    if (value == "float") return Precision::Float;
+    throw ParseError(path, line, "unknown precision '" + value + "'");
+}
+
+void ApplyKey(Job& job, const std::string& key, const std::string& value,
+              const std::string& path, int line)
+{
+    auto& cfg = job.config;
+
+    if (key == "name") job.name = value;
+    else if (key == "input") job.input = value;
+    else if (key == "inputFormat") job.inputFormat = ParseFormat(value, "text", path, line);
+    else if (key == "inputChannels") job.inputChannels = ParseValue<int>(value, path, line);
+    else if (key == "inputChannel") job.inputChannel = ParseValue<int>(value, path, line);
+    else if (key == "output") job.output = value;
+    else if (key == "outputFormat") job.outputFormat = ParseFormat(value, "csv", path, line);
+    else if (key == "stream") job.stream = ParseValue<bool>(value, path, line);
+    else if (key == "frameSize") job.streamConfig.frameSize = ParseValue<int>(value, path, line);
+    else if (key == "hopSize") job.streamConfig.hopSize = ParseValue<int>(value, path, line);
+    else if (key == "window") job.streamConfig.window = ParseWindow(value, path, line);
+    else if (key == "sampleRate")
+    {
+        cfg.sampleRate = ParseValue<int>(value, path, line);
+        job.sampleRateSet = true;
+    }
+    else if (key == "pointCount")
+    {
+        cfg.pointCount = ParseValue<int>(value, path, line);
+        job.pointCountSet = true;
+    }
+    else if (key == "seed") cfg.seed = ParseValue<uint64_t>(value, path, line);
+    else if (key == "noiseAlpha") cfg.noiseAlpha = ParseValue<float>(value, path, line);
+    else if (key == "gamma") cfg.gamma = ParseValue<float>(value, path, line);
+    else if (key == "filter") cfg.filter = ParseFilter(value, path, line);
+    else if (key == "threshold") cfg.threshold = ParseValue<float>(value, path, line);
+    else if (key == "clean") cfg.clean = ParseClean(value, path, line);
+    else if (key == "firLow") cfg.firLow = ParseValue<float>(value, path, line);
+    else if (key == "firHigh") cfg.firHigh = ParseValue<float>(value, path, line);
+    else if (key == "firTaps") cfg.firTaps = ParseValue<int>(value, path, line);
+    else if (key == "precision") cfg.precision = ParsePrecision(value, path, line);
+    else if (key == "comparePrecision") cfg.comparePrecision = ParseValue<bool>(value, path, line);
+    else if (key == "channels") cfg.channels = ParseValue<int>(value, path, line);
+    else if (key == "harmonic")
+    {
+        // The first harmonic of a section replaces the inherited list.
+        if (!job.harmonicsSet) cfg.harmonics.clear();
+        cfg.harmonics.push_back(ParseSin(value, path, line));
+        job.harmonicsSet = true;
+    }
+    else throw ParseError(path, line, "unknown key '" + key + "'");
+}
+
+std::string Resolve(const std::filesystem::path& base, const std::string& path)
+{
+    if (path.empty() || std::filesystem::path(path).is_absolute()) return path;
+    return (base / path).string();
+}
+}
+
+std::vector<Job> ParseJobFile(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("cannot open job file '" + path + "'");
+    }
+
+    Job defaults;
+    std::vector<Job> jobs;
+    Job* current = &defaults;
+
+    std::string text;
+    int line = 0;
+    while (std::getline(file, text))
+    {
+        ++line;
+        text = Trim(text.substr(0, text.find('#')));
+        if (text.empty()) continue;
+
+        if (text == "[job]")
+        {
+            jobs.push_back(defaults);
+            jobs.back().name = "job" + std::to_string(jobs.size());
+            jobs.back().harmonicsSet = false;
+            current = &jobs.back();
+            continue;
+        }
+        if (text.front() == '[')
+        {
+            throw ParseError(path, line, "unknown section '" + text + "'");
+        }
+
+        size_t eq = text.find('=');
+        if (eq == std::string::npos)
+        {
+            throw ParseError(path, line, "expected 'key = value'");
+        }
+        ApplyKey(*current, Trim(text.substr(0, eq)), Trim(text.substr(eq + 1)), path, line);
+    }
+
+    auto base = std::filesystem::path(path).parent_path();
+    for (auto& job : jobs)
+    {
+        job.input = Resolve(base, job.input);
+        job.output = Resolve(base, job.output);
+    }
+    return jobs;
+}
+
+std::shared_ptr<const SignalSource> OpenInput(Job& job)
+{
+    std::string format = job.inputFormat;
+    if (format.empty())
+    {
+        std::string extension = std::filesystem::path(job.input).extension().string();
+        if (extension == ".wav") format = "wav";
+        else if (extension == ".f32" || extension == ".f64" || extension == ".s16") format = extension.substr(1);
+        else format = "text";
+    }
+    if (format == "text")
+    {
+        return std::make_shared<MemorySignal>(LoadSamples(job.input));
+    }
+
+    SignalFileFormat raw;
+    parse_signal_format(format, raw);
+    raw.channels = job.inputChannels;
+    if (raw.channels < 1)
+    {
+        throw std::runtime_error("inputChannels must be positive");
+    }
+    auto file = std::make_shared<MappedSignalFile>(job.input, raw, job.inputChannel);
+    if (file->GetFormat().wav && !job.sampleRateSet && file->GetFormat().sampleRate > 0)
+    {
+        job.config.sampleRate = file->GetFormat().sampleRate;
+    }
+    return file;
+}
+
+std::vector<double> LoadSamples(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("cannot open input '" + path + "'");
+    }
+
+    std::vector<double> samples;
+    double value;
+    while (file >> value) samples.push_back(value);
+    if (!file.eof())
+    {
+        throw std::runtime_error("bad sample after " + std::to_string(samples.size()) +
+                                 " values in '" + path + "'");
+    }
+    return samples;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../SignalProcessor.h"
+#include "../StreamingFilter.h"
+#include "../io/SignalSource.h"
+
+// One batch job: a processor configuration plus optional recorded input.
+struct Job
+{
+    std::string name;
+    SignalProcessor::Config config;
+    // Recorded input; empty means synthetic harmonics. Text files hold one
+    // sample per line, binary files are memory-mapped.
+    std::string input;
+    // "text", one of the parse_signal_format names, or empty to go by the
+    // extension of input (.wav, .f32, .f64, .s16; anything else is text).
+    std::string inputFormat;
+    // Frame width of raw input and the channel to filter; WAV headers
+    // override the width.
+    int inputChannels = 1;
+    int inputChannel = 0;
+    // Path prefix for <output>_clean.csv and <output>_spectrum.csv;
+    // empty writes nothing but the summary line.
+    std::string output;
+    // "csv" or a parse_signal_format name for the clean signal.
+    std::string outputFormat = "csv";
+    // Filters the input with a StreamingFilter in bounded memory instead
+    // of transforming it as one block.
+    bool stream = false;
+    StreamingFilter::Config streamConfig;
+    bool pointCountSet = false;
+    bool sampleRateSet = false;
+    bool harmonicsSet = false;
+};
+
+// Parses an INI-style job file:
+//
+//     # keys before the first section are defaults for every job
+//     gamma = 0.9
+//
+//     [job]
+//     name = run1
+//     sampleRate = 1024
+//     pointCount = 4096
+//     noiseAlpha = 0.2
+//     seed = 42             # noise stream, same seed reproduces the run
+//     filter = wiener       # cutoff (uses gamma), hard, soft, wiener, subtraction
+//     threshold = 3         # noise floor in medians, for all but cutoff
+//     clean = fir           # spectral (default) or fir; fir reports the
+//                           # spectral filter's delta as spectralDelta
+//     firLow = 0            # FIR passband in Hz, 0 for a low-pass
+//     firHigh = 50
+//     firTaps = 101
+//     harmonic = 10 10 0    # amplitude frequency phase; repeat for more
+//     precision = float     # double (default) or float
+//     comparePrecision = 1  # also report the Delta of the other precision
+//     channels = 64         # noise realizations; delta is their mean and
+//                           # the CSV files hold channel 0
+//     input = capture.txt
+//     output = out/run1
+//
+// Binary input and output:
+//
+//     input = capture.wav   # PCM16 or float WAV; sampleRate defaults to
+//                           # the header's
+//     inputFormat = f32     # raw f32, f64 or s16; default by extension
+//     inputChannels = 2     # raw frame width
+//     inputChannel = 1      # channel to filter
+//     outputFormat = wav16  # csv (default), wav, wav16, wav64, f32, f64,
+//                           # s16; writes <output>_clean.<ext> with all
+//                           # channels interleaved
+//
+// Streaming, for input of any length in fixed memory; uses filter, gamma
+// and threshold, or the FIR keys with clean = fir, writes only
+// <output>_clean and reports no delta:
+//
+//     stream = 1
+//     frameSize = 4096
+//     hopSize = 2048
+//     window = hann         # hann or rect
+//
+// Relative input/output paths are resolved against the job file's
+// directory. Throws std::runtime_error with the line number on bad input.
+std::vector<Job> ParseJobFile(const std::string& path);
+
+// Opens job.input as its inputFormat says: text is loaded, binary files
+// are mapped. A WAV input also sets the sample rate unless the job does.
+std::shared_ptr<const SignalSource> OpenInput(Job& job);
+
+std::vector<double> LoadSamples(const std::string& path);
@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "JobFile.h"
+#include "io/SignalFile.h"
+#include "math/fir.h"
+#include "util/Profiler.h"
+
+namespace
+{
+// Frames per read and write; keeps the streaming path's memory fixed.
+constexpr size_t kChunkFrames = size_t(1) << 16;
+
+void WriteColumns(const std::string& path, const char* header,
+                  std::initializer_list<const std::vector<double>*> columns)
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        throw std::runtime_error("cannot write '" + path + "'");
+    }
+    out.precision(17);
+
+    out << header << '\n';
+    size_t rows = (*columns.begin())->size();
+    for (size_t i = 0; i < rows; ++i)
+    {
+        const char* separator = "";
+        for (const auto* column : columns)
+        {
+            out << separator << (*column)[i];
+            separator = ",";
+        }
+        out << '\n';
+    }
+}
+
+// Writes channels blocks of frames samples each, stored back to back, as
+// interleaved frames through a buffer of kChunkFrames.
+void WriteInterleaved(SignalFileWriter& writer, const std::vector<double>& blocks, size_t frames, size_t channels)
+{
+    std::vector<double> buffer(std::min(frames, kChunkFrames) * channels);
+    for (size_t begin = 0; begin < frames; begin += kChunkFrames)
+    {
+        size_t count = std::min(kChunkFrames, frames - begin);
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (size_t c = 0; c < channels; ++c) buffer[i * channels + c] = blocks[c * frames + begin + i];
+        }
+        writer.Write(buffer.data(), count);
+    }
+}
+
+SignalFileFormat OutputFormat(const Job& job, int channels)
+{
+    SignalFileFormat format;
+    parse_signal_format(job.outputFormat, format);
+    format.channels = channels;
+    format.sampleRate = job.config.sampleRate;
+    return format;
+}
+
+// Feeds the input through a StreamingFilter, or the FIR filter with
+// clean = fir, chunk by chunk. Mapped pages are released behind the read
+// position and the output is written as it comes, so memory stays fixed
+// however long the input is.
+void RunStream(const Job& job, const SignalSource& source)
+{
+    StreamingFilter::Config cfg = job.streamConfig;
+    cfg.filter = job.config.filter;
+    cfg.gamma = job.config.gamma;
+    cfg.threshold = job.config.threshold;
+    StreamingFilter filter(cfg);
+
+    const bool fir = job.config.clean == CleanSource::Fir;
+    std::vector<double> taps;
+    SignalProcessor::DesignFir(job.config, taps);
+    FirFilter firFilter(taps);
+
+    const auto* mapped = dynamic_cast<const MappedSignalFile*>(&source);
+    const bool csv = job.outputFormat == "csv";
+    std::unique_ptr<SignalFileWriter> writer;
+    std::ofstream text;
+    if (!job.output.empty() && csv)
+    {
+        text.open(job.output + "_clean.csv");
+        if (!text)
+        {
+            throw std::runtime_error("cannot write '" + job.output + "_clean.csv'");
+        }
+        text.precision(17);
+        text << "clean\n";
+    }
+    else if (!job.output.empty())
+    {
+        writer = std::make_unique<SignalFileWriter>(job.output + "_clean." + file_extension(OutputFormat(job, 1)),
+                                                    OutputFormat(job, 1));
+    }
+
+    std::vector<double> in(kChunkFrames), out(kChunkFrames);
+    auto write = [&](const double* samples, size_t n)
+    {
+        if (writer) writer->Write(samples, n);
+        for (size_t i = 0; text.is_open() && i < n; ++i) text << samples[i] << '\n';
+    };
+    auto drain = [&]
+    {
+        while (size_t n = filter.Pull(out.data(), out.size())) write(out.data(), n);
+    };
+    // The FIR output drops its first Delay() samples and is flushed with
+    // as many zeros, so it lines up with the input like SignalProcessor's.
+    size_t firSkip = firFilter.Delay();
+    auto filterFir = [&](const double* samples, size_t n)
+    {
+        firFilter.Process(samples, out.data(), n);
+        size_t drop = std::min(firSkip, n);
+        firSkip -= drop;
+        write(out.data() + drop, n - drop);
+    };
+
+    // pointCount only limits a stream when set; it cannot count past INT_MAX.
+    const size_t total = job.pointCountSet ? std::min(source.Size(), size_t(job.config.pointCount)) : source.Size();
+    for (size_t pos = 0; pos < total;)
+    {
+        size_t count = source.Read(pos, in.data(), std::min(kChunkFrames, total - pos));
+        if (fir) filterFir(in.data(), count);
+        for (size_t used = 0; !fir && used < count;)
+        {
+            used += filter.Push(in.data() + used, count - used);
+            drain();
+        }
+        pos += count;
+        if (mapped) mapped->ReleaseBefore(pos);
+    }
+    if (fir)
+    {
+        std::fill(in.begin(), in.end(), 0.0);
+        for (size_t left = firFilter.Delay(); left > 0;)
+        {
+            size_t n = std::min(left, in.size());
+            filterFir(in.data(), n);
+            left -= n;
+        }
+    }
+    else
+    {
+        filter.Finish();
+        while (!filter.IsDrained()) drain();
+    }
+
+    if (writer) writer->Close();
+    if (text.is_open() && !text.flush())
+    {
+        throw std::runtime_error("write error on '" + job.output + "_clean.csv'");
+    }
+}
+
+void RunJob(SignalProcessor& processor, Job& job)
+{
+    std::shared_ptr<const SignalSource> source;
+    if (!job.input.empty())
+    {
+        source = OpenInput(job);
+        if (!job.pointCountSet) job.config.pointCount = static_cast<int>(std::min<size_t>(source->Size(), INT_MAX));
+    }
+    if (job.config.pointCount < 1 || job.config.sampleRate < 1 || job.config.channels < 1)
+    {
+        throw std::runtime_error("pointCount, sampleRate and channels must be positive");
+    }
+
+    if (job.stream)
+    {
+        if (!source)
+        {
+            throw std::runtime_error("stream needs an input file");
+        }
+        RunStream(job, *source);
+        return;
+    }
+
+    processor.SetExternalSignal(std::move(source));
+    processor.Update(job.config);
+
+    if (!job.output.empty())
+    {
+        if (job.outputFormat == "csv")
+        {
+            WriteColumns(job.output + "_clean.csv", "t,input,clean",
+                         { &processor.GetTime(), &processor.GetInputSignal(), &processor.GetCleanSignal() });
+        }
+        else
+        {
+            const size_t channels = size_t(processor.GetChannelCount());
+            SignalFileFormat format = OutputFormat(job, int(channels));
+            SignalFileWriter writer(job.output + "_clean." + file_extension(format), format);
+            WriteInterleaved(writer, processor.GetCleanSignal(), size_t(job.config.pointCount), channels);
+            writer.Close();
+        }
+        WriteColumns(job.output + "_spectrum.csv", "f,input,clean",
+                     { &processor.GetFrequencies(), &processor.GetInputSpectrum(), &processor.GetCleanSpectrum() });
+    }
+}
+}
+
+int main(int argc, char** argv)
+{
+    // signalfilter-cli [--trace <trace.json>] <job-file>
+    std::string tracePath;
+    if (argc == 4 && std::string(argv[1]) == "--trace")
+    {
+        tracePath = argv[2];
+    }
+    else if (argc != 2)
+    {
+        std::cerr << "usage: signalfilter-cli [--trace <trace.json>] <job-file>\n";
+        return 2;
+    }
+
+    std::vector<Job> jobs;
+    try
+    {
+        jobs = ParseJobFile(argv[argc - 1]);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    if (!tracePath.empty()) Profiler::Get().BeginTrace();
+
+    // One summary line per job on stdout; failures are reported and skipped.
+    int failed = 0;
+    SignalProcessor processor;
+    std::printf("name,pointCount,filter,gamma,threshold,noiseAlpha,precision,delta,comparedDelta,clean,"
+                "spectralDelta\n");
+    for (auto& job : jobs)
+    {
+        try
+        {
+            RunJob(processor, job);
+            std::printf("%s,%d,%s,%g,%g,%g,%s,", job.name.c_str(), job.config.pointCount,
+                        to_string(job.config.filter), job.config.gamma, job.config.threshold,
+                        job.config.noiseAlpha, to_string(job.config.precision));
+            // Streams have no reference signal to measure against.
+            if (!job.stream) std::printf("%.9g", processor.GetDelta());
+            std::printf(",");
+            // Empty unless a block job compares precisions.
+            if (!job.stream && job.config.comparePrecision) std::printf("%.9g", processor.GetComparedDelta());
+            // The spectral filter's Delta next to the FIR one.
+            std::printf(",%s,", to_string(job.config.clean));
+            if (!job.stream && job.config.clean == CleanSource::Fir) std::printf("%.9g", processor.GetSpectralDelta());
+            std::printf("\n");
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << job.name << ": " << e.what() << '\n';
+            ++failed;
+        }
+    }
+
+    if (!tracePath.empty())
+    {
+        if (!Profiler::Get().EndTrace(tracePath))
+        {
+            std::cerr << "cannot write trace '" << tracePath << "'\n";
+            return 1;
+        }
+        for (const auto& s : Profiler::Get().GetStats())
+        {
+            std::fprintf(stderr, "%-16s n=%-4zu min %.3f  mean %.3f  p99 %.3f ms\n",
+                         s.name, s.samples, s.minMs, s.meanMs, s.p99Ms);
+        }
+    }
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+#include "SampleFeed.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+#include <vector>
+
+SampleFeed::SampleFeed(const Config& cfg, std::shared_ptr<const SignalSource> source, SpscRing<double>& ring)
+    : m_Config(cfg),
+      m_Source(std::move(source)),
+      m_Ring(ring)
+{
+    m_Config.sampleRate = std::max(1, m_Config.sampleRate);
+    m_Config.blockSize = std::max<size_t>(1, m_Config.blockSize);
+    m_Thread = std::jthread([this](std::stop_token stop) { Run(stop); });
+}
+
+SampleFeed::~SampleFeed()
+{
+    m_Thread.request_stop();
+}
+
+void SampleFeed::Run(std::stop_token stop)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    std::vector<double> block(m_Config.blockSize);
+    uint64_t first = 0;
+
+    while (!stop.stop_requested())
+    {
+        size_t count = m_Source->Read(first, block.data(), block.size());
+        if (count == 0) break;
+
+        if (m_Config.paced)
+        {
+            // Due times come from the sample index, so waking up late does
+            // not slow the feed down; it catches up with a burst.
+            auto due = start + std::chrono::duration_cast<Clock::duration>(
+                                   std::chrono::duration<double>(double(first + count) / m_Config.sampleRate));
+            std::this_thread::sleep_until(due);
+            m_Ring.Write(block.data(), count);
+        }
+        else
+        {
+            // Back-pressure instead of drops.
+            for (size_t done = 0; done < count && !stop.stop_requested();)
+            {
+                done += m_Ring.TryWrite(block.data() + done, count - done);
+                if (done < count) std::this_thread::yield();
+            }
+        }
+        first += count;
+        m_Produced.store(first, std::memory_order_relaxed);
+    }
+    m_Finished.store(true, std::memory_order_release);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "SignalSource.h"
+#include "util/SpscRing.h"
+
+// Stand-in for an acquisition thread: streams a SignalSource, typically a
+// SyntheticSignal, into a ring in blocks until the source ends.
+//
+// A paced feed releases each block when its samples would have been
+// acquired at sampleRate and, like real hardware, drops what does not fit
+// into the ring. An unpaced feed writes as fast as the consumer reads and
+// never drops, which measures the consumer's sustained throughput.
+class SampleFeed
+{
+public:
+    struct Config
+    {
+        int sampleRate = 48000;
+        size_t blockSize = 256;
+        bool paced = true;
+    };
+
+    // Starts the producer thread; the ring must outlive the feed.
+    SampleFeed(const Config& cfg, std::shared_ptr<const SignalSource> source, SpscRing<double>& ring);
+    ~SampleFeed();
+
+    SampleFeed(const SampleFeed&) = delete;
+    SampleFeed& operator=(const SampleFeed&) = delete;
+
+    const Config& GetConfig() const { return m_Config; }
+
+    // Samples read from the source so far, written or dropped.
+    uint64_t Produced() const { return m_Produced.load(std::memory_order_relaxed); }
+    bool IsFinished() const { return m_Finished.load(std::memory_order_acquire); }
+
+private:
+    void Run(std::stop_token stop);
+
+    Config m_Config;
+    std::shared_ptr<const SignalSource> m_Source;
+    SpscRing<double>& m_Ring;
+    std::atomic<uint64_t> m_Produced{ 0 };
+    std::atomic<bool> m_Finished{ false };
+
+    std::jthread m_Thread;
+};
@@ -0,0 +1,372 @@
+#include "SignalFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+constexpr uint16_t kWavPcm = 1;
+constexpr uint16_t kWavFloat = 3;
+constexpr uint16_t kWavExtensible = 0xfffe;
+constexpr size_t kWavHeaderBytes = 44;
+
+uint16_t read_u16(const uint8_t* p)
+{
+    return uint16_t(p[0] | (p[1] << 8));
+}
+
+uint32_t read_u32(const uint8_t* p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+void put_u16(uint8_t* p, uint16_t v)
+{
+    p[0] = uint8_t(v);
+    p[1] = uint8_t(v >> 8);
+}
+
+void put_u32(uint8_t* p, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) p[i] = uint8_t(v >> (8 * i));
+}
+
+// Samples are copied out of the mapping bytewise: WAV data need not be
+// aligned for the sample type.
+template <class T>
+T decode(SampleEncoding encoding, const uint8_t* p)
+{
+    switch (encoding)
+    {
+    case SampleEncoding::Int16:
+    {
+        int16_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return T(v) * T(1.0 / 32768.0);
+    }
+    case SampleEncoding::Float32:
+    {
+        float v;
+        std::memcpy(&v, p, sizeof(v));
+        return T(v);
+    }
+    default:
+    {
+        double v;
+        std::memcpy(&v, p, sizeof(v));
+        return T(v);
+    }
+    }
+}
+
+void encode(SampleEncoding encoding, double x, uint8_t* p)
+{
+    switch (encoding)
+    {
+    case SampleEncoding::Int16:
+    {
+        double scaled = std::round(x * 32768.0);
+        auto v = int16_t(std::clamp(scaled, -32768.0, 32767.0));
+        std::memcpy(p, &v, sizeof(v));
+        break;
+    }
+    case SampleEncoding::Float32:
+    {
+        auto v = float(x);
+        std::memcpy(p, &v, sizeof(v));
+        break;
+    }
+    case SampleEncoding::Float64:
+        std::memcpy(p, &x, sizeof(x));
+        break;
+    }
+}
+}
+
+size_t bytes_per_sample(SampleEncoding encoding)
+{
+    switch (encoding)
+    {
+    case SampleEncoding::Int16: return 2;
+    case SampleEncoding::Float32: return 4;
+    default: return 8;
+    }
+}
+
+bool parse_signal_format(const std::string& name, SignalFileFormat& format)
+{
+    struct Named
+    {
+        const char* name;
+        SampleEncoding encoding;
+        bool wav;
+    };
+    static const Named kFormats[] = {
+        { "wav", SampleEncoding::Float32, true },
+        { "wav16", SampleEncoding::Int16, true },
+        { "wav64", SampleEncoding::Float64, true },
+        { "f32", SampleEncoding::Float32, false },
+        { "f64", SampleEncoding::Float64, false },
+        { "s16", SampleEncoding::Int16, false },
+    };
+
+    for (const auto& f : kFormats)
+    {
+        if (name == f.name)
+        {
+            format.encoding = f.encoding;
+            format.wav = f.wav;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* to_string(const SignalFileFormat& format)
+{
+    switch (format.encoding)
+    {
+    case SampleEncoding::Int16: return format.wav ? "wav16" : "s16";
+    case SampleEncoding::Float32: return format.wav ? "wav" : "f32";
+    default: return format.wav ? "wav64" : "f64";
+    }
+}
+
+const char* file_extension(const SignalFileFormat& format)
+{
+    return format.wav ? "wav" : to_string(format);
+}
+
+MappedSignalFile::MappedSignalFile(const std::string& path, const SignalFileFormat& rawFormat, int channel)
+    : m_File(path),
+      m_Format(rawFormat),
+      m_Channel(channel)
+{
+    const uint8_t* data = m_File.Data();
+    if (m_File.Size() >= 12 && std::memcmp(data, "RIFF", 4) == 0 && std::memcmp(data + 8, "WAVE", 4) == 0)
+    {
+        ParseWav(path);
+    }
+    else
+    {
+        m_Format.wav = false;
+        m_DataOffset = 0;
+        m_FrameBytes = bytes_per_sample(m_Format.encoding) * size_t(std::max(1, m_Format.channels));
+        m_Frames = m_File.Size() / m_FrameBytes;
+    }
+
+    if (m_Channel < 0 || m_Channel >= m_Format.channels)
+    {
+        throw std::runtime_error("'" + path + "' has no channel " + std::to_string(m_Channel));
+    }
+}
+
+void MappedSignalFile::ParseWav(const std::string& path)
+{
+    const uint8_t* data = m_File.Data();
+    const size_t size = m_File.Size();
+    bool haveFormat = false;
+
+    // Chunks follow the 12-byte RIFF header, each padded to an even size.
+    size_t pos = 12;
+    while (pos + 8 <= size)
+    {
+        const uint8_t* chunk = data + pos;
+        uint64_t length = read_u32(chunk + 4);
+        size_t body = pos + 8;
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && length >= 16 && body + 16 <= size)
+        {
+            uint16_t tag = read_u16(data + body);
+            uint16_t channels = read_u16(data + body + 2);
+            uint32_t rate = read_u32(data + body + 4);
+            uint16_t bits = read_u16(data + body + 14);
+            if (tag == kWavExtensible && length >= 40 && body + 26 <= size)
+            {
+                // The sub-format GUID starts with the plain format tag.
+                tag = read_u16(data + body + 24);
+            }
+
+            if (tag == kWavPcm && bits == 16) m_Format.encoding = SampleEncoding::Int16;
+            else if (tag == kWavFloat && bits == 32) m_Format.encoding = SampleEncoding::Float32;
+            else if (tag == kWavFloat && bits == 64) m_Format.encoding = SampleEncoding::Float64;
+            else
+            {
+                throw std::runtime_error("'" + path + "': unsupported WAV encoding (format " +
+                                         std::to_string(tag) + ", " + std::to_string(bits) + " bits)");
+            }
+            if (channels == 0)
+            {
+                throw std::runtime_error("'" + path + "': WAV header without channels");
+            }
+            m_Format.wav = true;
+            m_Format.channels = channels;
+            m_Format.sampleRate = int(rate);
+            haveFormat = true;
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0)
+        {
+            if (!haveFormat)
+            {
+                throw std::runtime_error("'" + path + "': WAV data before its format");
+            }
+            // Writers that stream often leave the size unset; the data
+            // then runs to the end of the file.
+            m_DataOffset = body;
+            uint64_t available = size - body;
+            if (length == 0 || length == 0xffffffffu || length > available) length = available;
+            m_FrameBytes = bytes_per_sample(m_Format.encoding) * size_t(m_Format.channels);
+            m_Frames = size_t(length / m_FrameBytes);
+            return;
+        }
+
+        pos = body + size_t(length) + (length & 1);
+    }
+    throw std::runtime_error("'" + path + "': WAV file without data");
+}
+
+template <class T>
+size_t MappedSignalFile::ReadAs(size_t offset, T* out, size_t count) const
+{
+    if (offset >= m_Frames) return 0;
+    count = std::min(count, m_Frames - offset);
+
+    const size_t sampleBytes = bytes_per_sample(m_Format.encoding);
+    const uint8_t* p = m_File.Data() + m_DataOffset + offset * m_FrameBytes + m_Channel * sampleBytes;
+    const SampleEncoding encoding = m_Format.encoding;
+    for (size_t i = 0; i < count; ++i, p += m_FrameBytes)
+    {
+        out[i] = decode<T>(encoding, p);
+    }
+    return count;
+}
+
+size_t MappedSignalFile::Read(size_t offset, double* out, size_t count) const
+{
+    return ReadAs(offset, out, count);
+}
+
+size_t MappedSignalFile::Read(size_t offset, float* out, size_t count) const
+{
+    return ReadAs(offset, out, count);
+}
+
+void MappedSignalFile::ReleaseBefore(size_t frame) const
+{
+    frame = std::min(frame, m_Frames);
+    m_File.Release(0, m_DataOffset + frame * m_FrameBytes);
+}
+
+SignalFileWriter::SignalFileWriter(const std::string& path, const SignalFileFormat& format)
+    : m_Path(path),
+      m_Format(format),
+      m_Buffer(kBufferBytes)
+{
+    m_Format.channels = std::max(1, m_Format.channels);
+    m_File = std::fopen(path.c_str(), "wb");
+    if (!m_File)
+    {
+        throw std::runtime_error("cannot write '" + path + "'");
+    }
+    // Sizes are filled in by Close.
+    if (m_Format.wav) WriteWavHeader(0);
+}
+
+SignalFileWriter::~SignalFileWriter()
+{
+    if (!m_File) return;
+    try
+    {
+        Close();
+    }
+    catch (const std::exception&)
+    {
+    }
+}
+
+void SignalFileWriter::Write(const double* samples, size_t frames)
+{
+    const size_t sampleBytes = bytes_per_sample(m_Format.encoding);
+    const size_t count = frames * size_t(m_Format.channels);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (m_Used + sampleBytes > m_Buffer.size()) Flush();
+        encode(m_Format.encoding, samples[i], m_Buffer.data() + m_Used);
+        m_Used += sampleBytes;
+    }
+    m_DataBytes += count * sampleBytes;
+}
+
+void SignalFileWriter::Flush()
+{
+    if (m_Used > 0 && std::fwrite(m_Buffer.data(), 1, m_Used, m_File) != m_Used)
+    {
+        throw std::runtime_error("write error on '" + m_Path + "'");
+    }
+    m_Used = 0;
+}
+
+void SignalFileWriter::Close()
+{
+    if (!m_File) return;
+
+    std::FILE* file = m_File;
+    bool ok = true;
+    try
+    {
+        Flush();
+        if (m_Format.wav)
+        {
+            if (m_DataBytes > std::numeric_limits<uint32_t>::max() - (kWavHeaderBytes - 8))
+            {
+                throw std::runtime_error("'" + m_Path + "': WAV data exceeds 4 GiB, use a raw format");
+            }
+            ok = std::fseek(file, 0, SEEK_SET) == 0;
+            if (ok) WriteWavHeader(m_DataBytes);
+        }
+    }
+    catch (...)
+    {
+        std::fclose(file);
+        m_File = nullptr;
+        throw;
+    }
+
+    ok = std::fclose(file) == 0 && ok;
+    m_File = nullptr;
+    if (!ok)
+    {
+        throw std::runtime_error("write error on '" + m_Path + "'");
+    }
+}
+
+void SignalFileWriter::WriteWavHeader(uint64_t dataBytes)
+{
+    const uint16_t channels = uint16_t(m_Format.channels);
+    const uint16_t bits = uint16_t(8 * bytes_per_sample(m_Format.encoding));
+    const uint16_t blockAlign = uint16_t(channels * bits / 8);
+    const uint32_t rate = uint32_t(std::max(1, m_Format.sampleRate));
+
+    uint8_t header[kWavHeaderBytes];
+    std::memcpy(header, "RIFF", 4);
+    put_u32(header + 4, uint32_t(kWavHeaderBytes - 8 + dataBytes));
+    std::memcpy(header + 8, "WAVE", 4);
+    std::memcpy(header + 12, "fmt ", 4);
+    put_u32(header + 16, 16);
+    put_u16(header + 20, m_Format.encoding == SampleEncoding::Int16 ? kWavPcm : kWavFloat);
+    put_u16(header + 22, channels);
+    put_u32(header + 24, rate);
+    put_u32(header + 28, rate * blockAlign);
+    put_u16(header + 32, blockAlign);
+    put_u16(header + 34, bits);
+    std::memcpy(header + 36, "data", 4);
+    put_u32(header + 40, uint32_t(dataBytes));
+
+    if (std::fwrite(header, 1, sizeof(header), m_File) != sizeof(header))
+    {
+        throw std::runtime_error("write error on '" + m_Path + "'");
+    }
+}
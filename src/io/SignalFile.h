@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "SignalSource.h"
+#include "util/MappedFile.h"
+
+// Sample encodings of raw and WAV files. Int16 maps [-32768, 32767] onto
+// [-1, 1); floats are stored as they are. Files are little-endian.
+enum class SampleEncoding
+{
+    Int16,
+    Float32,
+    Float64,
+};
+
+size_t bytes_per_sample(SampleEncoding encoding);
+
+// Interleaved frames of `channels` samples, either headerless or in a
+// WAV file (PCM 16-bit or IEEE float).
+struct SignalFileFormat
+{
+    SampleEncoding encoding = SampleEncoding::Float32;
+    bool wav = false;
+    int channels = 1;
+    // Stored in WAV headers only.
+    int sampleRate = 0;
+};
+
+// Format names used by the job files: "wav" (float32), "wav16", "wav64",
+// and raw "f32", "f64" and "s16". Sets the encoding and container of
+// format and leaves channels and sampleRate; returns false for any other
+// name.
+bool parse_signal_format(const std::string& name, SignalFileFormat& format);
+// The name parse_signal_format accepts for format.
+const char* to_string(const SignalFileFormat& format);
+// Extension of a name, e.g. "wav" for wav16 and "f32" for raw float32.
+const char* file_extension(const SignalFileFormat& format);
+
+// One channel of a raw or WAV file, memory-mapped. Reads convert straight
+// from the mapping; nothing is loaded up front, so the file may be larger
+// than memory.
+class MappedSignalFile : public SignalSource
+{
+public:
+    // A WAV header, when the file has one, defines the format; other files
+    // are read as rawFormat. Throws std::runtime_error on unreadable files,
+    // unsupported WAV encodings and channels out of range.
+    MappedSignalFile(const std::string& path, const SignalFileFormat& rawFormat, int channel = 0);
+
+    const SignalFileFormat& GetFormat() const { return m_Format; }
+    int GetChannel() const { return m_Channel; }
+
+    size_t Size() const override { return m_Frames; }
+    size_t Read(size_t offset, double* out, size_t count) const override;
+    size_t Read(size_t offset, float* out, size_t count) const override;
+
+    // Drops the pages of frames before `frame` from memory; for a single
+    // pass over a large file, so that its footprint stays bounded.
+    void ReleaseBefore(size_t frame) const;
+
+private:
+    void ParseWav(const std::string& path);
+    template <class T>
+    size_t ReadAs(size_t offset, T* out, size_t count) const;
+
+    MappedFile m_File;
+    SignalFileFormat m_Format;
+    int m_Channel = 0;
+    // First frame and frame count inside the mapping.
+    size_t m_DataOffset = 0;
+    size_t m_Frames = 0;
+    size_t m_FrameBytes = 0;
+};
+
+// Writes interleaved frames to a raw or WAV file through a fixed buffer,
+// so memory does not grow with the length of the output.
+class SignalFileWriter
+{
+public:
+    static constexpr size_t kBufferBytes = size_t(1) << 20;
+
+    // Throws std::runtime_error when the file cannot be created.
+    SignalFileWriter(const std::string& path, const SignalFileFormat& format);
+    // Closes the file if Close was not called; errors are then ignored.
+    ~SignalFileWriter();
+
+    SignalFileWriter(const SignalFileWriter&) = delete;
+    SignalFileWriter& operator=(const SignalFileWriter&) = delete;
+
+    // Appends frames * channels samples, channel-interleaved. Int16 output
+    // is rounded and clipped to its range.
+    void Write(const double* samples, size_t frames);
+    // Flushes the buffer and completes the WAV header. Throws on write
+    // errors and on WAV data beyond the format's 4 GiB limit.
+    void Close();
+
+    uint64_t FramesWritten() const { return m_DataBytes / (bytes_per_sample(m_Format.encoding) * m_Format.channels); }
+
+private:
+    void Flush();
+    void WriteWavHeader(uint64_t dataBytes);
+
+    std::string m_Path;
+    SignalFileFormat m_Format;
+    std::FILE* m_File = nullptr;
+    std::vector<uint8_t> m_Buffer;
+    size_t m_Used = 0;
+    uint64_t m_DataBytes = 0;
+};
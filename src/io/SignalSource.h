@@ -0,0 +1,48 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Random-access mono samples that are read in pieces, so a source can be
+// larger than memory. Reads convert to the caller's sample type.
+class SignalSource
+{
+public:
+    virtual ~SignalSource() = default;
+
+    virtual size_t Size() const = 0;
+
+    // Converts the samples of [offset, offset + count) that exist into
+    // out and returns how many there were.
+    virtual size_t Read(size_t offset, double* out, size_t count) const = 0;
+    virtual size_t Read(size_t offset, float* out, size_t count) const = 0;
+};
+
+// Samples held in memory.
+class MemorySignal : public SignalSource
+{
+public:
+    explicit MemorySignal(std::vector<double> samples)
+        : m_Samples(std::move(samples))
+    {
+    }
+
+    size_t Size() const override { return m_Samples.size(); }
+    size_t Read(size_t offset, double* out, size_t count) const override { return ReadAs(offset, out, count); }
+    size_t Read(size_t offset, float* out, size_t count) const override { return ReadAs(offset, out, count); }
+
+private:
+    template <class T>
+    size_t ReadAs(size_t offset, T* out, size_t count) const
+    {
+        if (offset >= m_Samples.size()) return 0;
+        count = std::min(count, m_Samples.size() - offset);
+        std::transform(m_Samples.begin() + offset, m_Samples.begin() + offset + count, out,
+                       [](double x) { return T(x); });
+        return count;
+    }
+
+    std::vector<double> m_Samples;
+};
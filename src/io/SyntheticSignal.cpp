@@ -0,0 +1,74 @@
+#include "SyntheticSignal.h"
+#include "math/noise.h"
+
+#include <algorithm>
+#include <cmath>
+
+SyntheticSignal::SyntheticSignal(int sampleRate, const std::vector<SinParam>& harmonics, float noiseAlpha,
+                                 uint64_t seed)
+    : m_Seed(seed)
+{
+    // Mean power of a sinusoid is A^2 / 2.
+    const double dt = 1.0 / std::max(1, sampleRate);
+    double power = 0;
+    for (const auto& h : harmonics)
+    {
+        m_Tones.push_back({ h.amplitude, 2 * PI * h.frequency * dt, h.phase });
+        power += 0.5 * double(h.amplitude) * h.amplitude;
+    }
+    m_NoiseScale = std::sqrt(power * std::max(0.0f, noiseAlpha));
+}
+
+void SyntheticSignal::Block(size_t first, double* out, size_t count) const
+{
+    // Every aligned block starts its phasors from exact phases; tones are
+    // summed a few at a time so nothing is allocated per read.
+    const size_t start = first / kBlock * kBlock;
+    const size_t skip = first - start;
+    double tones[kBlock], noise[kBlock];
+    gaussian_noise(m_Seed, start, noise, kBlock);
+    for (size_t i = 0; i < kBlock; ++i) noise[i] *= m_NoiseScale;
+
+    constexpr size_t kGroup = 8;
+    Sinusoid group[kGroup];
+    for (size_t t = 0; t < m_Tones.size(); t += kGroup)
+    {
+        size_t n = std::min(kGroup, m_Tones.size() - t);
+        for (size_t k = 0; k < n; ++k)
+        {
+            group[k] = m_Tones[t + k];
+            group[k].phase = std::fmod(group[k].phase + group[k].omega * double(start), 2 * PI);
+        }
+        synthesize_sinusoids(group, n, tones, skip + count);
+        for (size_t i = skip; i < skip + count; ++i) noise[i] += tones[i];
+    }
+    std::copy_n(noise + skip, count, out);
+}
+
+size_t SyntheticSignal::Read(size_t offset, double* out, size_t count) const
+{
+    count = std::min(count, Size() - offset);
+    for (size_t done = 0; done < count;)
+    {
+        size_t first = offset + done;
+        size_t n = std::min(count - done, kBlock - first % kBlock);
+        Block(first, out + done, n);
+        done += n;
+    }
+    return count;
+}
+
+size_t SyntheticSignal::Read(size_t offset, float* out, size_t count) const
+{
+    double block[kBlock];
+    count = std::min(count, Size() - offset);
+    for (size_t done = 0; done < count;)
+    {
+        size_t first = offset + done;
+        size_t n = std::min(count - done, kBlock - first % kBlock);
+        Block(first, block, n);
+        std::copy_n(block, n, out + done);
+        done += n;
+    }
+    return count;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "SignalSource.h"
+#include "SignalProcessor.h"
+#include "math/oscillator.h"
+
+// Endless harmonics plus Gaussian noise, scaled as in SignalProcessor:
+// noiseAlpha is the noise to signal energy ratio. Sample i depends only on
+// i, however the stream is cut into reads, so a live feed can be
+// reproduced offline.
+class SyntheticSignal : public SignalSource
+{
+public:
+    // Phasors are re-seeded at every multiple of this many samples.
+    static constexpr size_t kBlock = 256;
+
+    SyntheticSignal(int sampleRate, const std::vector<SinParam>& harmonics, float noiseAlpha, uint64_t seed);
+
+    size_t Size() const override { return std::numeric_limits<size_t>::max(); }
+    size_t Read(size_t offset, double* out, size_t count) const override;
+    size_t Read(size_t offset, float* out, size_t count) const override;
+
+private:
+    // Samples [first, first + count) of one aligned block.
+    void Block(size_t first, double* out, size_t count) const;
+
+    std::vector<Sinusoid> m_Tones;
+    uint64_t m_Seed;
+    double m_NoiseScale = 0;
+};
@@ -1,86 +1,1195 @@
 #include "fft.h"
+#include "fft_kernels.h"
+#include "util/ParallelFor.h"
 
-std::vector<Complex> pad_to_power_of_two(const std::vector<Complex>& input)
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
 {
-    size_t n = input.size();
+template <class T>
+struct SplitBuffer
+{
+    std::vector<T> re, im;
 
-    size_t new_size = 1;
-    while (new_size < n)
+    void Reserve(size_t n)
     {
-        new_size *= 2;
+        if (re.size() < n)
+        {
+            re.resize(n);
+            im.resize(n);
+        }
     }
+};
 
-    std::vector<Complex> padded(new_size);
+// Per-thread scratch. Nested steps of one transform use separate slots
+// so they never overwrite each other's data.
+enum ScratchSlot
+{
+    kEntryScratch,      // interleaved and real-input conversions
+    kPermuteScratch,    // out-of-place digit reversal
+    kBluesteinScratch,  // zero-padded chirp convolution
+    kBatchScratch,      // interleaved copy of a group of channels
+    kFourStepScratch,   // rows of a four-step transform
+    kColumnScratch,     // a group of columns of a four-step transform
+    kChannelScratch,    // one channel of a batch on a four-step plan
+    kScratchSlotCount,
+};
+
+template <class T>
+SplitBuffer<T>& thread_scratch(ScratchSlot slot, size_t n)
+{
+    thread_local SplitBuffer<T> buffers[kScratchSlotCount];
+    buffers[slot].Reserve(n);
+    return buffers[slot];
+}
+
+// Radices in stage order. Equal radices are mirrored around the middle so
+// the digit reversal stays an involution whenever that is possible.
+std::vector<uint32_t> plan_radices(size_t n, size_t& remainder)
+{
+    size_t count[8] = {};
+    for (uint32_t r : { 4u, 2u, 3u, 5u, 7u })
+    {
+        while (n % r == 0)
+        {
+            ++count[r];
+            n /= r;
+        }
+    }
+    remainder = n;
+
+    std::vector<uint32_t> left, middle;
+    for (uint32_t r : { 7u, 5u, 3u, 4u, 2u })
+    {
+        left.insert(left.end(), count[r] / 2, r);
+        if (count[r] % 2) middle.push_back(r);
+    }
+
+    std::vector<uint32_t> radices = left;
+    radices.insert(radices.end(), middle.begin(), middle.end());
+    radices.insert(radices.end(), left.rbegin(), left.rend());
+    return radices;
+}
+
+const FftKernelSet kScalarKernels = make_fft_kernel_set<ScalarVec<double>, ScalarVec<float>>();
+
+SimdLevel detect_simd_level()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (fft_kernels_avx512() && __builtin_cpu_supports("avx512f")) return SimdLevel::Avx512;
+    if (fft_kernels_avx2() && __builtin_cpu_supports("avx2")) return SimdLevel::Avx2;
+    if (fft_kernels_sse2() && __builtin_cpu_supports("sse2")) return SimdLevel::Sse2;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    bool ymmState = (xcr0 & 0x6) == 0x6;
+    bool zmmState = (xcr0 & 0xe6) == 0xe6;
+
+    bool avx2 = false, avx512 = false;
+    if (maxLeaf >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        avx2 = ymmState && (info[1] & (1 << 5)) != 0;
+        avx512 = zmmState && (info[1] & (1 << 16)) != 0;
+    }
+
+    if (fft_kernels_avx512() && avx512) return SimdLevel::Avx512;
+    if (fft_kernels_avx2() && avx2) return SimdLevel::Avx2;
+    if (fft_kernels_sse2() && sse2) return SimdLevel::Sse2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+const FftKernelSet* kernels_for(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::Avx512: return fft_kernels_avx512();
+    case SimdLevel::Avx2: return fft_kernels_avx2();
+    case SimdLevel::Sse2: return fft_kernels_sse2();
+    default: return &kScalarKernels;
+    }
+}
+
+// Channels per parallel_for task of a batch transform, in multiples of
+// one AVX-512 double register. An even share per thread keeps the rows
+// long and contiguous; when a group is copied into scratch, it is also
+// kept within kBatchBytes so the copy stays in cache for the transform.
+constexpr size_t kBatchGroup = 8;
+constexpr size_t kBatchBytes = size_t(1) << 20;
+
+size_t batch_group(size_t channels, size_t scratchBytesPerChannel)
+{
+    size_t threads = std::max<size_t>(1, parallel_concurrency());
+    size_t group = (channels + threads - 1) / threads;
+    if (scratchBytesPerChannel) group = std::min(group, kBatchBytes / scratchBytesPerChannel);
+    return std::max(kBatchGroup, group / kBatchGroup * kBatchGroup);
+}
+
+// Arguments of a four-step transform, shared by its passes in the same
+// way as BatchArgs.
+template <class T>
+struct FourStepArgs
+{
+    T* re;
+    T* im;
+    T* sr;
+    T* si;
+    T scale;
+};
+
+// The four-step split n = n1 * n2 with n1 the largest divisor not above
+// sqrt(n), so rows are at least as long as columns.
+size_t four_step_columns(size_t n)
+{
+    size_t n1 = static_cast<size_t>(std::sqrt(double(n)));
+    while (n1 * n1 > n) --n1;
+    while (n % n1 != 0) --n1;
+    return n1;
+}
+
+// Visits every (i, c) with i < n and c < count, points in tiles of one
+// cache line, so that a split side (channel after channel) and a row side
+// (point after point) are both walked in short runs.
+constexpr size_t kTransposeTile = 8;
+
+template <class Body>
+void for_each_tiled(size_t n, size_t count, Body&& body)
+{
+    for (size_t i0 = 0; i0 < n; i0 += kTransposeTile)
+    {
+        size_t i1 = std::min(n, i0 + kTransposeTile);
+        for (size_t c = 0; c < count; ++c)
+        {
+            for (size_t i = i0; i < i1; ++i) body(i, c);
+        }
+    }
+}
+
+// Arguments of a batch call. Tasks capture them by reference as a whole,
+// which keeps the parallel_for body within std::function's inline
+// storage, so a batch at a known size does not allocate.
+template <class In, class Out>
+struct BatchArgs
+{
+    In in;
+    Out out;
+    size_t channels;
+    BatchLayout layout;
+};
+
+// Point i of channel c of a batch is at c * channel + i * point.
+struct BatchStrides
+{
+    size_t channel, point;
+};
+
+inline BatchStrides batch_strides(BatchLayout layout, size_t n, size_t channels)
+{
+    return layout == BatchLayout::Interleaved ? BatchStrides{ 1, channels } : BatchStrides{ n, 1 };
+}
+
+// Real-transform post- and pre-processing of count channels whose
+// half-size transforms are stored in rows (point k of channel c at
+// k * count + c). Channels are the inner loop so the rows are read in
+// order; every channel goes through the single-channel operations.
+//
+// Z[k] packs the even (E) and odd (O) sample spectra:
+// E[k] = (Z[k] + conj(Z[m-k])) / 2, O[k] = (Z[k] - conj(Z[m-k])) / 2i,
+// and X[k] = E[k] + W^k O[k].
+template <class T>
+void untangle_half(const T* zr, const T* zi, size_t count, const std::complex<T>* twiddles,
+                   size_t m, std::complex<T>* bins, BatchStrides out)
+{
+    using ComplexT = std::complex<T>;
+
+    for (size_t c = 0; c < count; ++c)
+    {
+        bins[c * out.channel] = zr[c] + zi[c];
+        bins[c * out.channel + m * out.point] = zr[c] - zi[c];
+    }
+
+    for (size_t k = 1; k < m; ++k)
+    {
+        for (size_t c = 0; c < count; ++c)
+        {
+            ComplexT a(zr[k * count + c], zi[k * count + c]);
+            ComplexT b(zr[(m - k) * count + c], -zi[(m - k) * count + c]);
+
+            ComplexT even = T(0.5) * (a + b);
+            ComplexT odd = ComplexT(0, T(-0.5)) * (a - b);
+            bins[c * out.channel + k * out.point] = even + twiddles[k] * odd;
+        }
+    }
+}
+
+template <class T>
+void tangle_half(const std::complex<T>* bins, BatchStrides in, const std::complex<T>* twiddles,
+                 size_t m, T* zr, T* zi, size_t count)
+{
+    using ComplexT = std::complex<T>;
+
+    for (size_t k = 0; k < m; ++k)
+    {
+        for (size_t c = 0; c < count; ++c)
+        {
+            ComplexT a = bins[c * in.channel + k * in.point];
+            ComplexT b = std::conj(bins[c * in.channel + (m - k) * in.point]);
+
+            ComplexT even = T(0.5) * (a + b);
+            ComplexT odd = T(0.5) * (a - b) * std::conj(twiddles[k]);
+            ComplexT z = even + ComplexT(0, 1) * odd;
+            zr[k * count + c] = z.real();
+            zi[k * count + c] = z.imag();
+        }
+    }
+}
+
+std::atomic<SimdLevel>& active_level()
+{
+    static std::atomic<SimdLevel> level{ fft_max_simd_level() };
+    return level;
+}
+}
+
+SimdLevel fft_max_simd_level()
+{
+    static const SimdLevel level = detect_simd_level();
+    return level;
+}
+
+SimdLevel fft_simd_level()
+{
+    return active_level().load(std::memory_order_relaxed);
+}
+
+void fft_set_simd_level(SimdLevel level)
+{
+    active_level().store(std::min(level, fft_max_simd_level()), std::memory_order_relaxed);
+}
+
+const FftKernelSet& fft_active_kernels()
+{
+    return *kernels_for(fft_simd_level());
+}
+
+const char* to_string(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::Avx512: return "AVX-512";
+    case SimdLevel::Avx2: return "AVX2";
+    case SimdLevel::Sse2: return "SSE2";
+    default: return "Scalar";
+    }
+}
+
+namespace
+{
+size_t default_four_step_min_size()
+{
+    static const size_t size = size_t(1) << (parallel_concurrency() > 1 ? 18 : 22);
+    return size;
+}
+
+std::atomic<size_t>& four_step_override()
+{
+    static std::atomic<size_t> size{ 0 };
+    return size;
+}
+}
+
+size_t four_step_min_size()
+{
+    size_t size = four_step_override().load(std::memory_order_relaxed);
+    return size > 0 ? size : default_four_step_min_size();
+}
+
+void set_four_step_min_size(size_t n)
+{
+    four_step_override().store(n, std::memory_order_relaxed);
+}
+
+template <class T>
+BasicFftPlan<T>::BasicFftPlan(size_t n)
+    : m_Size(n)
+{
+    if (n == 0)
+    {
+        throw std::invalid_argument("FftPlan: size must be positive");
+    }
+
+    size_t remainder = 1;
+    std::vector<uint32_t> radices = plan_radices(n, remainder);
+
+    size_t n1 = remainder == 1 && n >= four_step_min_size() ? four_step_columns(n) : 1;
+    if (n1 > 1)
+    {
+        // Sub-plans are iterative at the default threshold; a lowered one
+        // can make them four-step too, down to the smallest factors.
+        m_Columns = &get_fft_plan<T>(n1);
+        m_Rows = &get_fft_plan<T>(n / n1);
+        // A column group and its copy stay within kBatchBytes.
+        m_StepGroup = std::max(kBatchGroup, kBatchBytes / (2 * n1 * sizeof(T)) / kBatchGroup * kBatchGroup);
+        m_StepGroup = std::min(m_StepGroup, n / n1);
+
+        // Exponents are reduced mod n in integers to keep the angles exact.
+        auto twiddle = [n](uint64_t e, T& re, T& im)
+        {
+            double angle = -2.0 * PI * static_cast<double>(e % n) / n;
+            re = T(std::cos(angle));
+            im = T(std::sin(angle));
+        };
+        while ((size_t(1) << (2 * m_StepShift)) < n) ++m_StepShift;
+        const size_t low = size_t(1) << m_StepShift;
+        const size_t high = (n + low - 1) / low;
+        m_StepLowRe.resize(low);
+        m_StepLowIm.resize(low);
+        for (size_t j = 0; j < low; ++j) twiddle(j, m_StepLowRe[j], m_StepLowIm[j]);
+        m_StepHighRe.resize(high);
+        m_StepHighIm.resize(high);
+        for (size_t j = 0; j < high; ++j) twiddle(uint64_t(j) * low, m_StepHighRe[j], m_StepHighIm[j]);
+        m_StepGroupRe.resize(n1 * m_StepGroup);
+        m_StepGroupIm.resize(n1 * m_StepGroup);
+        for (size_t k1 = 0; k1 < n1; ++k1)
+        {
+            for (size_t c = 0; c < m_StepGroup; ++c)
+            {
+                twiddle(uint64_t(k1) * c, m_StepGroupRe[k1 * m_StepGroup + c], m_StepGroupIm[k1 * m_StepGroup + c]);
+            }
+        }
+        return;
+    }
+
+    if (remainder != 1)
+    {
+        size_t m = 1;
+        while (m < 2 * n - 1) m *= 2;
+        m_Convolution = &get_fft_plan<T>(m);
+
+        m_ChirpRe.resize(n);
+        m_ChirpIm.resize(n);
+        for (size_t k = 0; k < n; ++k)
+        {
+            // k^2 mod 2N keeps the angle small and exact for large k.
+            uint64_t k2 = (uint64_t(k) * k) % (2 * uint64_t(n));
+            double angle = -PI * static_cast<double>(k2) / n;
+            m_ChirpRe[k] = T(std::cos(angle));
+            m_ChirpIm[k] = T(std::sin(angle));
+        }
+
+        m_KernelRe.assign(m, T(0));
+        m_KernelIm.assign(m, T(0));
+        for (size_t k = 0; k < n; ++k)
+        {
+            m_KernelRe[k] = m_ChirpRe[k];
+            m_KernelIm[k] = -m_ChirpIm[k];
+            if (k != 0)
+            {
+                m_KernelRe[m - k] = m_ChirpRe[k];
+                m_KernelIm[m - k] = -m_ChirpIm[k];
+            }
+        }
+        m_Convolution->Forward(m_KernelRe.data(), m_KernelIm.data());
+        return;
+    }
+
+    size_t span = 1;
+    for (uint32_t r : radices)
+    {
+        size_t length = span * r;
+        m_Stages.push_back({ r, span, m_TwiddleRe.size() });
+        for (size_t q = 1; q < r; ++q)
+        {
+            for (size_t k = 0; k < span; ++k)
+            {
+                double angle = -2.0 * PI * static_cast<double>(q * k) / length;
+                m_TwiddleRe.push_back(T(std::cos(angle)));
+                m_TwiddleIm.push_back(T(std::sin(angle)));
+            }
+        }
+        span = length;
+    }
+
+    // Output position p = digits (d_last ... d_first) reads input
+    // d_last + r_last * (d_prev + r_prev * (...)).
+    m_Permutation.resize(n);
+    for (size_t p = 0; p < n; ++p)
+    {
+        size_t rest = p, length = n, index = 0, scale = 1;
+        for (size_t s = radices.size(); s-- > 0;)
+        {
+            length /= radices[s];
+            index += (rest / length) * scale;
+            rest %= length;
+            scale *= radices[s];
+        }
+        m_Permutation[p] = static_cast<uint32_t>(index);
+    }
+    for (size_t p = 0; p < n && m_SwapPermutation; ++p)
+    {
+        m_SwapPermutation = m_Permutation[m_Permutation[p]] == p;
+    }
+}
+
+template <class T>
+void BasicFftPlan<T>::Forward(T* re, T* im) const
+{
+    if (m_Convolution)
+    {
+        RunBluestein(re, im);
+        return;
+    }
+    if (m_Columns)
+    {
+        RunFourStep(re, im, T(1));
+        return;
+    }
+
+    Permute(re, im);
+    RunStages(re, im);
+}
+
+template <class T>
+void BasicFftPlan<T>::Inverse(T* re, T* im) const
+{
+    // Swapping the real and imaginary parts conjugates the transform
+    // direction: DFT(i * conj(x)) = i * conj(IDFT(x)).
+    if (m_Columns)
+    {
+        // Scaled while the rows are transposed back.
+        RunFourStep(im, re, T(1.0 / m_Size));
+        return;
+    }
+    Forward(im, re);
+
+    T scale = T(1.0 / m_Size);
+    for (size_t i = 0; i < m_Size; ++i)
+    {
+        re[i] *= scale;
+        im[i] *= scale;
+    }
+}
+
+template <class T>
+void BasicFftPlan<T>::Permute(T* re, T* im) const
+{
+    size_t n = m_Size;
+
+    if (m_SwapPermutation)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            size_t j = m_Permutation[i];
+            if (i < j)
+            {
+                std::swap(re[i], re[j]);
+                std::swap(im[i], im[j]);
+            }
+        }
+        return;
+    }
+
+    auto& scratch = thread_scratch<T>(kPermuteScratch, n);
     for (size_t i = 0; i < n; ++i)
     {
-        padded[i] = input[i];
+        scratch.re[i] = re[m_Permutation[i]];
+        scratch.im[i] = im[m_Permutation[i]];
     }
-    for (size_t i = n; i < new_size; ++i)
+    std::copy_n(scratch.re.data(), n, re);
+    std::copy_n(scratch.im.data(), n, im);
+}
+
+template <class T>
+void BasicFftPlan<T>::RunStages(T* re, T* im) const
+{
+    const FftKernels<T>& kernels = kernels_for(fft_simd_level())->template For<T>();
+
+    for (const Stage& stage : m_Stages)
     {
-        padded[i] = Complex(0.0, 0.0);
+        FftStageKernel<T> kernel = nullptr;
+        switch (stage.radix)
+        {
+        case 2: kernel = kernels.radix2; break;
+        case 3: kernel = kernels.radix3; break;
+        case 4: kernel = kernels.radix4; break;
+        case 5: kernel = kernels.radix5; break;
+        case 7: kernel = kernels.radix7; break;
+        }
+        kernel(re, im, &m_TwiddleRe[stage.twiddleOffset], &m_TwiddleIm[stage.twiddleOffset],
+               m_Size, stage.span);
     }
+}
 
-    return padded;
+template <class T>
+void BasicFftPlan<T>::RunBluestein(T* re, T* im) const
+{
+    // X[k] = w[k] * sum_j (x[j] w[j]) conj(w[k - j]), a linear convolution
+    // with the conjugate chirp, done by a circular one of size M >= 2N - 1.
+    size_t n = m_Size;
+    size_t m = m_Convolution->Size();
+
+    auto& scratch = thread_scratch<T>(kBluesteinScratch, m);
+    T* ar = scratch.re.data();
+    T* ai = scratch.im.data();
+    for (size_t k = 0; k < n; ++k)
+    {
+        ar[k] = re[k] * m_ChirpRe[k] - im[k] * m_ChirpIm[k];
+        ai[k] = re[k] * m_ChirpIm[k] + im[k] * m_ChirpRe[k];
+    }
+    std::fill(ar + n, ar + m, T(0));
+    std::fill(ai + n, ai + m, T(0));
+
+    m_Convolution->Forward(ar, ai);
+    for (size_t k = 0; k < m; ++k)
+    {
+        T r = ar[k] * m_KernelRe[k] - ai[k] * m_KernelIm[k];
+        T i = ar[k] * m_KernelIm[k] + ai[k] * m_KernelRe[k];
+        ar[k] = r;
+        ai[k] = i;
+    }
+    m_Convolution->Inverse(ar, ai);
+
+    for (size_t k = 0; k < n; ++k)
+    {
+        re[k] = ar[k] * m_ChirpRe[k] - ai[k] * m_ChirpIm[k];
+        im[k] = ar[k] * m_ChirpIm[k] + ai[k] * m_ChirpRe[k];
+    }
 }
 
-std::vector<Complex> fft(const std::vector<Complex>& input)
+template <class T>
+void BasicFftPlan<T>::RunFourStep(T* re, T* im, T scale) const
 {
-    
-    auto pad_input = pad_to_power_of_two(input);
+    // x[j1 * n2 + j2] as n1 rows of n2 points. Column transforms over j1
+    // give Y[k1][j2]; after twiddling by W^(k1 j2), row transforms over j2
+    // give X[k1 + n1 k2] at row k1, column k2, so the result is the
+    // transpose of the rows.
+    const size_t n1 = m_Columns->Size();
+    const size_t n = m_Size;
 
-    int n = pad_input.size();
+    auto& scratch = thread_scratch<T>(kFourStepScratch, n);
+    const FourStepArgs<T> args{ re, im, scratch.re.data(), scratch.im.data(), scale };
+
+    // 1. Columns in groups, gathered into a dense interleaved batch: the
+    //    column stride is usually a power of two, which would map every
+    //    row of a group onto a few cache sets. Each group is twiddled
+    //    while it is in cache and stored into the scratch rows.
+    parallel_for(0, n / n1, m_StepGroup, [this, &args](size_t begin, size_t end)
+    {
+        const size_t n1 = m_Columns->Size(), n2 = m_Rows->Size(), count = end - begin;
+        auto& batch = thread_scratch<T>(kColumnScratch, n1 * count);
+        T* br = batch.re.data();
+        T* bi = batch.im.data();
+        for (size_t j1 = 0; j1 < n1; ++j1)
+        {
+            std::copy_n(args.re + j1 * n2 + begin, count, br + j1 * count);
+            std::copy_n(args.im + j1 * n2 + begin, count, bi + j1 * count);
+        }
+        m_Columns->RunBatch(br, bi, count, count);
+        for (size_t k1 = 0; k1 < n1; ++k1)
+        {
+            TwiddleRow(br + k1 * count, bi + k1 * count, k1, begin, count);
+            std::copy_n(br + k1 * count, count, args.sr + k1 * n2 + begin);
+            std::copy_n(bi + k1 * count, count, args.si + k1 * n2 + begin);
+        }
+    });
+
+    // 2. Rows, a tile of them per task, written back transposed and
+    //    scaled so that every store fills whole cache lines.
+    parallel_for(0, n1, kTransposeTile, [this, &args](size_t begin, size_t end)
+    {
+        const size_t n1 = m_Columns->Size(), n2 = m_Rows->Size();
+        for (size_t k1 = begin; k1 < end; ++k1)
+        {
+            m_Rows->Forward(args.sr + k1 * n2, args.si + k1 * n2);
+        }
+        for (size_t k2 = 0; k2 < n2; ++k2)
+        {
+            for (size_t k1 = begin; k1 < end; ++k1)
+            {
+                args.re[k2 * n1 + k1] = args.sr[k1 * n2 + k2] * args.scale;
+                args.im[k2 * n1 + k1] = args.si[k1 * n2 + k2] * args.scale;
+            }
+        }
+    });
+}
 
-    if (n == 1) {
-        return { pad_input[0] };
+template <class T>
+void BasicFftPlan<T>::TwiddleRow(T* re, T* im, size_t row, size_t first, size_t count) const
+{
+    // Column first + c of row k1 is multiplied by W^(k1 first) W^(k1 c).
+    const size_t exponent = static_cast<size_t>(uint64_t(row) * first % m_Size);
+    const size_t h = exponent >> m_StepShift, l = exponent & ((size_t(1) << m_StepShift) - 1);
+    const T br = m_StepHighRe[h] * m_StepLowRe[l] - m_StepHighIm[h] * m_StepLowIm[l];
+    const T bi = m_StepHighRe[h] * m_StepLowIm[l] + m_StepHighIm[h] * m_StepLowRe[l];
+    const T* gr = &m_StepGroupRe[row * m_StepGroup];
+    const T* gi = &m_StepGroupIm[row * m_StepGroup];
+    for (size_t c = 0; c < count; ++c)
+    {
+        T wr = br * gr[c] - bi * gi[c];
+        T wi = br * gi[c] + bi * gr[c];
+        T xr = re[c], xi = im[c];
+        re[c] = xr * wr - xi * wi;
+        im[c] = xr * wi + xi * wr;
     }
+}
 
-    std::vector<Complex> even(n / 2), odd(n / 2);
-    for (int i = 0; i < n / 2; ++i) {
-        even[i] = pad_input[2 * i];
-        odd[i] = pad_input[2 * i + 1];
+template <class T>
+void BasicFftPlan<T>::ForwardBatch(T* re, T* im, size_t channels, BatchLayout layout) const
+{
+    if (channels == 1)
+    {
+        Forward(re, im);
+        return;
+    }
+    if (m_Columns)
+    {
+        // Every four-step transform already spreads over all threads.
+        for (size_t c = 0; c < channels; ++c)
+        {
+            if (layout == BatchLayout::Split) Forward(re + c * m_Size, im + c * m_Size);
+            else RunBatch(re + c, im + c, 1, channels);
+        }
+        return;
     }
 
-    
-    auto even_fft = fft(even);
-    auto odd_fft = fft(odd);
+    const BatchArgs<T*, T*> args{ re, im, channels, layout };
+    size_t scratchBytes = layout == BatchLayout::Split ? 2 * m_Size * sizeof(T) : 0;
+    parallel_for(0, channels, batch_group(channels, scratchBytes), [this, &args](size_t begin, size_t end)
+    {
+        T* re = args.in;
+        T* im = args.out;
+        size_t n = m_Size, channels = args.channels, count = end - begin;
+        if (args.layout == BatchLayout::Interleaved)
+        {
+            RunBatch(re + begin, im + begin, count, channels);
+            return;
+        }
 
-    
-    std::vector<Complex> result(n);
-    for (int k = 0; k < n / 2; ++k) {
-        Complex t = std::polar(1.0, -2.0 * PI * k / n) * odd_fft[k];
+        // Split channels are gathered into rows so the lanes run across
+        // them, then scattered back.
+        auto& scratch = thread_scratch<T>(kBatchScratch, n * count);
+        T* sr = scratch.re.data();
+        T* si = scratch.im.data();
+        T* xr = re + begin * n;
+        T* xi = im + begin * n;
+        for_each_tiled(n, count, [=](size_t i, size_t c)
+        {
+            sr[i * count + c] = xr[c * n + i];
+            si[i * count + c] = xi[c * n + i];
+        });
+        RunBatch(sr, si, count, count);
+        for_each_tiled(n, count, [=](size_t i, size_t c)
+        {
+            xr[c * n + i] = sr[i * count + c];
+            xi[c * n + i] = si[i * count + c];
+        });
+    });
+}
 
-        result[k] = even_fft[k] + t;
-        result[k + n / 2] = even_fft[k] - t;
+template <class T>
+void BasicFftPlan<T>::InverseBatch(T* re, T* im, size_t channels, BatchLayout layout) const
+{
+    ForwardBatch(im, re, channels, layout);
+
+    T scale = T(1.0 / m_Size);
+    for (size_t i = 0; i < m_Size * channels; ++i)
+    {
+        re[i] *= scale;
+        im[i] *= scale;
     }
+}
 
-    return result;
+template <class T>
+void BasicFftPlan<T>::RunBatch(T* re, T* im, size_t count, size_t stride) const
+{
+    if (m_Convolution)
+    {
+        RunBluesteinBatch(re, im, count, stride);
+        return;
+    }
+    if (m_Columns)
+    {
+        // A four-step plan has no stages to run across channels; each
+        // channel is gathered and transformed on its own.
+        auto& scratch = thread_scratch<T>(kChannelScratch, m_Size);
+        for (size_t c = 0; c < count; ++c)
+        {
+            for (size_t i = 0; i < m_Size; ++i)
+            {
+                scratch.re[i] = re[i * stride + c];
+                scratch.im[i] = im[i * stride + c];
+            }
+            RunFourStep(scratch.re.data(), scratch.im.data(), T(1));
+            for (size_t i = 0; i < m_Size; ++i)
+            {
+                re[i * stride + c] = scratch.re[i];
+                im[i * stride + c] = scratch.im[i];
+            }
+        }
+        return;
+    }
+
+    PermuteBatch(re, im, count, stride);
+    RunBatchStages(re, im, count, stride);
 }
 
-std::vector<Complex> ifft(const std::vector<Complex>& input)
+template <class T>
+void BasicFftPlan<T>::PermuteBatch(T* re, T* im, size_t count, size_t stride) const
+{
+    size_t n = m_Size;
+
+    if (m_SwapPermutation)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            size_t j = m_Permutation[i];
+            if (i < j)
+            {
+                std::swap_ranges(re + i * stride, re + i * stride + count, re + j * stride);
+                std::swap_ranges(im + i * stride, im + i * stride + count, im + j * stride);
+            }
+        }
+        return;
+    }
+
+    auto& scratch = thread_scratch<T>(kPermuteScratch, n * count);
+    for (size_t i = 0; i < n; ++i)
+    {
+        std::copy_n(re + m_Permutation[i] * stride, count, &scratch.re[i * count]);
+        std::copy_n(im + m_Permutation[i] * stride, count, &scratch.im[i * count]);
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        std::copy_n(&scratch.re[i * count], count, re + i * stride);
+        std::copy_n(&scratch.im[i * count], count, im + i * stride);
+    }
+}
+
+template <class T>
+void BasicFftPlan<T>::RunBatchStages(T* re, T* im, size_t count, size_t stride) const
+{
+    const FftKernels<T>& kernels = kernels_for(fft_simd_level())->template For<T>();
+
+    for (const Stage& stage : m_Stages)
+    {
+        FftBatchStageKernel<T> kernel = nullptr;
+        switch (stage.radix)
+        {
+        case 2: kernel = kernels.batch2; break;
+        case 3: kernel = kernels.batch3; break;
+        case 4: kernel = kernels.batch4; break;
+        case 5: kernel = kernels.batch5; break;
+        case 7: kernel = kernels.batch7; break;
+        }
+        kernel(re, im, &m_TwiddleRe[stage.twiddleOffset], &m_TwiddleIm[stage.twiddleOffset],
+               m_Size, stage.span, count, stride);
+    }
+}
+
+template <class T>
+void BasicFftPlan<T>::RunBluesteinBatch(T* re, T* im, size_t count, size_t stride) const
+{
+    // RunBluestein with every step applied to a row of channels.
+    size_t n = m_Size;
+    size_t m = m_Convolution->Size();
+
+    auto& scratch = thread_scratch<T>(kBluesteinScratch, m * count);
+    T* ar = scratch.re.data();
+    T* ai = scratch.im.data();
+    for (size_t k = 0; k < n; ++k)
+    {
+        const T* xr = re + k * stride;
+        const T* xi = im + k * stride;
+        T* yr = ar + k * count;
+        T* yi = ai + k * count;
+        for (size_t c = 0; c < count; ++c)
+        {
+            yr[c] = xr[c] * m_ChirpRe[k] - xi[c] * m_ChirpIm[k];
+            yi[c] = xr[c] * m_ChirpIm[k] + xi[c] * m_ChirpRe[k];
+        }
+    }
+    std::fill(ar + n * count, ar + m * count, T(0));
+    std::fill(ai + n * count, ai + m * count, T(0));
+
+    m_Convolution->RunBatch(ar, ai, count, count);
+    for (size_t k = 0; k < m; ++k)
+    {
+        T* yr = ar + k * count;
+        T* yi = ai + k * count;
+        for (size_t c = 0; c < count; ++c)
+        {
+            T r = yr[c] * m_KernelRe[k] - yi[c] * m_KernelIm[k];
+            T i = yr[c] * m_KernelIm[k] + yi[c] * m_KernelRe[k];
+            yr[c] = r;
+            yi[c] = i;
+        }
+    }
+    m_Convolution->RunBatch(ai, ar, count, count);
+    T scale = T(1.0 / m);
+    for (size_t i = 0; i < m * count; ++i)
+    {
+        ar[i] *= scale;
+        ai[i] *= scale;
+    }
+
+    for (size_t k = 0; k < n; ++k)
+    {
+        const T* yr = ar + k * count;
+        const T* yi = ai + k * count;
+        T* xr = re + k * stride;
+        T* xi = im + k * stride;
+        for (size_t c = 0; c < count; ++c)
+        {
+            xr[c] = yr[c] * m_ChirpRe[k] - yi[c] * m_ChirpIm[k];
+            xi[c] = yr[c] * m_ChirpIm[k] + yi[c] * m_ChirpRe[k];
+        }
+    }
+}
+
+template <class T>
+void BasicFftPlan<T>::Forward(ComplexT* data) const
+{
+    auto& scratch = thread_scratch<T>(kEntryScratch, m_Size);
+    for (size_t i = 0; i < m_Size; ++i)
+    {
+        scratch.re[i] = data[i].real();
+        scratch.im[i] = data[i].imag();
+    }
+    Forward(scratch.re.data(), scratch.im.data());
+    for (size_t i = 0; i < m_Size; ++i)
+    {
+        data[i] = ComplexT(scratch.re[i], scratch.im[i]);
+    }
+}
+
+template <class T>
+void BasicFftPlan<T>::Inverse(ComplexT* data) const
+{
+    auto& scratch = thread_scratch<T>(kEntryScratch, m_Size);
+    for (size_t i = 0; i < m_Size; ++i)
+    {
+        scratch.re[i] = data[i].real();
+        scratch.im[i] = data[i].imag();
+    }
+    Inverse(scratch.re.data(), scratch.im.data());
+    for (size_t i = 0; i < m_Size; ++i)
+    {
+        data[i] = ComplexT(scratch.re[i], scratch.im[i]);
+    }
+}
+
+template <class T>
+BasicRealFftPlan<T>::BasicRealFftPlan(size_t n)
+    : m_Size(n)
+{
+    if (n == 0)
+    {
+        throw std::invalid_argument("RealFftPlan: size must be positive");
+    }
+    if (n % 2 != 0)
+    {
+        m_Full = &get_fft_plan<T>(n);
+        return;
+    }
+
+    m_Half = &get_fft_plan<T>(n / 2);
+    m_Twiddles.resize(n / 2);
+    for (size_t k = 0; k < n / 2; ++k)
+    {
+        Complex w = std::polar(1.0, -2.0 * PI * k / n);
+        m_Twiddles[k] = ComplexT(T(w.real()), T(w.imag()));
+    }
+}
+
+template <class T>
+void BasicRealFftPlan<T>::Forward(const T* input, ComplexT* bins) const
+{
+    if (m_Full)
+    {
+        auto& scratch = thread_scratch<T>(kEntryScratch, m_Size);
+        std::copy_n(input, m_Size, scratch.re.data());
+        std::fill_n(scratch.im.data(), m_Size, T(0));
+        m_Full->Forward(scratch.re.data(), scratch.im.data());
+        for (size_t k = 0; k < Bins(); ++k)
+        {
+            bins[k] = ComplexT(scratch.re[k], scratch.im[k]);
+        }
+        return;
+    }
+
+    // Even samples become the real part, odd samples the imaginary part.
+    size_t m = m_Size / 2;
+    auto& scratch = thread_scratch<T>(kEntryScratch, m);
+    T* zr = scratch.re.data();
+    T* zi = scratch.im.data();
+    for (size_t k = 0; k < m; ++k)
+    {
+        zr[k] = input[2 * k];
+        zi[k] = input[2 * k + 1];
+    }
+    m_Half->Forward(zr, zi);
+    untangle_half(zr, zi, 1, m_Twiddles.data(), m, bins, BatchStrides{ Bins(), 1 });
+}
+
+template <class T>
+void BasicRealFftPlan<T>::Inverse(const ComplexT* bins, T* output) const
+{
+    if (m_Full)
+    {
+        // Rebuild the negative frequencies from the Hermitian symmetry.
+        auto& scratch = thread_scratch<T>(kEntryScratch, m_Size);
+        for (size_t k = 0; k < m_Size; ++k)
+        {
+            ComplexT x = k < Bins() ? bins[k] : std::conj(bins[m_Size - k]);
+            scratch.re[k] = x.real();
+            scratch.im[k] = x.imag();
+        }
+        m_Full->Inverse(scratch.re.data(), scratch.im.data());
+        std::copy_n(scratch.re.data(), m_Size, output);
+        return;
+    }
+
+    size_t m = m_Size / 2;
+    auto& scratch = thread_scratch<T>(kEntryScratch, m);
+    T* zr = scratch.re.data();
+    T* zi = scratch.im.data();
+    tangle_half(bins, BatchStrides{ Bins(), 1 }, m_Twiddles.data(), m, zr, zi, 1);
+    m_Half->Inverse(zr, zi);
+
+    for (size_t k = 0; k < m; ++k)
+    {
+        output[2 * k] = zr[k];
+        output[2 * k + 1] = zi[k];
+    }
+}
+
+template <class T>
+void BasicRealFftPlan<T>::ForwardBatch(const T* input, ComplexT* bins, size_t channels, BatchLayout layout) const
 {
-    int n = input.size();
+    if (channels == 1)
+    {
+        Forward(input, bins);
+        return;
+    }
+
+    const BatchArgs<const T*, ComplexT*> args{ input, bins, channels, layout };
+    parallel_for(0, channels, batch_group(channels, 2 * m_Size * sizeof(T)), [this, &args](size_t begin, size_t end)
+    {
+        size_t n = m_Size, nb = Bins(), count = end - begin;
+        BatchStrides in = batch_strides(args.layout, n, args.channels);
+        BatchStrides out = batch_strides(args.layout, nb, args.channels);
+        const T* x = args.in + begin * in.channel;
+        ComplexT* bins = args.out + begin * out.channel;
+
+        // The complex sub-transform runs on rows of the group; its own
+        // parallel_for is nested here and stays on this thread.
+        if (m_Full)
+        {
+            auto& scratch = thread_scratch<T>(kBatchScratch, n * count);
+            T* zr = scratch.re.data();
+            T* zi = scratch.im.data();
+            for_each_tiled(n, count, [=](size_t i, size_t c)
+            {
+                zr[i * count + c] = x[c * in.channel + i * in.point];
+                zi[i * count + c] = T(0);
+            });
+            m_Full->ForwardBatch(zr, zi, count, BatchLayout::Interleaved);
+            for_each_tiled(nb, count, [=](size_t k, size_t c)
+            {
+                bins[c * out.channel + k * out.point] = ComplexT(zr[k * count + c], zi[k * count + c]);
+            });
+            return;
+        }
 
-    std::vector<Complex> conjugated(n);
-    for (int i = 0; i < n; ++i) {
-        conjugated[i] = std::conj(input[i]);
+        size_t m = n / 2;
+        auto& scratch = thread_scratch<T>(kBatchScratch, m * count);
+        T* zr = scratch.re.data();
+        T* zi = scratch.im.data();
+        for_each_tiled(m, count, [=](size_t k, size_t c)
+        {
+            zr[k * count + c] = x[c * in.channel + 2 * k * in.point];
+            zi[k * count + c] = x[c * in.channel + (2 * k + 1) * in.point];
+        });
+        m_Half->ForwardBatch(zr, zi, count, BatchLayout::Interleaved);
+        untangle_half(zr, zi, count, m_Twiddles.data(), m, bins, out);
+    });
+}
+
+template <class T>
+void BasicRealFftPlan<T>::InverseBatch(const ComplexT* bins, T* output, size_t channels, BatchLayout layout) const
+{
+    if (channels == 1)
+    {
+        Inverse(bins, output);
+        return;
     }
 
-    auto result = fft(conjugated);
+    const BatchArgs<const ComplexT*, T*> args{ bins, output, channels, layout };
+    parallel_for(0, channels, batch_group(channels, 2 * m_Size * sizeof(T)), [this, &args](size_t begin, size_t end)
+    {
+        size_t n = m_Size, nb = Bins(), count = end - begin;
+        BatchStrides in = batch_strides(args.layout, nb, args.channels);
+        BatchStrides out = batch_strides(args.layout, n, args.channels);
+        const ComplexT* bins = args.in + begin * in.channel;
+        T* y = args.out + begin * out.channel;
+
+        if (m_Full)
+        {
+            auto& scratch = thread_scratch<T>(kBatchScratch, n * count);
+            T* zr = scratch.re.data();
+            T* zi = scratch.im.data();
+            for_each_tiled(n, count, [=](size_t k, size_t c)
+            {
+                const ComplexT* b = bins + c * in.channel;
+                ComplexT v = k < nb ? b[k * in.point] : std::conj(b[(n - k) * in.point]);
+                zr[k * count + c] = v.real();
+                zi[k * count + c] = v.imag();
+            });
+            m_Full->InverseBatch(zr, zi, count, BatchLayout::Interleaved);
+            for_each_tiled(n, count, [=](size_t i, size_t c)
+            {
+                y[c * out.channel + i * out.point] = zr[i * count + c];
+            });
+            return;
+        }
+
+        size_t m = n / 2;
+        auto& scratch = thread_scratch<T>(kBatchScratch, m * count);
+        T* zr = scratch.re.data();
+        T* zi = scratch.im.data();
+        tangle_half(bins, in, m_Twiddles.data(), m, zr, zi, count);
+        m_Half->InverseBatch(zr, zi, count, BatchLayout::Interleaved);
+        for_each_tiled(m, count, [=](size_t k, size_t c)
+        {
+            y[c * out.channel + 2 * k * out.point] = zr[k * count + c];
+            y[c * out.channel + (2 * k + 1) * out.point] = zi[k * count + c];
+        });
+    });
+}
+
+namespace
+{
+// Plans are built outside the lock: a Bluestein or real plan asks the
+// cache for its own sub-plan while it is being constructed.
+template <class Plan>
+const Plan& cached_plan(size_t n)
+{
+    static std::mutex mutex;
+    static std::unordered_map<size_t, std::unique_ptr<Plan>> plans;
+
+    {
+        std::lock_guard lock(mutex);
+        auto it = plans.find(n);
+        if (it != plans.end()) return *it->second;
+    }
+
+    auto plan = std::make_unique<Plan>(n);
+
+    std::lock_guard lock(mutex);
+    auto& slot = plans[n];
+    if (!slot) slot = std::move(plan);
+    return *slot;
+}
+}
+
+template <class T>
+const BasicFftPlan<T>& get_fft_plan(size_t n)
+{
+    return cached_plan<BasicFftPlan<T>>(n);
+}
+
+template <class T>
+const BasicRealFftPlan<T>& get_real_fft_plan(size_t n)
+{
+    return cached_plan<BasicRealFftPlan<T>>(n);
+}
+
+template class BasicFftPlan<double>;
+template class BasicFftPlan<float>;
+template class BasicRealFftPlan<double>;
+template class BasicRealFftPlan<float>;
+template const FftPlan& get_fft_plan<double>(size_t n);
+template const FftPlanF& get_fft_plan<float>(size_t n);
+template const RealFftPlan& get_real_fft_plan<double>(size_t n);
+template const RealFftPlanF& get_real_fft_plan<float>(size_t n);
+
+std::vector<Complex> pad_to_power_of_two(const std::vector<Complex>& input)
+{
+    size_t n = input.size();
+
+    size_t new_size = 1;
+    while (new_size < n)
+    {
+        new_size *= 2;
+    }
 
-    for (int i = 0; i < n; ++i) {
-        result[i] = std::conj(result[i]) / static_cast<double>(n);
+    std::vector<Complex> padded(new_size);
+    for (size_t i = 0; i < n; ++i)
+    {
+        padded[i] = input[i];
+    }
+    for (size_t i = n; i < new_size; ++i)
+    {
+        padded[i] = Complex(0.0, 0.0);
     }
 
+    return padded;
+}
+
+std::vector<Complex> fft(const std::vector<Complex>& input)
+{
+    auto result = input;
+    if (!result.empty()) get_fft_plan(result.size()).Forward(result.data());
+    return result;
+}
+
+std::vector<Complex> ifft(const std::vector<Complex>& input)
+{
+    auto result = input;
+    if (!result.empty()) get_fft_plan(result.size()).Inverse(result.data());
     return result;
 }
 
 std::vector<Complex> fft_real(const std::vector<double>& real_input)
 {
-    std::vector<Complex> complex_input(real_input.size());
+    std::vector<Complex> result(real_input.size());
     for (size_t i = 0; i < real_input.size(); ++i) {
-        complex_input[i] = Complex(real_input[i], 0.0);
+        result[i] = Complex(real_input[i], 0.0);
     }
-    return fft(complex_input);
+    if (!result.empty()) get_fft_plan(result.size()).Forward(result.data());
+    return result;
+}
+
+std::vector<Complex> rfft(const std::vector<double>& real_input)
+{
+    const auto& plan = get_real_fft_plan(real_input.size());
+    std::vector<Complex> result(plan.Bins());
+    plan.Forward(real_input.data(), result.data());
+    return result;
+}
+
+std::vector<double> irfft(const std::vector<Complex>& bins, size_t n)
+{
+    const auto& plan = get_real_fft_plan(n);
+    std::vector<double> result(n);
+    plan.Inverse(bins.data(), result.data());
+    return result;
 }
 
 std::vector<double> amplitude_spectrum(const std::vector<Complex>& fft_result)
@@ -103,4 +1212,33 @@ std::vector<double> phase_spectrum(const std::vector<Complex>& fft_result)
         spectrum[i] = std::arg(fft_result[i]);
     }
     return spectrum;
+}
+
+std::vector<double> amplitude_spectrum(const std::vector<Complex>& half_spectrum, size_t n)
+{
+    std::vector<double> spectrum(half_spectrum.size());
+    amplitude_spectrum(half_spectrum.data(), half_spectrum.size(), n, spectrum.data());
+    return spectrum;
+}
+
+namespace
+{
+template <class T>
+void half_amplitudes(const std::complex<T>* half_spectrum, size_t bins, size_t n, T* out)
+{
+    for (size_t i = 0; i < bins; ++i) {
+        out[i] = 2 * std::abs(half_spectrum[i]) / T(n);
+    }
+    if (bins > 0) out[0] = 0;
+}
+}
+
+void amplitude_spectrum(const Complex* half_spectrum, size_t bins, size_t n, double* out)
+{
+    half_amplitudes(half_spectrum, bins, n, out);
+}
+
+void amplitude_spectrum(const ComplexF* half_spectrum, size_t bins, size_t n, float* out)
+{
+    half_amplitudes(half_spectrum, bins, n, out);
 }
\ No newline at end of file
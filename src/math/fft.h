@@ -5,11 +5,198 @@
 #include <complex>
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
 
 using Complex = std::complex<double>;
+using ComplexF = std::complex<float>;
 
 const double PI = acos(-1.0);
 
+// Butterfly implementations, picked at runtime from the CPU features.
+enum class SimdLevel
+{
+    Scalar,
+    Sse2,
+    Avx2,
+    Avx512,
+};
+
+// Best level supported by both this build and the running CPU.
+SimdLevel fft_max_simd_level();
+SimdLevel fft_simd_level();
+// Forces a level (clamped to fft_max_simd_level()), e.g. to compare paths.
+void fft_set_simd_level(SimdLevel level);
+const char* to_string(SimdLevel level);
+
+// Memory layout of several equal-length signals processed together.
+enum class BatchLayout
+{
+    Interleaved,  // point i of channel c at i * channels + c
+    Split,        // point i of channel c at c * n + i
+};
+
+// Precomputed tables for an iterative transform of one size.
+// A plan is immutable after construction, so one instance can be shared
+// between threads; the buffers it works on belong to the caller.
+//
+// Sizes whose prime factors are all 2, 3, 5 or 7 run as in-place
+// mixed-radix decimation-in-time stages (radix 4 preferred over 2).
+// Any other size goes through Bluestein's algorithm, a chirp-z
+// convolution evaluated with a power-of-two plan.
+//
+// The transform itself runs on split real/imaginary arrays so the
+// butterflies vectorize; the complex overloads convert through a
+// thread-local scratch buffer.
+//
+// T is the sample type, double or float. Tables are computed in double
+// and rounded once, so a float plan only loses precision in the
+// butterflies themselves.
+//
+// The batch overloads transform many signals with the same tables. Each
+// butterfly runs across channels in the vector lanes, and groups of
+// channels are spread over parallel_for; every channel gets exactly the
+// result of the single-signal call.
+//
+// From four_step_min_size() points on, a mixed-radix size n = n1 * n2
+// runs as a four-step transform instead: n2 column transforms of n1
+// points, a twiddle pass, n1 row transforms of n2 points and a transpose.
+// Every sub-transform works in cache, and each pass is spread over
+// parallel_for, so one large transform uses all threads; batches of such
+// a size run their channels one after another. Results do not depend on
+// the thread count.
+template <class T>
+class BasicFftPlan
+{
+public:
+    using ComplexT = std::complex<T>;
+
+    explicit BasicFftPlan(size_t n);
+
+    size_t Size() const { return m_Size; }
+    bool IsBluestein() const { return m_Convolution != nullptr; }
+    bool IsFourStep() const { return m_Columns != nullptr; }
+
+    // In-place forward DFT of Size() points.
+    void Forward(T* re, T* im) const;
+    // In-place inverse DFT of Size() points, scaled by 1/N.
+    void Inverse(T* re, T* im) const;
+
+    void Forward(ComplexT* data) const;
+    void Inverse(ComplexT* data) const;
+
+    // In-place transforms of `channels` signals of Size() points.
+    // Interleaved data is transformed where it is; split channels are
+    // copied into interleaved scratch and back, which costs a transpose.
+    void ForwardBatch(T* re, T* im, size_t channels, BatchLayout layout) const;
+    void InverseBatch(T* re, T* im, size_t channels, BatchLayout layout) const;
+
+private:
+    struct Stage
+    {
+        uint32_t radix;
+        size_t span;
+        size_t twiddleOffset;
+    };
+
+    void Permute(T* re, T* im) const;
+    void RunStages(T* re, T* im) const;
+    void RunBluestein(T* re, T* im) const;
+    // Batch steps on count channels stored row by row, stride apart.
+    void RunBatch(T* re, T* im, size_t count, size_t stride) const;
+    void PermuteBatch(T* re, T* im, size_t count, size_t stride) const;
+    void RunBatchStages(T* re, T* im, size_t count, size_t stride) const;
+    void RunBluesteinBatch(T* re, T* im, size_t count, size_t stride) const;
+    // In-place four-step transform; the result is multiplied by scale.
+    void RunFourStep(T* re, T* im, T scale) const;
+    // Multiplies columns [first, first + count) of a four-step row.
+    void TwiddleRow(T* re, T* im, size_t row, size_t first, size_t count) const;
+
+    size_t m_Size;
+    std::vector<Stage> m_Stages;
+    // Digit-reversal permutation; swaps suffice when it is an involution.
+    std::vector<uint32_t> m_Permutation;
+    bool m_SwapPermutation = true;
+    std::vector<T> m_TwiddleRe, m_TwiddleIm;
+
+    // Bluestein: chirp w[k] = exp(-i*pi*k^2/N) and the spectrum of its
+    // conjugate, zero-padded to the power-of-two convolution size.
+    const BasicFftPlan* m_Convolution = nullptr;
+    std::vector<T> m_ChirpRe, m_ChirpIm;
+    std::vector<T> m_KernelRe, m_KernelIm;
+
+    // Four-step: plans for the columns (n1 points) and rows (n2 points),
+    // columns per task, and the middle-pass twiddles W^(k1 j) factored as
+    // W^(k1 first) * W^(k1 c) for a group starting at column first:
+    // W^e = high[e >> shift] * low[e & (2^shift - 1)] gives the first
+    // factor and a table of n1 x group entries the second, so the n
+    // twiddles are never stored.
+    const BasicFftPlan* m_Columns = nullptr;
+    const BasicFftPlan* m_Rows = nullptr;
+    size_t m_StepGroup = 0;
+    std::vector<T> m_StepLowRe, m_StepLowIm, m_StepHighRe, m_StepHighIm;
+    std::vector<T> m_StepGroupRe, m_StepGroupIm;
+    unsigned m_StepShift = 0;
+};
+
+// Smallest mixed-radix size planned as a four-step transform. By default
+// 2^18 with worker threads, twice the points whose split arrays fill a
+// typical 2 MiB L2 in double, so one transform spreads over them early;
+// on a single thread the extra passes over memory only pay off from 2^22
+// points, where the iterative stages leave the last level cache. The best
+// crossover depends on the machine: time it with signalfilter-bench
+// --four-step-min and set it at startup.
+size_t four_step_min_size();
+// Overrides four_step_min_size() for plans made afterwards; 0 restores
+// the default. Plans are cached, so a size already planned keeps its
+// layout. The column and row sub-plans follow the same threshold, so a low
+// one splits them again; that is correct but only useful for timing.
+void set_four_step_min_size(size_t n);
+
+// Real-input transform of N points producing the N/2+1 non-redundant bins
+// of the Hermitian spectrum. For even N it runs a complex FFT of N/2
+// points on the even/odd samples packed as complex pairs, then untangles
+// the halves; odd N falls back to a full complex transform.
+template <class T>
+class BasicRealFftPlan
+{
+public:
+    using ComplexT = std::complex<T>;
+
+    explicit BasicRealFftPlan(size_t n);
+
+    size_t Size() const { return m_Size; }
+    size_t Bins() const { return m_Size / 2 + 1; }
+
+    // Size() samples in, Bins() bins out.
+    void Forward(const T* input, ComplexT* bins) const;
+    // Bins() bins in, Size() samples out, scaled by 1/N.
+    void Inverse(const ComplexT* bins, T* output) const;
+
+    // `channels` signals of Size() samples to as many spectra of Bins()
+    // bins, both in the given layout. Results match the single calls.
+    void ForwardBatch(const T* input, ComplexT* bins, size_t channels, BatchLayout layout) const;
+    void InverseBatch(const ComplexT* bins, T* output, size_t channels, BatchLayout layout) const;
+
+private:
+    size_t m_Size;
+    const BasicFftPlan<T>* m_Half = nullptr;
+    const BasicFftPlan<T>* m_Full = nullptr;
+    std::vector<ComplexT> m_Twiddles;
+};
+
+// Instantiated for double and float in fft.cpp.
+using FftPlan = BasicFftPlan<double>;
+using FftPlanF = BasicFftPlan<float>;
+using RealFftPlan = BasicRealFftPlan<double>;
+using RealFftPlanF = BasicRealFftPlan<float>;
+
+// Returns the cached plan for n points, n >= 1.
+template <class T = double>
+const BasicFftPlan<T>& get_fft_plan(size_t n);
+
+template <class T = double>
+const BasicRealFftPlan<T>& get_real_fft_plan(size_t n);
+
 std::vector<Complex> pad_to_power_of_two(const std::vector<Complex>& input);
 
 std::vector<Complex> fft(const std::vector<Complex>& input);
@@ -18,6 +205,17 @@ std::vector<Complex> ifft(const std::vector<Complex>& input);
 
 std::vector<Complex> fft_real(const std::vector<double>& real_input);
 
+// Packed real FFT: returns N/2+1 bins for N input samples.
+std::vector<Complex> rfft(const std::vector<double>& real_input);
+
+// Inverse of rfft: n real samples from n/2+1 bins.
+std::vector<double> irfft(const std::vector<Complex>& bins, size_t n);
+
 std::vector<double> amplitude_spectrum(const std::vector<Complex>& fft_result);
 
+// Amplitudes of a half spectrum produced by an n-point real transform.
+std::vector<double> amplitude_spectrum(const std::vector<Complex>& half_spectrum, size_t n);
+void amplitude_spectrum(const Complex* half_spectrum, size_t bins, size_t n, double* out);
+void amplitude_spectrum(const ComplexF* half_spectrum, size_t bins, size_t n, float* out);
+
 std::vector<double> phase_spectrum(const std::vector<Complex>& fft_result);
\ No newline at end of file
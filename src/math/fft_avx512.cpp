@@ -0,0 +1,46 @@
+#include "fft_kernels.h"
+
+#if defined(__AVX512F__)
+
+#include <immintrin.h>
+
+namespace
+{
+struct Avx512Vec
+{
+    using Scalar = double;
+    using Reg = __m512d;
+    static constexpr size_t Width = 8;
+
+    static Reg Load(const double* p) { return _mm512_loadu_pd(p); }
+    static void Store(double* p, Reg v) { _mm512_storeu_pd(p, v); }
+    static Reg Set1(double v) { return _mm512_set1_pd(v); }
+    static Reg Add(Reg a, Reg b) { return _mm512_add_pd(a, b); }
+    static Reg Sub(Reg a, Reg b) { return _mm512_sub_pd(a, b); }
+    static Reg Mul(Reg a, Reg b) { return _mm512_mul_pd(a, b); }
+};
+
+struct Avx512VecF
+{
+    using Scalar = float;
+    using Reg = __m512;
+    static constexpr size_t Width = 16;
+
+    static Reg Load(const float* p) { return _mm512_loadu_ps(p); }
+    static void Store(float* p, Reg v) { _mm512_storeu_ps(p, v); }
+    static Reg Set1(float v) { return _mm512_set1_ps(v); }
+    static Reg Add(Reg a, Reg b) { return _mm512_add_ps(a, b); }
+    static Reg Sub(Reg a, Reg b) { return _mm512_sub_ps(a, b); }
+    static Reg Mul(Reg a, Reg b) { return _mm512_mul_ps(a, b); }
+};
+
+const FftKernelSet kKernels = make_fft_kernel_set<Avx512Vec, Avx512VecF>();
+}
+
+const FftKernelSet* fft_kernels_avx512() { return &kKernels; }
+
+#else
+
+const FftKernelSet* fft_kernels_avx512() { return nullptr; }
+
+#endif
@@ -0,0 +1,455 @@
+#pragma once
+
+// Butterfly, oscillator and FIR kernels shared by the scalar and SIMD
+// translation units. Every kernel works on split arrays and is written once
+// against a small vector-type interface, so each instruction set performs
+// the same operations in the same order as the scalar fallback. Each
+// kernel exists for double and float samples.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// One decimation-in-time stage: blocks of radix*span points, where the
+// twiddle W^(q*k) for input q >= 1 of butterfly k is stored at
+// (q - 1) * span + k, contiguous in k.
+template <class T>
+using FftStageKernel = void (*)(T* re, T* im, const T* wr, const T* wi, size_t n, size_t span);
+
+// The same stage for `channels` signals stored row by row: point i of
+// channel c is at i * stride + c. Vector lanes run across channels and
+// every twiddle is broadcast, so each channel goes through exactly the
+// operations of the single-signal stage.
+template <class T>
+using FftBatchStageKernel = void (*)(T* re, T* im, const T* wr, const T* wi, size_t n, size_t span,
+                                     size_t channels, size_t stride);
+
+// Phasor lanes per oscillator step, four cache lines of samples; fixed
+// for every instruction set so the results do not depend on the SIMD
+// level. Even the widest registers get four independent rotations.
+template <class T>
+constexpr size_t kOscillatorLanes = 256 / sizeof(T);
+
+// Adds steps * kOscillatorLanes samples of one sinusoid to out. Lane j of
+// s/c holds the scaled sin/cos of sample j; every step rotates all lanes by
+// (ws, wc), the phasor of kOscillatorLanes samples. s/c are updated to the
+// state after the last step.
+template <class T>
+using OscillatorKernel = void (*)(T* out, size_t steps, T* s, T* c, T ws, T wc);
+
+// Direct-form FIR: out[i] = sum of h[k] * x[i + k] over k < taps, for
+// i < count. h is the kernel reversed, so x starts with taps - 1 samples
+// of history before the count new ones.
+template <class T>
+using FirKernel = void (*)(T* out, const T* x, size_t count, const T* h, size_t taps);
+
+template <class T>
+struct FftKernels
+{
+    FftStageKernel<T> radix2;
+    FftStageKernel<T> radix3;
+    FftStageKernel<T> radix4;
+    FftStageKernel<T> radix5;
+    FftStageKernel<T> radix7;
+    FftBatchStageKernel<T> batch2;
+    FftBatchStageKernel<T> batch3;
+    FftBatchStageKernel<T> batch4;
+    FftBatchStageKernel<T> batch5;
+    FftBatchStageKernel<T> batch7;
+    OscillatorKernel<T> oscillate;
+    FirKernel<T> fir;
+};
+
+// The kernels of one instruction set for both sample types.
+struct FftKernelSet
+{
+    FftKernels<double> f64;
+    FftKernels<float> f32;
+
+    template <class T>
+    const FftKernels<T>& For() const
+    {
+        if constexpr (sizeof(T) == sizeof(float)) return f32;
+        else return f64;
+    }
+};
+
+// Internal linkage on purpose: the templates below are compiled with
+// different target flags in each translation unit, and the linker must
+// not fold, say, the AVX-512 build of the scalar path into the others.
+namespace
+{
+template <class T>
+struct ScalarVec
+{
+    using Scalar = T;
+    using Reg = T;
+    static constexpr size_t Width = 1;
+
+    static Reg Load(const T* p) { return *p; }
+    static void Store(T* p, Reg v) { *p = v; }
+    static Reg Set1(T v) { return v; }
+    static Reg Add(Reg a, Reg b) { return a + b; }
+    static Reg Sub(Reg a, Reg b) { return a - b; }
+    static Reg Mul(Reg a, Reg b) { return a * b; }
+};
+
+// Twiddles of input q >= 1 for the butterflies. LaneTwiddles reads one
+// per lane from the stage table; BroadcastTwiddles holds the pointers of
+// a single butterfly and repeats its twiddle in every lane.
+template <class V>
+struct LaneTwiddles
+{
+    using T = typename V::Scalar;
+
+    const T* wr;
+    const T* wi;
+    size_t span;
+
+    void Load(size_t q, size_t k, typename V::Reg& cr, typename V::Reg& ci) const
+    {
+        cr = V::Load(wr + (q - 1) * span + k);
+        ci = V::Load(wi + (q - 1) * span + k);
+    }
+};
+
+template <class V>
+struct BroadcastTwiddles
+{
+    using T = typename V::Scalar;
+
+    const T* wr;
+    const T* wi;
+    size_t span;
+
+    void Load(size_t q, size_t, typename V::Reg& cr, typename V::Reg& ci) const
+    {
+        cr = V::Set1(wr[(q - 1) * span]);
+        ci = V::Set1(wi[(q - 1) * span]);
+    }
+};
+
+// Loads input q of a butterfly from re/im + k and multiplies it by its
+// twiddle.
+template <class V, class Tw, class T = typename V::Scalar>
+inline void load_twiddled(const T* re, const T* im, const Tw& tw, size_t q,
+                          size_t k, typename V::Reg& outRe, typename V::Reg& outIm)
+{
+    auto xr = V::Load(re + k), xi = V::Load(im + k);
+    typename V::Reg cr, ci;
+    tw.Load(q, k, cr, ci);
+    outRe = V::Sub(V::Mul(cr, xr), V::Mul(ci, xi));
+    outIm = V::Add(V::Mul(cr, xi), V::Mul(ci, xr));
+}
+
+// Butterflies compute lanes k .. k + V::Width - 1 of one block; r0/i0
+// point at the first input of the block and input q starts q * span
+// further.
+template <class V>
+struct Radix2
+{
+    static constexpr size_t R = 2;
+
+    using T = typename V::Scalar;
+
+    template <class Tw>
+    static void Run(T* r0, T* i0, const Tw& tw, size_t span, size_t k)
+    {
+        typename V::Reg tr, ti;
+        load_twiddled<V>(r0 + span, i0 + span, tw, 1, k, tr, ti);
+
+        auto ur = V::Load(r0 + k), ui = V::Load(i0 + k);
+        V::Store(r0 + span + k, V::Sub(ur, tr));
+        V::Store(i0 + span + k, V::Sub(ui, ti));
+        V::Store(r0 + k, V::Add(ur, tr));
+        V::Store(i0 + k, V::Add(ui, ti));
+    }
+};
+
+template <class V>
+struct Radix4
+{
+    static constexpr size_t R = 4;
+
+    using T = typename V::Scalar;
+
+    template <class Tw>
+    static void Run(T* r0, T* i0, const Tw& tw, size_t span, size_t k)
+    {
+        auto y0r = V::Load(r0 + k), y0i = V::Load(i0 + k);
+        typename V::Reg y1r, y1i, y2r, y2i, y3r, y3i;
+        load_twiddled<V>(r0 + span, i0 + span, tw, 1, k, y1r, y1i);
+        load_twiddled<V>(r0 + 2 * span, i0 + 2 * span, tw, 2, k, y2r, y2i);
+        load_twiddled<V>(r0 + 3 * span, i0 + 3 * span, tw, 3, k, y3r, y3i);
+
+        auto s02r = V::Add(y0r, y2r), s02i = V::Add(y0i, y2i);
+        auto d02r = V::Sub(y0r, y2r), d02i = V::Sub(y0i, y2i);
+        auto s13r = V::Add(y1r, y3r), s13i = V::Add(y1i, y3i);
+        auto d13r = V::Sub(y1r, y3r), d13i = V::Sub(y1i, y3i);
+
+        // W4 = -i, so -i * (y1 - y3) = (d13i, -d13r).
+        V::Store(r0 + k, V::Add(s02r, s13r));
+        V::Store(i0 + k, V::Add(s02i, s13i));
+        V::Store(r0 + span + k, V::Add(d02r, d13i));
+        V::Store(i0 + span + k, V::Sub(d02i, d13r));
+        V::Store(r0 + 2 * span + k, V::Sub(s02r, s13r));
+        V::Store(i0 + 2 * span + k, V::Sub(s02i, s13i));
+        V::Store(r0 + 3 * span + k, V::Sub(d02r, d13i));
+        V::Store(i0 + 3 * span + k, V::Add(d02i, d13r));
+    }
+};
+
+// cos/sin of 2*pi*j/R for the odd-radix butterflies, rounded from double.
+template <class T, size_t Radix>
+struct RadixRoots
+{
+    T c[Radix], s[Radix];
+
+    RadixRoots()
+    {
+        for (size_t j = 0; j < Radix; ++j)
+        {
+            c[j] = T(std::cos(2.0 * 3.14159265358979323846 * j / Radix));
+            s[j] = T(std::sin(2.0 * 3.14159265358979323846 * j / Radix));
+        }
+    }
+};
+
+// Odd radix: inputs q and R-q are folded into a sum and a difference,
+// which halves the multiplications of the small DFT.
+template <class V, size_t Radix>
+struct RadixOdd
+{
+    static constexpr size_t R = Radix;
+    static constexpr size_t H = Radix / 2;
+    static_assert(Radix % 2 == 1, "RadixOdd needs an odd radix");
+
+    using T = typename V::Scalar;
+
+    template <class Tw>
+    static void Run(T* r0, T* i0, const Tw& tw, size_t span, size_t k)
+    {
+        static const RadixRoots<T, R> roots;
+
+        typename V::Reg yr[R], yi[R];
+        yr[0] = V::Load(r0 + k);
+        yi[0] = V::Load(i0 + k);
+        for (size_t q = 1; q < R; ++q)
+        {
+            load_twiddled<V>(r0 + q * span, i0 + q * span, tw, q, k, yr[q], yi[q]);
+        }
+
+        typename V::Reg sr[H + 1], si[H + 1], dr[H + 1], di[H + 1];
+        auto outr = yr[0], outi = yi[0];
+        for (size_t q = 1; q <= H; ++q)
+        {
+            sr[q] = V::Add(yr[q], yr[R - q]);
+            si[q] = V::Add(yi[q], yi[R - q]);
+            dr[q] = V::Sub(yr[q], yr[R - q]);
+            di[q] = V::Sub(yi[q], yi[R - q]);
+            outr = V::Add(outr, sr[q]);
+            outi = V::Add(outi, si[q]);
+        }
+        V::Store(r0 + k, outr);
+        V::Store(i0 + k, outi);
+
+        // X[p] = y0 + sum_q cos(2pi pq/R) * S_q - i * sin(2pi pq/R) * D_q
+        for (size_t p = 1; p < R; ++p)
+        {
+            auto accr = yr[0], acci = yi[0];
+            for (size_t q = 1; q <= H; ++q)
+            {
+                size_t j = (p * q) % R;
+                auto c = V::Set1(roots.c[j]), s = V::Set1(roots.s[j]);
+                accr = V::Add(accr, V::Add(V::Mul(sr[q], c), V::Mul(di[q], s)));
+                acci = V::Add(acci, V::Sub(V::Mul(si[q], c), V::Mul(dr[q], s)));
+            }
+            V::Store(r0 + p * span + k, accr);
+            V::Store(i0 + p * span + k, acci);
+        }
+    }
+};
+
+template <class V> using Radix3 = RadixOdd<V, 3>;
+template <class V> using Radix5 = RadixOdd<V, 5>;
+template <class V> using Radix7 = RadixOdd<V, 7>;
+
+// Vector lanes cover as much of each block as they can; the remainder of
+// a span that is not a multiple of the width goes through the scalar
+// butterfly, which performs the identical operations.
+template <class V, template <class> class Butterfly, class T = typename V::Scalar>
+void run_stage(T* re, T* im, const T* wr, const T* wi, size_t n, size_t span)
+{
+    constexpr size_t R = Butterfly<V>::R;
+    const LaneTwiddles<V> lanes{ wr, wi, span };
+    const LaneTwiddles<ScalarVec<T>> scalar{ wr, wi, span };
+
+    for (size_t start = 0; start < n; start += R * span)
+    {
+        size_t k = 0;
+        if constexpr (V::Width > 1)
+        {
+            for (; k + V::Width <= span; k += V::Width)
+            {
+                Butterfly<V>::Run(re + start, im + start, lanes, span, k);
+            }
+        }
+        for (; k < span; ++k)
+        {
+            Butterfly<ScalarVec<T>>::Run(re + start, im + start, scalar, span, k);
+        }
+    }
+}
+
+// Row-wise counterpart of run_stage: butterfly k of a block is applied to
+// channels 0 .. channels - 1 at once, with its twiddles broadcast.
+template <class V, template <class> class Butterfly, class T = typename V::Scalar>
+void run_batch_stage(T* re, T* im, const T* wr, const T* wi, size_t n, size_t span,
+                     size_t channels, size_t stride)
+{
+    constexpr size_t R = Butterfly<V>::R;
+    const size_t rowSpan = span * stride;
+
+    for (size_t start = 0; start < n; start += R * span)
+    {
+        T* r0 = re + start * stride;
+        T* i0 = im + start * stride;
+        for (size_t k = 0; k < span; ++k)
+        {
+            const size_t row = k * stride;
+            size_t c = 0;
+            if constexpr (V::Width > 1)
+            {
+                const BroadcastTwiddles<V> tw{ wr + k, wi + k, span };
+                for (; c + V::Width <= channels; c += V::Width)
+                {
+                    Butterfly<V>::Run(r0, i0, tw, rowSpan, row + c);
+                }
+            }
+            const BroadcastTwiddles<ScalarVec<T>> tw{ wr + k, wi + k, span };
+            for (; c < channels; ++c)
+            {
+                Butterfly<ScalarVec<T>>::Run(r0, i0, tw, rowSpan, row + c);
+            }
+        }
+    }
+}
+
+// Each step is a complex rotation, which unlike a two-term recurrence
+// stays well conditioned at low frequencies. A rotation waits for the
+// previous one, so the lanes go through the block in groups of G
+// registers: G independent chains hide the multiply-add latency, and a
+// group fits in the registers of every instruction set. Scalar code
+// keeps all lanes in one group, which the compiler vectorizes itself.
+template <class V, class T = typename V::Scalar>
+void oscillate(T* out, size_t steps, T* s, T* c, T ws, T wc)
+{
+    constexpr size_t Lanes = kOscillatorLanes<T>;
+    constexpr size_t R = Lanes / V::Width;
+    constexpr size_t G = V::Width == 1 ? R : std::min<size_t>(R, 4);
+    static_assert(R % G == 0);
+
+    const auto rs = V::Set1(ws), rc = V::Set1(wc);
+    for (size_t first = 0; first < R; first += G)
+    {
+        typename V::Reg vs[G], vc[G];
+        for (size_t r = 0; r < G; ++r)
+        {
+            vs[r] = V::Load(s + (first + r) * V::Width);
+            vc[r] = V::Load(c + (first + r) * V::Width);
+        }
+
+        T* o = out + first * V::Width;
+        for (size_t i = 0; i < steps; ++i, o += Lanes)
+        {
+            for (size_t r = 0; r < G; ++r)
+            {
+                V::Store(o + r * V::Width, V::Add(V::Load(o + r * V::Width), vs[r]));
+                auto sn = V::Add(V::Mul(vs[r], rc), V::Mul(vc[r], rs));
+                auto cn = V::Sub(V::Mul(vc[r], rc), V::Mul(vs[r], rs));
+                vs[r] = sn;
+                vc[r] = cn;
+            }
+        }
+
+        for (size_t r = 0; r < G; ++r)
+        {
+            V::Store(s + (first + r) * V::Width, vs[r]);
+            V::Store(c + (first + r) * V::Width, vc[r]);
+        }
+    }
+}
+
+// Lanes run across outputs, a few registers of them per pass so that
+// each broadcast tap feeds several independent sums. Every output adds
+// its products in tap order, exactly like the scalar tail.
+template <class V, class T = typename V::Scalar>
+void fir(T* out, const T* x, size_t count, const T* h, size_t taps)
+{
+    constexpr size_t W = V::Width;
+    constexpr size_t R = 4;
+
+    size_t i = 0;
+    for (; i + R * W <= count; i += R * W)
+    {
+        typename V::Reg acc[R];
+        for (size_t r = 0; r < R; ++r) acc[r] = V::Set1(T(0));
+        for (size_t k = 0; k < taps; ++k)
+        {
+            const auto c = V::Set1(h[k]);
+            for (size_t r = 0; r < R; ++r)
+            {
+                acc[r] = V::Add(acc[r], V::Mul(c, V::Load(x + i + r * W + k)));
+            }
+        }
+        for (size_t r = 0; r < R; ++r) V::Store(out + i + r * W, acc[r]);
+    }
+    for (; i + W <= count; i += W)
+    {
+        auto acc = V::Set1(T(0));
+        for (size_t k = 0; k < taps; ++k) acc = V::Add(acc, V::Mul(V::Set1(h[k]), V::Load(x + i + k)));
+        V::Store(out + i, acc);
+    }
+    for (; i < count; ++i)
+    {
+        T acc = T(0);
+        for (size_t k = 0; k < taps; ++k) acc = acc + h[k] * x[i + k];
+        out[i] = acc;
+    }
+}
+
+template <class V>
+constexpr FftKernels<typename V::Scalar> make_fft_kernels()
+{
+    static_assert(kOscillatorLanes<typename V::Scalar> % V::Width == 0);
+    return {
+        &run_stage<V, Radix2>,
+        &run_stage<V, Radix3>,
+        &run_stage<V, Radix4>,
+        &run_stage<V, Radix5>,
+        &run_stage<V, Radix7>,
+        &run_batch_stage<V, Radix2>,
+        &run_batch_stage<V, Radix3>,
+        &run_batch_stage<V, Radix4>,
+        &run_batch_stage<V, Radix5>,
+        &run_batch_stage<V, Radix7>,
+        &oscillate<V>,
+        &fir<V>,
+    };
+}
+
+// VD and VF are the double and float vector types of one instruction set.
+template <class VD, class VF>
+constexpr FftKernelSet make_fft_kernel_set()
+{
+    return { make_fft_kernels<VD>(), make_fft_kernels<VF>() };
+}
+}
+
+// Instruction-set specific tables; nullptr when not compiled for this target.
+const FftKernelSet* fft_kernels_sse2();
+const FftKernelSet* fft_kernels_avx2();
+const FftKernelSet* fft_kernels_avx512();
+
+// Tables for the current fft_simd_level().
+const FftKernelSet& fft_active_kernels();
@@ -0,0 +1,46 @@
+#include "fft_kernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+
+#include <emmintrin.h>
+
+namespace
+{
+struct Sse2Vec
+{
+    using Scalar = double;
+    using Reg = __m128d;
+    static constexpr size_t Width = 2;
+
+    static Reg Load(const double* p) { return _mm_loadu_pd(p); }
+    static void Store(double* p, Reg v) { _mm_storeu_pd(p, v); }
+    static Reg Set1(double v) { return _mm_set1_pd(v); }
+    static Reg Add(Reg a, Reg b) { return _mm_add_pd(a, b); }
+    static Reg Sub(Reg a, Reg b) { return _mm_sub_pd(a, b); }
+    static Reg Mul(Reg a, Reg b) { return _mm_mul_pd(a, b); }
+};
+
+struct Sse2VecF
+{
+    using Scalar = float;
+    using Reg = __m128;
+    static constexpr size_t Width = 4;
+
+    static Reg Load(const float* p) { return _mm_loadu_ps(p); }
+    static void Store(float* p, Reg v) { _mm_storeu_ps(p, v); }
+    static Reg Set1(float v) { return _mm_set1_ps(v); }
+    static Reg Add(Reg a, Reg b) { return _mm_add_ps(a, b); }
+    static Reg Sub(Reg a, Reg b) { return _mm_sub_ps(a, b); }
+    static Reg Mul(Reg a, Reg b) { return _mm_mul_ps(a, b); }
+};
+
+const FftKernelSet kKernels = make_fft_kernel_set<Sse2Vec, Sse2VecF>();
+}
+
+const FftKernelSet* fft_kernels_sse2() { return &kKernels; }
+
+#else
+
+const FftKernelSet* fft_kernels_sse2() { return nullptr; }
+
+#endif
@@ -0,0 +1,207 @@
+#include "fir.h"
+#include "fft_kernels.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+// Samples per direct-form pass; the history is copied once per pass.
+constexpr size_t kFirDirectBlock = 4096;
+
+// sin(pi x) / (pi x)
+double sinc(double x)
+{
+    if (x == 0) return 1;
+    return std::sin(PI * x) / (PI * x);
+}
+}
+
+void design_fir(double low, double high, double* taps, size_t count)
+{
+    if (count == 0) return;
+    if (!(low >= 0 && low <= high && high <= 0.5))
+    {
+        throw std::invalid_argument("design_fir: need 0 <= low <= high <= 0.5");
+    }
+
+    // The second half mirrors the first, so the kernel is exactly
+    // symmetric.
+    const double middle = 0.5 * double(count - 1);
+    for (size_t k = 0; k < (count + 1) / 2; ++k)
+    {
+        double m = double(k) - middle;
+        double ideal = 2 * high * sinc(2 * high * m) - 2 * low * sinc(2 * low * m);
+        double window = 1;
+        if (count > 1)
+        {
+            double phase = 2 * PI * double(k) / double(count - 1);
+            window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2 * phase);
+        }
+        taps[k] = taps[count - 1 - k] = ideal * window;
+    }
+
+    // Unit gain at the centre of the passband.
+    const double centre = low == 0 ? 0 : 0.5 * (low + high);
+    Complex gain = 0;
+    for (size_t k = 0; k < count; ++k) gain += taps[k] * std::polar(1.0, -2 * PI * centre * double(k));
+    const double scale = std::abs(gain) > 0 ? 1 / std::abs(gain) : 1;
+    for (size_t k = 0; k < count; ++k) taps[k] *= scale;
+}
+
+size_t fir_direct_max_taps()
+{
+    switch (fft_simd_level())
+    {
+    case SimdLevel::Avx512: return 256;
+    case SimdLevel::Avx2: return 192;
+    case SimdLevel::Sse2: return 128;
+    default: return 64;
+    }
+}
+
+std::vector<double> design_fir(double low, double high, size_t count)
+{
+    std::vector<double> taps(count);
+    design_fir(low, high, taps.data(), count);
+    return taps;
+}
+
+template <class T>
+void BasicFirFilter<T>::SetTaps(const double* taps, size_t count)
+{
+    m_Taps.resize(count);
+    std::reverse_copy(taps, taps + count, m_Taps.begin());
+
+    if (count <= fir_direct_max_taps())
+    {
+        m_Plan = nullptr;
+        m_Response.clear();
+        m_Block = kFirDirectBlock;
+    }
+    else
+    {
+        // The kernel spectrum is computed through the plan's own input
+        // buffer, the window, so nothing is allocated for it.
+        size_t n = std::max(kFirMinFftSize, std::bit_ceil(kFirFftFactor * count));
+        m_Plan = &get_real_fft_plan<T>(n);
+        m_Block = n - (count - 1);
+        m_Response.resize(m_Plan->Bins());
+        m_State.window.resize(n);
+        std::copy(taps, taps + count, m_State.window.begin());
+        std::fill(m_State.window.begin() + count, m_State.window.end(), T(0));
+        m_Plan->Forward(m_State.window.data(), m_Response.data());
+    }
+    Reset();
+}
+
+template <class T>
+void BasicFirFilter<T>::Prepare(State& state) const
+{
+    const size_t history = m_Taps.empty() ? 0 : m_Taps.size() - 1;
+    if (m_Plan)
+    {
+        state.window.resize(m_Plan->Size());
+        state.result.resize(m_Plan->Size());
+        state.spectrum.resize(m_Plan->Bins());
+    }
+    else
+    {
+        state.window.resize(history + m_Block);
+        state.result.resize(m_Block);
+    }
+    std::fill_n(state.window.begin(), history, T(0));
+}
+
+template <class T>
+void BasicFirFilter<T>::Reset()
+{
+    Prepare(m_State);
+}
+
+template <class T>
+const T* BasicFirFilter<T>::Step(State& state, const T* in, size_t available, size_t count) const
+{
+    const size_t taps = m_Taps.size();
+    T* window = state.window.data();
+    T* result = state.result.data();
+    std::copy_n(in, available, window + taps - 1);
+    std::fill(window + taps - 1 + available, window + taps - 1 + count, T(0));
+
+    const T* out = result;
+    if (!m_Plan)
+    {
+        fft_active_kernels().For<T>().fir(result, window, count, m_Taps.data(), taps);
+    }
+    else
+    {
+        // Outputs taps - 1 and up of the circular convolution read no
+        // wrapped samples. A short block is padded so that stale samples
+        // past it cannot turn into NaN or overflow in the transform.
+        std::fill(window + taps - 1 + count, window + m_Plan->Size(), T(0));
+        ComplexT* spectrum = state.spectrum.data();
+        m_Plan->Forward(window, spectrum);
+        // Written out: std::complex multiplication checks for NaN and
+        // infinities through a library call per bin.
+        for (size_t k = 0; k < m_Response.size(); ++k)
+        {
+            T xr = spectrum[k].real(), xi = spectrum[k].imag();
+            T hr = m_Response[k].real(), hi = m_Response[k].imag();
+            spectrum[k] = { xr * hr - xi * hi, xr * hi + xi * hr };
+        }
+        m_Plan->Inverse(spectrum, result);
+        out = result + taps - 1;
+    }
+
+    // The newest taps - 1 inputs become the next block's history.
+    std::copy(window + count, window + count + taps - 1, window);
+    return out;
+}
+
+template <class T>
+void BasicFirFilter<T>::Process(const T* in, T* out, size_t count)
+{
+    if (m_Taps.empty())
+    {
+        std::fill_n(out, count, T(0));
+        return;
+    }
+    for (size_t done = 0; done < count;)
+    {
+        size_t n = std::min(m_Block, count - done);
+        const T* y = Step(m_State, in + done, n, n);
+        std::copy_n(y, n, out + done);
+        done += n;
+    }
+}
+
+template <class T>
+void BasicFirFilter<T>::Apply(const T* in, T* out, size_t n) const
+{
+    if (m_Taps.empty())
+    {
+        std::fill_n(out, n, T(0));
+        return;
+    }
+
+    // Runs Delay() samples past the end on zeros and drops the first
+    // Delay() outputs.
+    thread_local State state;
+    Prepare(state);
+    const size_t delay = Delay(), total = n + delay;
+    for (size_t first = 0; first < total;)
+    {
+        size_t count = std::min(m_Block, total - first);
+        size_t available = first < n ? std::min(count, n - first) : 0;
+        const T* y = Step(state, in + std::min(first, n), available, count);
+
+        size_t skip = first < delay ? std::min(count, delay - first) : 0;
+        std::copy(y + skip, y + count, out + first + skip - delay);
+        first += count;
+    }
+}
+
+template class BasicFirFilter<double>;
+template class BasicFirFilter<float>;
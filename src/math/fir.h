@@ -0,0 +1,91 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+#include "fft.h"
+
+// Windowed-sinc design of `count` taps: the ideal band-pass between low and
+// high, in cycles per sample (0 <= low <= high <= 0.5), under a Blackman
+// window; low = 0 gives a low-pass and an empty band a zero kernel. The
+// kernel is symmetric, so its delay is (count - 1) / 2 samples at every
+// frequency, and its gain is 1 at the centre of the band (at DC for a
+// low-pass).
+void design_fir(double low, double high, double* taps, size_t count);
+std::vector<double> design_fir(double low, double high, size_t count);
+
+// Kernels up to fir_direct_max_taps() taps run in direct form in the SIMD
+// kernels of the active fft_simd_level(); longer ones by overlap-save
+// through a cached real FFT plan of kFirFftFactor times the kernel length,
+// at least kFirMinFftSize points. The direct form costs a multiply-add per
+// tap and sample, split over the vector lanes, while overlap-save costs
+// about the same per sample at any length, so the crossover grows with
+// the vector width: 64 taps for scalar code, 128 for SSE2, 192 for AVX2
+// and 256 for AVX-512, measured in double.
+size_t fir_direct_max_taps();
+constexpr size_t kFirFftFactor = 8;
+constexpr size_t kFirMinFftSize = 1024;
+
+// FIR filter y[i] = sum of h[k] * x[i - k]. Process runs it on a stream,
+// keeping the last Taps() - 1 inputs between calls, so any split of a
+// stream gives the same output up to rounding. Apply filters a whole
+// signal at once and compensates the delay of a linear-phase kernel.
+//
+// Neither allocates once the tap count is stable. T is the sample type,
+// double or float; instantiated for both in fir.cpp.
+template <class T>
+class BasicFirFilter
+{
+public:
+    using ComplexT = std::complex<T>;
+
+    BasicFirFilter() = default;
+    explicit BasicFirFilter(const std::vector<double>& taps) { SetTaps(taps.data(), taps.size()); }
+
+    // Replaces the kernel and clears the stream history. Buffers are
+    // reused while the tap count stays the same.
+    void SetTaps(const double* taps, size_t count);
+
+    size_t Taps() const { return m_Taps.size(); }
+    // Delay of a symmetric kernel, (Taps() - 1) / 2.
+    size_t Delay() const { return m_Taps.empty() ? 0 : (m_Taps.size() - 1) / 2; }
+    bool IsDirect() const { return m_Plan == nullptr; }
+    // Samples per FFT block, or per direct-form pass.
+    size_t BlockSize() const { return m_Block; }
+
+    // Filters count samples of the stream; samples before the first call
+    // since SetTaps or Reset are zero. in and out may be the same.
+    void Process(const T* in, T* out, size_t count);
+    void Reset();
+
+    // Filters n samples with zeros outside them and advances the output
+    // by Delay(), so a linear-phase kernel lines up with the input. Uses
+    // per-thread scratch, so one filter can serve several threads.
+    void Apply(const T* in, T* out, size_t n) const;
+
+private:
+    // History, then the block being filtered.
+    struct State
+    {
+        std::vector<T> window, result;
+        std::vector<ComplexT> spectrum;
+    };
+
+    void Prepare(State& state) const;
+    // Filters the next count <= BlockSize() samples of a stream, of which
+    // the first `available` come from in and the rest are zero. Returns
+    // the count outputs.
+    const T* Step(State& state, const T* in, size_t available, size_t count) const;
+
+    // Reversed, for the direct form.
+    std::vector<T> m_Taps;
+    const BasicRealFftPlan<T>* m_Plan = nullptr;
+    // Kernel spectrum at the plan's size.
+    std::vector<ComplexT> m_Response;
+    size_t m_Block = 0;
+    State m_State;
+};
+
+using FirFilter = BasicFirFilter<double>;
+using FirFilterF = BasicFirFilter<float>;
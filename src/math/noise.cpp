@@ -0,0 +1,187 @@
+#include "noise.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+constexpr uint32_t kPhiloxM0 = 0xD2511F53;
+constexpr uint32_t kPhiloxM1 = 0xCD9E8D57;
+constexpr uint32_t kPhiloxW0 = 0x9E3779B9;
+constexpr uint32_t kPhiloxW1 = 0xBB67AE85;
+
+// Pairs whose Philox blocks are generated per batch, across the batch so
+// the rounds can run in vector lanes.
+constexpr size_t kBatchPairs = 128;
+
+// 53-bit uniform from two 32-bit words; plus one keeps it in (0, 1] so the
+// logarithm below stays finite.
+inline double uniform_open(uint32_t hi, uint32_t lo)
+{
+    uint64_t bits = ((uint64_t(hi) << 32) | lo) >> 11;
+    return double(bits + 1) * 0x1.0p-53;
+}
+
+inline double uniform_closed(uint32_t hi, uint32_t lo)
+{
+    uint64_t bits = ((uint64_t(hi) << 32) | lo) >> 11;
+    return double(bits) * 0x1.0p-53;
+}
+
+inline void philox_round(uint32_t& x0, uint32_t& x1, uint32_t& x2, uint32_t& x3, uint32_t k0, uint32_t k1)
+{
+    uint64_t p0 = uint64_t(kPhiloxM0) * x0;
+    uint64_t p1 = uint64_t(kPhiloxM1) * x2;
+    uint32_t c0 = uint32_t(p1 >> 32) ^ x1 ^ k0;
+    uint32_t c1 = uint32_t(p1);
+    uint32_t c2 = uint32_t(p0 >> 32) ^ x3 ^ k1;
+    uint32_t c3 = uint32_t(p0);
+    x0 = c0;
+    x1 = c1;
+    x2 = c2;
+    x3 = c3;
+}
+
+// Ziggurat of 128 layers of equal area under exp(-x^2 / 2), after
+// Doornik's ZIGNOR: x[1] = R starts the tail, x[0] = V / f(R) is the width
+// the base strip would have as a rectangle, x[128] = 0.
+constexpr size_t kZigguratLayers = 128;
+constexpr double kZigguratR = 3.442619855899;
+constexpr double kZigguratV = 9.91256303526217e-3;
+
+struct Ziggurat
+{
+    double x[kZigguratLayers + 1];
+    // x[i + 1] / x[i]: the part of layer i that lies under the curve.
+    double ratio[kZigguratLayers];
+
+    Ziggurat()
+    {
+        double f = std::exp(-0.5 * kZigguratR * kZigguratR);
+        x[0] = kZigguratV / f;
+        x[1] = kZigguratR;
+        x[kZigguratLayers] = 0;
+        for (size_t i = 2; i < kZigguratLayers; ++i)
+        {
+            x[i] = std::sqrt(-2 * std::log(kZigguratV / x[i - 1] + f));
+            f = std::exp(-0.5 * x[i] * x[i]);
+        }
+        for (size_t i = 0; i < kZigguratLayers; ++i) ratio[i] = x[i + 1] / x[i];
+    }
+};
+
+const Ziggurat& ziggurat()
+{
+    static const Ziggurat table;
+    return table;
+}
+
+// The first draw of a sample: bits are the 64 bits of its pair's block
+// that belong to it, the low 7 picking a layer and the top 53 a position
+// across it. Inside the layer's rectangle under the curve, the position
+// scaled to the layer is the sample.
+inline bool ziggurat_draw(const Ziggurat& z, uint64_t bits, size_t& layer, double& u)
+{
+    layer = bits & (kZigguratLayers - 1);
+    u = 2 * double(bits >> 11) * 0x1.0p-53 - 1;
+    return std::abs(u) < z.ratio[layer];
+}
+
+// The rest of a sample whose first draw missed, about 1 in 80: the wedge
+// or tail test, then fresh draws until one is accepted. Attempt a takes
+// the block at counter (pair, 2a + 1, half) for its test and (pair,
+// 2a + 2, half) for the next draw, so the sample still depends only on
+// (seed, index).
+double ziggurat_rest(const Ziggurat& z, size_t layer, double u, uint64_t seed, uint64_t pair, uint32_t half)
+{
+    for (uint32_t attempt = 0;; ++attempt)
+    {
+        uint32_t test[4] = { uint32_t(pair), uint32_t(pair >> 32), 2 * attempt + 1, half };
+        philox4x32(test, seed);
+        if (layer == 0)
+        {
+            // Marsaglia's tail beyond R. The base strip already holds the
+            // tail's exact mass, so a rejection retries the tail rather
+            // than drawing a new layer.
+            double x = -std::log(uniform_open(test[0], test[1])) / kZigguratR;
+            double y = -std::log(uniform_open(test[2], test[3]));
+            if (2 * y > x * x) return u < 0 ? -(kZigguratR + x) : kZigguratR + x;
+            continue;
+        }
+
+        double x = u * z.x[layer];
+        double f0 = std::exp(-0.5 * (z.x[layer] * z.x[layer] - x * x));
+        double f1 = std::exp(-0.5 * (z.x[layer + 1] * z.x[layer + 1] - x * x));
+        if (f1 + uniform_closed(test[0], test[1]) * (f0 - f1) < 1) return x;
+
+        uint32_t next[4] = { uint32_t(pair), uint32_t(pair >> 32), 2 * attempt + 2, half };
+        philox4x32(next, seed);
+        if (ziggurat_draw(z, (uint64_t(next[0]) << 32) | next[1], layer, u)) return u * z.x[layer];
+    }
+}
+
+// Samples [first, first + n) of the stream. Sample i takes words 2 * (i %
+// 2) and 2 * (i % 2) + 1 of the block at counter (i / 2, 0, 0).
+template <class T>
+void gaussian_samples(uint64_t seed, uint64_t first, T* out, size_t n)
+{
+    const Ziggurat& z = ziggurat();
+    uint32_t w0[kBatchPairs], w1[kBatchPairs], w2[kBatchPairs], w3[kBatchPairs];
+
+    while (n > 0)
+    {
+        const uint64_t pair = first / 2;
+        const size_t pairs = std::min(kBatchPairs, size_t((first + n + 1) / 2 - pair));
+        for (size_t k = 0; k < pairs; ++k)
+        {
+            w0[k] = uint32_t(pair + k);
+            w1[k] = uint32_t((pair + k) >> 32);
+            w2[k] = 0;
+            w3[k] = 0;
+        }
+        uint32_t k0 = uint32_t(seed), k1 = uint32_t(seed >> 32);
+        for (int round = 0; round < 10; ++round)
+        {
+            for (size_t k = 0; k < pairs; ++k) philox_round(w0[k], w1[k], w2[k], w3[k], k0, k1);
+            k0 += kPhiloxW0;
+            k1 += kPhiloxW1;
+        }
+
+        // An odd start or end takes one element of a pair.
+        const uint64_t end = std::min(first + n, 2 * (pair + pairs));
+        for (uint64_t i = first; i < end; ++i)
+        {
+            const size_t k = size_t(i / 2 - pair);
+            const uint64_t bits = i % 2 ? (uint64_t(w2[k]) << 32) | w3[k] : (uint64_t(w0[k]) << 32) | w1[k];
+            size_t layer;
+            double u;
+            double x = ziggurat_draw(z, bits, layer, u) ? u * z.x[layer]
+                                                        : ziggurat_rest(z, layer, u, seed, i / 2, uint32_t(i % 2));
+            *out++ = T(x);
+        }
+        n -= size_t(end - first);
+        first = end;
+    }
+}
+}
+
+void philox4x32(uint32_t counter[4], uint64_t key)
+{
+    uint32_t k0 = uint32_t(key), k1 = uint32_t(key >> 32);
+    for (int round = 0; round < 10; ++round)
+    {
+        philox_round(counter[0], counter[1], counter[2], counter[3], k0, k1);
+        k0 += kPhiloxW0;
+        k1 += kPhiloxW1;
+    }
+}
+
+void gaussian_noise(uint64_t seed, uint64_t first, double* out, size_t n)
+{
+    gaussian_samples(seed, first, out, n);
+}
+
+void gaussian_noise(uint64_t seed, uint64_t first, float* out, size_t n)
+{
+    gaussian_samples(seed, first, out, n);
+}
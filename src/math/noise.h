@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Counter-based Gaussian noise. Sample i of a stream depends only on
+// (seed, i), so any range of it can be generated on its own, in any order
+// and on any thread, and a whole run can be reproduced from the seed.
+//
+// Bits come from Philox4x32-10, one block per pair of samples, and are
+// turned into N(0, 1) by a 128-layer ziggurat: nearly every sample costs
+// a table lookup and a multiply, and the few draws it rejects take
+// further blocks keyed by the sample's own index.
+
+// Writes samples [first, first + n) of the stream for seed into out. The
+// float stream is the double one rounded, sample for sample.
+void gaussian_noise(uint64_t seed, uint64_t first, double* out, size_t n);
+void gaussian_noise(uint64_t seed, uint64_t first, float* out, size_t n);
+
+// Philox4x32-10 block for a 128-bit counter and 64-bit key, in place.
+void philox4x32(uint32_t counter[4], uint64_t key);
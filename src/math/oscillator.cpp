@@ -0,0 +1,116 @@
+#include "oscillator.h"
+#include "fft_kernels.h"
+#include "util/ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+// Per-tone lane offsets: sin/cos(omega * j) for j < Lanes, then
+// sin/cos(omega * Lanes) as the per-step rotation. Kept in double for the
+// fan-out at each block start.
+template <class T>
+struct LaneRotation
+{
+    static constexpr size_t Lanes = kOscillatorLanes<T>;
+
+    double s[Lanes + 1], c[Lanes + 1];
+};
+
+template <class T>
+std::vector<LaneRotation<T>>& thread_rotations(size_t count)
+{
+    thread_local std::vector<LaneRotation<T>> rotations;
+    rotations.resize(count);
+    return rotations;
+}
+
+// Everything a chunk of blocks reads, behind the one pointer a
+// parallel_for body captures.
+template <class T>
+struct SynthesisJob
+{
+    const Sinusoid* tones;
+    size_t count;
+    const LaneRotation<T>* rotations;
+    OscillatorKernel<T> oscillate;
+    T* out;
+};
+
+// Blocks [begin, end) of out, begin a multiple of kOscillatorBlock.
+template <class T>
+void synthesize_blocks(const SynthesisJob<T>& job, size_t begin, size_t end)
+{
+    constexpr size_t Lanes = kOscillatorLanes<T>;
+
+    // Blocks are the outer loop so the output stays in cache while every
+    // tone is added to it.
+    for (; begin < end; begin += kOscillatorBlock)
+    {
+        size_t len = std::min(kOscillatorBlock, end - begin);
+        T* block = job.out + begin;
+        std::fill(block, block + len, T(0));
+
+        for (size_t t = 0; t < job.count; ++t)
+        {
+            const Sinusoid& tone = job.tones[t];
+            const LaneRotation<T>& rot = job.rotations[t];
+            if (tone.amplitude == 0) continue;
+
+            // Exact phasor at the block start, fanned out so lane j holds
+            // sample begin + j.
+            double arg = tone.omega * double(begin) + tone.phase;
+            double s0 = tone.amplitude * std::sin(arg);
+            double c0 = tone.amplitude * std::cos(arg);
+
+            T s[Lanes], c[Lanes];
+            for (size_t j = 0; j < Lanes; ++j)
+            {
+                s[j] = T(s0 * rot.c[j] + c0 * rot.s[j]);
+                c[j] = T(c0 * rot.c[j] - s0 * rot.s[j]);
+            }
+
+            size_t steps = len / Lanes;
+            job.oscillate(block, steps, s, c, T(rot.s[Lanes]), T(rot.c[Lanes]));
+            for (size_t i = steps * Lanes, j = 0; i < len; ++i, ++j)
+            {
+                block[i] += s[j];
+            }
+        }
+    }
+}
+
+template <class T>
+void synthesize(const Sinusoid* tones, size_t count, T* out, size_t n)
+{
+    constexpr size_t Lanes = kOscillatorLanes<T>;
+    // Whole blocks per chunk. Every block starts from exact phasors, so
+    // the samples do not depend on how the chunks are spread.
+    constexpr size_t kChunk = 16 * kOscillatorBlock;
+
+    auto& rotations = thread_rotations<T>(count);
+    for (size_t t = 0; t < count; ++t)
+    {
+        for (size_t j = 0; j <= Lanes; ++j)
+        {
+            rotations[t].s[j] = std::sin(tones[t].omega * j);
+            rotations[t].c[j] = std::cos(tones[t].omega * j);
+        }
+    }
+
+    const SynthesisJob<T> job{ tones, count, rotations.data(), fft_active_kernels().For<T>().oscillate, out };
+    parallel_for(0, n, kChunk, [&job](size_t begin, size_t end) { synthesize_blocks(job, begin, end); });
+}
+}
+
+void synthesize_sinusoids(const Sinusoid* tones, size_t count, double* out, size_t n)
+{
+    synthesize(tones, count, out, n);
+}
+
+void synthesize_sinusoids(const Sinusoid* tones, size_t count, float* out, size_t n)
+{
+    synthesize(tones, count, out, n);
+}
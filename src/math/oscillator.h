@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+
+// One sinusoid amplitude * sin(omega * i + phase), omega in radians per sample.
+struct Sinusoid
+{
+    double amplitude = 0, omega = 0, phase = 0;
+};
+
+// Writes the sum of count sinusoids for samples [0, n) into out.
+//
+// Instead of calling sin() per sample, each sinusoid is advanced by a
+// rotating phasor in the SIMD kernels of the active fft_simd_level(), so
+// every level produces the same samples. All phasors are re-seeded from
+// exact sin/cos every kOscillatorBlock samples, which bounds the
+// accumulated rounding drift to about 1e-14 of the amplitude in double
+// and 1e-5 in float. Runs of whole blocks are spread over parallel_for;
+// the samples do not depend on the number of threads.
+void synthesize_sinusoids(const Sinusoid* tones, size_t count, double* out, size_t n);
+void synthesize_sinusoids(const Sinusoid* tones, size_t count, float* out, size_t n);
+
+constexpr size_t kOscillatorBlock = 1024;
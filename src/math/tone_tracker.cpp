@@ -0,0 +1,168 @@
+#include "tone_tracker.h"
+#include "fft.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// Sums per tone: the frequency itself, then one bin below and one above
+// for the Hann window.
+size_t bins_per_tone(ToneTracker::Window window) { return window == ToneTracker::Window::Hann ? 3 : 1; }
+}
+
+ToneTracker::ToneTracker(const Config& cfg)
+    : m_Config(cfg)
+{
+    m_Config.sampleRate = std::max(1, m_Config.sampleRate);
+    m_Config.windowSize = std::max<size_t>(1, m_Config.windowSize);
+
+    const size_t perTone = bins_per_tone(m_Config.window);
+    const double bin = 2 * PI / double(m_Config.windowSize);
+    m_Bins = Tones() * perTone;
+    for (double f : m_Config.frequencies)
+    {
+        const double omega = 2 * PI * f / m_Config.sampleRate;
+        m_Omega.push_back(omega);
+        if (perTone == 3)
+        {
+            m_Omega.push_back(omega - bin);
+            m_Omega.push_back(omega + bin);
+        }
+    }
+
+    for (auto* v : { &m_Phase, &m_SumRe, &m_SumIm, &m_PhasorRe, &m_PhasorIm, &m_StepRe, &m_StepIm, &m_LeaveRe,
+                     &m_LeaveIm })
+    {
+        v->resize(m_Bins);
+    }
+    for (size_t b = 0; b < m_Bins; ++b)
+    {
+        m_StepRe[b] = std::cos(m_Omega[b]);
+        m_StepIm[b] = -std::sin(m_Omega[b]);
+        const double leave = std::fmod(m_Omega[b] * double(m_Config.windowSize), 2 * PI);
+        m_LeaveRe[b] = std::cos(leave);
+        m_LeaveIm[b] = std::sin(leave);
+    }
+    m_History.resize(m_Config.windowSize);
+    Reset();
+}
+
+void ToneTracker::Reset()
+{
+    std::fill(m_Phase.begin(), m_Phase.end(), 0.0);
+    std::fill(m_SumRe.begin(), m_SumRe.end(), 0.0);
+    std::fill(m_SumIm.begin(), m_SumIm.end(), 0.0);
+    std::fill(m_PhasorRe.begin(), m_PhasorRe.end(), 1.0);
+    std::fill(m_PhasorIm.begin(), m_PhasorIm.end(), 0.0);
+    std::fill(m_History.begin(), m_History.end(), 0.0);
+    m_Head = 0;
+    m_Samples = 0;
+}
+
+void ToneTracker::Seed()
+{
+    for (size_t b = 0; b < m_Bins; ++b)
+    {
+        m_Phase[b] = std::fmod(m_Phase[b] + m_Omega[b] * double(kBlock), 2 * PI);
+        m_PhasorRe[b] = std::cos(m_Phase[b]);
+        m_PhasorIm[b] = -std::sin(m_Phase[b]);
+    }
+}
+
+void ToneTracker::Process(const double* samples, size_t count)
+{
+    const size_t window = m_Config.windowSize;
+    while (count > 0)
+    {
+        if (m_Samples > 0 && m_Samples % kBlock == 0) Seed();
+
+        // A run neither wraps the history nor crosses a seeding point.
+        const size_t run = std::min({ count, window - m_Head, size_t(kBlock - m_Samples % kBlock) });
+        double* leaving = m_History.data() + m_Head;
+        size_t b = 0;
+        for (; b + 4 <= m_Bins; b += 4) Track<4>(b, samples, leaving, run);
+        switch (m_Bins - b)
+        {
+        case 3: Track<3>(b, samples, leaving, run); break;
+        case 2: Track<2>(b, samples, leaving, run); break;
+        case 1: Track<1>(b, samples, leaving, run); break;
+        default: break;
+        }
+        std::copy_n(samples, run, leaving);
+
+        m_Head = (m_Head + run) % window;
+        m_Samples += run;
+        samples += run;
+        count -= run;
+    }
+}
+
+template <size_t G>
+void ToneTracker::Track(size_t first, const double* in, const double* out, size_t count)
+{
+    // Held in locals, G independent recurrences per sample keep the
+    // multipliers busy instead of waiting on one phasor after another.
+    double sumRe[G], sumIm[G], pr[G], pi[G], stepRe[G], stepIm[G], leaveRe[G], leaveIm[G];
+    for (size_t g = 0; g < G; ++g)
+    {
+        sumRe[g] = m_SumRe[first + g];
+        sumIm[g] = m_SumIm[first + g];
+        pr[g] = m_PhasorRe[first + g];
+        pi[g] = m_PhasorIm[first + g];
+        stepRe[g] = m_StepRe[first + g];
+        stepIm[g] = m_StepIm[first + g];
+        leaveRe[g] = m_LeaveRe[first + g];
+        leaveIm[g] = m_LeaveIm[first + g];
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (size_t g = 0; g < G; ++g)
+        {
+            // x[m] e^(-i omega m) - x[m - N] e^(-i omega (m - N))
+            //     = e^(-i omega m) (x[m] - x[m - N] e^(i omega N))
+            const double dr = in[i] - out[i] * leaveRe[g], di = -out[i] * leaveIm[g];
+            sumRe[g] += pr[g] * dr - pi[g] * di;
+            sumIm[g] += pr[g] * di + pi[g] * dr;
+            const double r = pr[g] * stepRe[g] - pi[g] * stepIm[g];
+            pi[g] = pr[g] * stepIm[g] + pi[g] * stepRe[g];
+            pr[g] = r;
+        }
+    }
+    for (size_t g = 0; g < G; ++g)
+    {
+        m_SumRe[first + g] = sumRe[g];
+        m_SumIm[first + g] = sumIm[g];
+        m_PhasorRe[first + g] = pr[g];
+        m_PhasorIm[first + g] = pi[g];
+    }
+}
+
+void ToneTracker::Estimates(ToneEstimate* out) const
+{
+    const size_t window = m_Config.windowSize;
+    const bool hann = m_Config.window == Window::Hann;
+    // Sum of the window weights.
+    const double gain = hann ? 0.5 * double(window) : double(window);
+
+    // The Hann window starts at sample n - N; its cosine, taken against
+    // the absolute index like the sums, turns into the rotation
+    // e^(i 2 pi (n - N) / N) = e^(i 2 pi n / N) of the neighbour bins.
+    const Complex rotation = std::polar(1.0, 2 * PI * double(m_Samples % window) / double(window));
+
+    for (size_t t = 0; t < Tones(); ++t)
+    {
+        const size_t b = t * bins_per_tone(m_Config.window);
+        Complex sum(m_SumRe[b], m_SumIm[b]);
+        if (hann)
+        {
+            const Complex below(m_SumRe[b + 1], m_SumIm[b + 1]), above(m_SumRe[b + 2], m_SumIm[b + 2]);
+            sum = 0.5 * sum - 0.25 * std::conj(rotation) * below - 0.25 * rotation * above;
+        }
+
+        // A sin(omega m + phase) sums to gain * A / 2 * e^(i (phase - pi / 2)).
+        double phase = std::arg(sum) + 0.5 * PI;
+        if (phase > PI) phase -= 2 * PI;
+        out[t] = { m_Config.frequencies[t], 2 * std::abs(sum) / gain, phase };
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Amplitude and phase of a tracked tone, read as in SinParam:
+// amplitude * sin(2 pi frequency t + phase), t in seconds from the first
+// sample of the stream.
+struct ToneEstimate
+{
+    double frequency = 0, amplitude = 0, phase = 0;
+};
+
+// Sliding DFT at a few known frequencies. Every frequency keeps the sum of
+// x[m] e^(-i omega m) over the last windowSize samples and updates it for
+// the sample entering and the one leaving the window, so each sample costs
+// a few multiply-adds per frequency instead of a transform of the window,
+// and an estimate can be read at any time.
+//
+// The sums are taken against the absolute sample index rather than rotated
+// with the window, so rounding errors add up as a random walk instead of
+// circulating through a pole on the unit circle. The phasors are re-seeded
+// from exact phases every kBlock samples, as in synthesize_sinusoids, and
+// the results do not depend on how the stream is cut into calls.
+//
+// The rectangular window is exact for tones with a whole number of cycles
+// in the window. The Hann window combines three sums, at the frequency and
+// one bin either side, and keeps the leakage between other tones small;
+// tones should then be at least two bins, 2 * sampleRate / windowSize Hz,
+// apart and away from 0 and sampleRate / 2.
+class ToneTracker
+{
+public:
+    enum class Window
+    {
+        Rectangular,
+        Hann,
+    };
+
+    struct Config
+    {
+        int sampleRate = 48000;
+        // Hz, within (0, sampleRate / 2).
+        std::vector<double> frequencies;
+        size_t windowSize = 4096;
+        Window window = Window::Hann;
+    };
+
+    static constexpr size_t kBlock = 1024;
+
+    explicit ToneTracker(const Config& cfg);
+
+    const Config& GetConfig() const { return m_Config; }
+
+    void Process(const double* samples, size_t count);
+    void Reset();
+
+    size_t Tones() const { return m_Config.frequencies.size(); }
+    uint64_t Samples() const { return m_Samples; }
+    // True once a whole window has arrived; before that the missing
+    // samples count as zeros and the amplitudes read low.
+    bool IsSettled() const { return m_Samples >= m_Config.windowSize; }
+
+    // Writes Tones() estimates for the last windowSize samples.
+    void Estimates(ToneEstimate* out) const;
+
+private:
+    // Advances the exact phases to the block starting at m_Samples.
+    void Seed();
+    // Runs bins [first, first + G) over count samples entering from in and
+    // leaving from out.
+    template <size_t G>
+    void Track(size_t first, const double* in, const double* out, size_t count);
+
+    Config m_Config;
+    size_t m_Bins = 0;
+
+    // One sliding sum per frequency and window bin, as parallel arrays so
+    // that the per-sample loop runs across them: the sum, the phasor
+    // e^(-i omega m) and its step e^(-i omega), and e^(i omega windowSize)
+    // for the leaving sample.
+    std::vector<double> m_Omega, m_Phase;
+    std::vector<double> m_SumRe, m_SumIm;
+    std::vector<double> m_PhasorRe, m_PhasorIm;
+    std::vector<double> m_StepRe, m_StepIm;
+    std::vector<double> m_LeaveRe, m_LeaveIm;
+
+    // The last windowSize samples; m_Head is the oldest.
+    std::vector<double> m_History;
+    size_t m_Head = 0;
+    uint64_t m_Samples = 0;
+};
@@ -0,0 +1,137 @@
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path)
+{
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("cannot open '" + path + "'");
+    }
+    m_File = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        Close();
+        throw std::runtime_error("cannot stat '" + path + "'");
+    }
+    m_Size = static_cast<size_t>(size.QuadPart);
+    if (m_Size == 0) return;
+
+    m_Mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = m_Mapping ? MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view)
+    {
+        Close();
+        throw std::runtime_error("cannot map '" + path + "'");
+    }
+    m_Data = static_cast<const uint8_t*>(view);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("cannot open '" + path + "'");
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("cannot stat '" + path + "'");
+    }
+    m_Size = static_cast<size_t>(info.st_size);
+    if (m_Size == 0)
+    {
+        ::close(fd);
+        return;
+    }
+
+    // The mapping keeps its own reference to the file.
+    void* view = ::mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED)
+    {
+        m_Size = 0;
+        throw std::runtime_error("cannot map '" + path + "'");
+    }
+    m_Data = static_cast<const uint8_t*>(view);
+    ::madvise(view, m_Size, MADV_SEQUENTIAL);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_Size = std::exchange(other.m_Size, 0);
+#if defined(_WIN32)
+        m_File = std::exchange(other.m_File, nullptr);
+        m_Mapping = std::exchange(other.m_Mapping, nullptr);
+#endif
+    }
+    return *this;
+}
+
+void MappedFile::Release(size_t offset, size_t length) const
+{
+    if (!m_Data || offset >= m_Size) return;
+    length = std::min(length, m_Size - offset);
+
+#if defined(_WIN32)
+    // Unlocking pages that are not locked removes them from the working
+    // set; the call reports an error for that case, which is expected.
+    VirtualUnlock(const_cast<uint8_t*>(m_Data) + offset, length);
+#else
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t begin = (offset + page - 1) / page * page;
+    size_t end = (offset + length) / page * page;
+    if (begin < end)
+    {
+        ::madvise(const_cast<uint8_t*>(m_Data) + begin, end - begin, MADV_DONTNEED);
+    }
+#endif
+}
+
+void MappedFile::Close()
+{
+#if defined(_WIN32)
+    if (m_Data) UnmapViewOfFile(m_Data);
+    if (m_Mapping) CloseHandle(m_Mapping);
+    if (m_File) CloseHandle(m_File);
+    m_Mapping = nullptr;
+    m_File = nullptr;
+#else
+    if (m_Data) ::munmap(const_cast<uint8_t*>(m_Data), m_Size);
+#endif
+    m_Data = nullptr;
+    m_Size = 0;
+}
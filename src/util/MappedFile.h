@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file. Pages are read on first
+// access and belong to the page cache, so mapping a file larger than RAM
+// is fine; Release drops a range that will not be read again from the
+// process's resident set.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    // Throws std::runtime_error when the file cannot be opened or mapped.
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* Data() const { return m_Data; }
+    size_t Size() const { return m_Size; }
+
+    // Hints that [offset, offset + length) is no longer needed. Only whole
+    // pages inside the range are released; reading them again is allowed
+    // and faults them back in.
+    void Release(size_t offset, size_t length) const;
+
+private:
+    void Close();
+
+    const uint8_t* m_Data = nullptr;
+    size_t m_Size = 0;
+#if defined(_WIN32)
+    void* m_File = nullptr;
+    void* m_Mapping = nullptr;
+#endif
+};
@@ -0,0 +1,95 @@
+#include "MinMaxPyramid.h"
+
+#include <algorithm>
+
+namespace
+{
+constexpr size_t kFanOut = 4;
+// No level is built once a level would have fewer buckets than this.
+constexpr size_t kMinBuckets = 64;
+}
+
+void MinMaxPyramid::Build(const double* x, const double* y, size_t count)
+{
+    m_X = x;
+    m_Y = y;
+    m_Count = count;
+
+    // Levels are resized rather than recreated, so rebuilding a series of
+    // the same length does not allocate.
+    size_t levels = 0;
+    const double* lowerMin = y;
+    const double* lowerMax = y;
+    size_t lowerSize = count;
+    for (size_t bucket = kFanOut; count / bucket >= kMinBuckets; bucket *= kFanOut, ++levels)
+    {
+        if (m_Levels.size() <= levels) m_Levels.emplace_back();
+        Level& level = m_Levels[levels];
+        level.bucket = bucket;
+
+        size_t size = (lowerSize + kFanOut - 1) / kFanOut;
+        level.min.resize(size);
+        level.max.resize(size);
+        for (size_t b = 0; b < size; ++b)
+        {
+            size_t first = b * kFanOut, last = std::min(first + kFanOut, lowerSize);
+            double lo = lowerMin[first], hi = lowerMax[first];
+            for (size_t i = first + 1; i < last; ++i)
+            {
+                lo = std::min(lo, lowerMin[i]);
+                hi = std::max(hi, lowerMax[i]);
+            }
+            level.min[b] = lo;
+            level.max[b] = hi;
+        }
+
+        lowerMin = level.min.data();
+        lowerMax = level.max.data();
+        lowerSize = size;
+    }
+    m_Levels.resize(levels);
+}
+
+void MinMaxPyramid::Query(double xMin, double xMax, size_t columns,
+                          std::vector<double>& xs, std::vector<double>& ys) const
+{
+    xs.clear();
+    ys.clear();
+    if (m_Count == 0) return;
+    columns = std::max<size_t>(columns, 1);
+
+    size_t first = std::lower_bound(m_X, m_X + m_Count, xMin) - m_X;
+    size_t last = std::upper_bound(m_X, m_X + m_Count, xMax) - m_X;
+    first = first > 0 ? first - 1 : 0;
+    last = std::min(last + 1, m_Count);
+    if (first >= last) return;
+
+    // Coarsest level whose buckets are still no wider than a column.
+    size_t span = last - first;
+    const Level* level = nullptr;
+    for (const Level& candidate : m_Levels)
+    {
+        if (candidate.bucket * columns > span) break;
+        level = &candidate;
+    }
+
+    if (!level)
+    {
+        xs.assign(m_X + first, m_X + last);
+        ys.assign(m_Y + first, m_Y + last);
+        return;
+    }
+
+    size_t bucket = level->bucket;
+    size_t begin = first / bucket, end = (last + bucket - 1) / bucket;
+    xs.reserve(2 * (end - begin));
+    ys.reserve(2 * (end - begin));
+    for (size_t b = begin; b < end; ++b)
+    {
+        double x = m_X[b * bucket];
+        xs.push_back(x);
+        ys.push_back(level->min[b]);
+        xs.push_back(x);
+        ys.push_back(level->max[b]);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Min/max decimation pyramid for drawing long series. Level k summarizes
+// buckets of 4^k samples by their minimum and maximum, so a query for
+// any visible range can pick the level that matches the screen resolution
+// and still shows every peak. Building costs O(n) once per data change;
+// queries cost O(columns), independent of the series length.
+class MinMaxPyramid
+{
+public:
+    // x must be ascending. Both arrays are referenced, not copied, and must
+    // stay alive and unchanged until the next Build.
+    void Build(const double* x, const double* y, size_t count);
+
+    size_t Size() const { return m_Count; }
+    const double* X() const { return m_X; }
+
+    // Replaces xs/ys with a polyline for the samples with x in [xMin, xMax]
+    // (plus one neighbour on each side), at most about 8 points per column.
+    // Ranges with few samples per column are returned as is; otherwise each
+    // bucket contributes its minimum and maximum at the bucket start.
+    void Query(double xMin, double xMax, size_t columns,
+               std::vector<double>& xs, std::vector<double>& ys) const;
+
+private:
+    struct Level
+    {
+        size_t bucket;
+        std::vector<double> min, max;
+    };
+
+    const double* m_X = nullptr;
+    const double* m_Y = nullptr;
+    size_t m_Count = 0;
+    std::vector<Level> m_Levels;
+};
@@ -0,0 +1,145 @@
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+thread_local bool t_InsideParallelFor = false;
+
+// One parallel_for call; lives on the caller's stack until every helper
+// that picked it up has left.
+struct Batch
+{
+    size_t begin, end, grain, chunks;
+    const std::function<void(size_t, size_t)>* body;
+
+    std::atomic<size_t> next{ 0 };
+    std::atomic<bool> failed{ false };
+    std::exception_ptr error;
+
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t helpers = 0;
+
+    void Work()
+    {
+        t_InsideParallelFor = true;
+        for (size_t chunk; (chunk = next.fetch_add(1)) < chunks;)
+        {
+            if (failed.load(std::memory_order_relaxed)) continue;
+
+            size_t first = begin + chunk * grain;
+            try
+            {
+                (*body)(first, std::min(end, first + grain));
+            }
+            catch (...)
+            {
+                std::lock_guard lock(mutex);
+                if (!error) error = std::current_exception();
+                failed = true;
+            }
+        }
+        t_InsideParallelFor = false;
+    }
+};
+
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_t threads)
+    {
+        // Sized up front so posting never allocates in steady state.
+        m_Queue.reserve(4 * threads);
+        for (size_t i = 0; i < threads; ++i)
+        {
+            m_Threads.emplace_back([this](std::stop_token stop) { Run(stop); });
+        }
+    }
+
+    ~ThreadPool()
+    {
+        for (auto& thread : m_Threads) thread.request_stop();
+    }
+
+    size_t Size() const { return m_Threads.size(); }
+
+    void Post(Batch* batch, size_t count)
+    {
+        {
+            std::lock_guard lock(m_Mutex);
+            m_Queue.insert(m_Queue.end(), count, batch);
+        }
+        if (count == 1) m_Wake.notify_one();
+        else m_Wake.notify_all();
+    }
+
+private:
+    void Run(std::stop_token stop)
+    {
+        while (true)
+        {
+            Batch* batch;
+            {
+                std::unique_lock lock(m_Mutex);
+                if (!m_Wake.wait(lock, stop, [this] { return !m_Queue.empty(); })) return;
+                batch = m_Queue.front();
+                m_Queue.erase(m_Queue.begin());
+            }
+
+            batch->Work();
+
+            std::lock_guard lock(batch->mutex);
+            if (--batch->helpers == 0) batch->done.notify_one();
+        }
+    }
+
+    std::mutex m_Mutex;
+    std::condition_variable_any m_Wake;
+    std::vector<Batch*> m_Queue;
+    std::vector<std::jthread> m_Threads;
+};
+
+ThreadPool& pool()
+{
+    static ThreadPool instance(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return instance;
+}
+}
+
+size_t parallel_concurrency()
+{
+    return pool().Size() + 1;
+}
+
+void parallel_for(size_t begin, size_t end, size_t grain,
+                  const std::function<void(size_t, size_t)>& body)
+{
+    if (begin >= end) return;
+    grain = std::max<size_t>(grain, 1);
+
+    Batch batch;
+    batch.begin = begin;
+    batch.end = end;
+    batch.grain = grain;
+    batch.chunks = (end - begin + grain - 1) / grain;
+    batch.body = &body;
+
+    size_t helpers = t_InsideParallelFor ? 0 : std::min(batch.chunks - 1, pool().Size());
+    batch.helpers = helpers;
+    if (helpers > 0) pool().Post(&batch, helpers);
+
+    bool nested = t_InsideParallelFor;
+    batch.Work();
+    t_InsideParallelFor = nested;
+
+    std::unique_lock lock(batch.mutex);
+    batch.done.wait(lock, [&] { return batch.helpers == 0; });
+    if (batch.error) std::rethrow_exception(batch.error);
+}
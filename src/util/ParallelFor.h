@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+// Splits [begin, end) into chunks of at most grain indices and runs
+// body(chunkBegin, chunkEnd) for each of them on a shared pool of worker
+// threads; the calling thread takes chunks as well and returns once all
+// of them are done. Chunk boundaries depend only on the range and grain,
+// so results that are written per index do not depend on scheduling.
+//
+// Calls made from inside a body run serially on the calling thread. The
+// first exception thrown by a body is rethrown after the remaining chunks
+// have been skipped.
+void parallel_for(size_t begin, size_t end, size_t grain,
+                  const std::function<void(size_t, size_t)>& body);
+
+// Threads available to parallel_for, including the caller.
+size_t parallel_concurrency();
@@ -0,0 +1,136 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+// Small stable thread numbers for the trace viewer.
+uint32_t trace_thread_id()
+{
+    static std::atomic<uint32_t> next{ 1 };
+    thread_local uint32_t id = next.fetch_add(1);
+    return id;
+}
+
+void write_json_string(std::ofstream& out, const char* s)
+{
+    out << '"';
+    for (; *s; ++s)
+    {
+        if (*s == '"' || *s == '\\') out << '\\';
+        out << *s;
+    }
+    out << '"';
+}
+}
+
+Profiler& Profiler::Get()
+{
+    static Profiler instance;
+    return instance;
+}
+
+void Profiler::Record(const char* name, Clock::time_point start, Clock::time_point end)
+{
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    uint32_t thread = trace_thread_id();
+
+    std::lock_guard lock(m_Mutex);
+
+    // Few distinct names, so a linear search beats a map here.
+    auto it = std::find_if(m_Series.begin(), m_Series.end(),
+                           [name](const Series& s) { return s.name == name || std::strcmp(s.name, name) == 0; });
+    if (it == m_Series.end())
+    {
+        it = m_Series.emplace(m_Series.end());
+        it->name = name;
+    }
+    it->samples[it->next] = ms;
+    it->next = (it->next + 1) % kWindow;
+    it->count = std::min(it->count + 1, kWindow);
+
+    if (m_Tracing && m_Trace.size() < kMaxTraceEvents)
+    {
+        using std::chrono::microseconds;
+        m_Trace.push_back({ name,
+                            std::chrono::duration_cast<microseconds>(start - m_TraceStart).count(),
+                            std::chrono::duration_cast<microseconds>(end - start).count(),
+                            thread });
+    }
+}
+
+std::vector<Profiler::Stats> Profiler::GetStats() const
+{
+    std::vector<Stats> stats;
+    double window[kWindow];
+
+    std::lock_guard lock(m_Mutex);
+    stats.reserve(m_Series.size());
+    for (const Series& s : m_Series)
+    {
+        if (s.count == 0) continue;
+
+        std::copy(s.samples, s.samples + s.count, window);
+        double sum = 0;
+        for (size_t i = 0; i < s.count; ++i) sum += window[i];
+
+        size_t p99 = std::min(s.count - 1, s.count * 99 / 100);
+        std::nth_element(window, window + p99, window + s.count);
+        double p99Ms = window[p99];
+        double minMs = *std::min_element(window, window + s.count);
+
+        stats.push_back({ s.name, s.count, minMs, sum / s.count, p99Ms });
+    }
+    return stats;
+}
+
+void Profiler::ResetStats()
+{
+    std::lock_guard lock(m_Mutex);
+    m_Series.clear();
+}
+
+void Profiler::BeginTrace()
+{
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Trace.clear();
+        m_TraceStart = Clock::now();
+        m_Tracing = true;
+    }
+    SetEnabled(true);
+}
+
+bool Profiler::EndTrace(const std::string& path)
+{
+    std::vector<TraceEvent> events;
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Tracing = false;
+        events.swap(m_Trace);
+    }
+
+    std::ofstream out(path);
+    if (!out) return false;
+
+    out << "{\"traceEvents\":[";
+    const char* separator = "\n";
+    for (const TraceEvent& e : events)
+    {
+        out << separator << "{\"name\":";
+        write_json_string(out, e.name);
+        out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread << ",\"ts\":" << e.startUs
+            << ",\"dur\":" << e.durationUs << '}';
+        separator = ",\n";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return bool(out);
+}
+
+bool Profiler::IsTracing() const
+{
+    std::lock_guard lock(m_Mutex);
+    return m_Tracing;
+}
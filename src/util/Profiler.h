@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Process-wide scoped timing. Disabled by default: a disabled ScopedTimer
+// costs one relaxed atomic load. When enabled, every scope feeds a rolling
+// window per name, and while a trace is being captured it is also kept as
+// a Chrome trace event (chrome://tracing, Perfetto).
+//
+// Names must be string literals or otherwise outlive the profiler.
+class Profiler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Samples kept per name for the rolling statistics.
+    static constexpr size_t kWindow = 256;
+    // Trace capture stops recording past this many events.
+    static constexpr size_t kMaxTraceEvents = 1 << 20;
+
+    struct Stats
+    {
+        const char* name;
+        size_t samples;
+        double minMs, meanMs, p99Ms;
+    };
+
+    static Profiler& Get();
+
+    void SetEnabled(bool enabled) { m_Enabled.store(enabled, std::memory_order_relaxed); }
+    bool IsEnabled() const { return m_Enabled.load(std::memory_order_relaxed); }
+
+    void Record(const char* name, Clock::time_point start, Clock::time_point end);
+
+    // Statistics over each name's window, in the order names first appeared.
+    std::vector<Stats> GetStats() const;
+    void ResetStats();
+
+    // Starts collecting trace events (and enables the profiler).
+    void BeginTrace();
+    // Stops collecting and writes the events as Chrome trace JSON; returns
+    // false when the file cannot be written.
+    bool EndTrace(const std::string& path);
+    bool IsTracing() const;
+
+private:
+    struct Series
+    {
+        const char* name;
+        double samples[kWindow];
+        size_t count = 0, next = 0;
+    };
+
+    struct TraceEvent
+    {
+        const char* name;
+        int64_t startUs, durationUs;
+        uint32_t thread;
+    };
+
+    std::atomic<bool> m_Enabled{ false };
+
+    mutable std::mutex m_Mutex;
+    std::vector<Series> m_Series;
+    bool m_Tracing = false;
+    Clock::time_point m_TraceStart;
+    std::vector<TraceEvent> m_Trace;
+};
+
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(const char* name)
+        : m_Name(Profiler::Get().IsEnabled() ? name : nullptr)
+    {
+        if (m_Name) m_Start = Profiler::Clock::now();
+    }
+
+    ~ScopedTimer()
+    {
+        if (m_Name) Profiler::Get().Record(m_Name, m_Start, Profiler::Clock::now());
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    const char* m_Name;
+    Profiler::Clock::time_point m_Start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ScopedTimer PROFILE_CONCAT(profileScope, __LINE__)(name)
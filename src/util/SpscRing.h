@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lock-free ring buffer between exactly one producer thread and one
+// consumer thread. Capacity is rounded up to a power of two; indices run
+// freely and are masked on access, so a full ring holds Capacity()
+// elements.
+//
+// Each side owns one index and keeps a cached copy of the other's, which
+// it refreshes only when the cache cannot satisfy the request: a write
+// that does not fit, or a peek shorter than the run up to the wrap point.
+// A consumer working through a long backlog then reads the producer's
+// cache line once per wrap instead of once per call.
+template <class T>
+class SpscRing
+{
+public:
+    // A contiguous run of readable elements, valid until Consume.
+    struct Block
+    {
+        const T* data = nullptr;
+        size_t size = 0;
+    };
+
+    explicit SpscRing(size_t capacity)
+        : m_Buffer(std::bit_ceil(std::max<size_t>(capacity, 2))),
+          m_Mask(m_Buffer.size() - 1)
+    {
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t Capacity() const { return m_Buffer.size(); }
+
+    // Elements waiting to be read; exact only on the consumer thread.
+    size_t Size() const
+    {
+        return m_Head.load(std::memory_order_acquire) - m_Tail.load(std::memory_order_acquire);
+    }
+
+    // Producer: appends as many of the count elements as fit and returns
+    // how many that was. The rest are dropped and counted as overruns.
+    size_t Write(const T* data, size_t count)
+    {
+        const size_t n = TryWrite(data, count);
+        if (n < count) m_Overruns.fetch_add(count - n, std::memory_order_relaxed);
+        return n;
+    }
+
+    // Producer: as Write, but the caller keeps what did not fit and may
+    // offer it again, so nothing counts as dropped.
+    size_t TryWrite(const T* data, size_t count)
+    {
+        const size_t head = m_Head.load(std::memory_order_relaxed);
+        if (Capacity() - (head - m_TailCache) < count)
+        {
+            m_TailCache = m_Tail.load(std::memory_order_acquire);
+        }
+        const size_t n = std::min(count, Capacity() - (head - m_TailCache));
+
+        const size_t first = head & m_Mask;
+        const size_t split = std::min(n, Capacity() - first);
+        std::copy_n(data, split, m_Buffer.data() + first);
+        std::copy_n(data + split, n - split, m_Buffer.data());
+        m_Head.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer: the oldest readable elements up to the wrap point, read in
+    // place. An empty ring returns an empty block; polling is not an
+    // underrun, so nothing is counted.
+    Block Peek()
+    {
+        const size_t tail = m_Tail.load(std::memory_order_relaxed);
+        const size_t first = tail & m_Mask;
+        if (m_HeadCache - tail < Capacity() - first)
+        {
+            m_HeadCache = m_Head.load(std::memory_order_acquire);
+            if (m_HeadCache == tail) return {};
+        }
+        return { m_Buffer.data() + first, std::min(m_HeadCache - tail, Capacity() - first) };
+    }
+
+    // Consumer: releases the first count elements of the last Peek.
+    void Consume(size_t count)
+    {
+        m_Tail.store(m_Tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // Consumer: copies up to count elements into out, returns how many.
+    // A read that comes back short counts one underrun.
+    size_t Read(T* out, size_t count)
+    {
+        size_t done = 0;
+        while (done < count)
+        {
+            Block block = Peek();
+            if (block.size == 0)
+            {
+                CountUnderrun();
+                return done;
+            }
+            size_t n = std::min(block.size, count - done);
+            std::copy_n(block.data, n, out + done);
+            Consume(n);
+            done += n;
+        }
+        return done;
+    }
+
+    // Consumer: records a deadline the producer missed, for consumers that
+    // Peek and know when data was due.
+    void CountUnderrun() { m_Underruns.fetch_add(1, std::memory_order_relaxed); }
+
+    // Elements dropped by Write, and reads that came back short or other
+    // missed deadlines. Readable from any thread.
+    uint64_t Overruns() const { return m_Overruns.load(std::memory_order_relaxed); }
+    uint64_t Underruns() const { return m_Underruns.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t kCacheLine = 64;
+
+    std::vector<T> m_Buffer;
+    const size_t m_Mask;
+
+    // Producer side.
+    alignas(kCacheLine) std::atomic<size_t> m_Head{ 0 };
+    size_t m_TailCache = 0;
+    std::atomic<uint64_t> m_Overruns{ 0 };
+
+    // Consumer side.
+    alignas(kCacheLine) std::atomic<size_t> m_Tail{ 0 };
+    size_t m_HeadCache = 0;
+    std::atomic<uint64_t> m_Underruns{ 0 };
+};
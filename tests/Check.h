@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+// Minimal assertions for the test executables: failures are printed and
+// counted, and main returns check_result() so ctest sees the outcome.
+inline int& check_failures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                              \
+    do                                                                           \
+    {                                                                            \
+        if (!(cond))                                                             \
+        {                                                                        \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++check_failures();                                                  \
+        }                                                                        \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                        \
+    do                                                                                 \
+    {                                                                                  \
+        double a_ = (actual), e_ = (expected), t_ = (tolerance);                       \
+        if (!(std::abs(a_ - e_) <= t_))                                                \
+        {                                                                              \
+            std::printf("%s:%d: %s = %.17g, expected %.17g +- %g\n", __FILE__, __LINE__, \
+                        #actual, a_, e_, t_);                                          \
+            ++check_failures();                                                        \
+        }                                                                              \
+    } while (0)
+
+inline int check_result()
+{
+    if (check_failures() == 0)
+    {
+        std::printf("all checks passed\n");
+        return 0;
+    }
+    std::printf("%d check(s) failed\n", check_failures());
+    return 1;
+}
@@ -0,0 +1,126 @@
+// Steady-state allocation check: after a warm-up at a given size, Update
+// and the streaming filter must not call the global operator new.
+
+#include "Check.h"
+#include "SignalProcessor.h"
+#include "StreamingFilter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace
+{
+std::atomic<size_t> g_Allocations{ 0 };
+
+void* counted_alloc(size_t size)
+{
+    g_Allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+}
+
+void* operator new(size_t size) { return counted_alloc(size); }
+void* operator new[](size_t size) { return counted_alloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace
+{
+// Every kind of edit the UI can make at a fixed pointCount.
+constexpr int kEdits = 11;
+
+void edit(SignalProcessor::Config& cfg, int step)
+{
+    switch (step % kEdits)
+    {
+    case 0: cfg.gamma = cfg.gamma == 1.0f ? 0.9f : 1.0f; break;
+    case 1: cfg.noiseAlpha = cfg.noiseAlpha == 0.2f ? 0.3f : 0.2f; break;
+    case 2: cfg.seed += 1; break;
+    case 3: cfg.harmonics[0].amplitude += 1; break;
+    case 4: cfg.sampleRate = cfg.sampleRate == 1024 ? 1000 : 1024; break;
+    case 5: cfg.filter = FilterKind((size_t(cfg.filter) + 1) % kFilterKindCount); break;
+    case 6: cfg.threshold = cfg.threshold == 3.0f ? 2.0f : 3.0f; break;
+    case 7: cfg.showNoise = !cfg.showNoise; break;
+    case 8: cfg.precision = cfg.precision == Precision::Double ? Precision::Float : Precision::Double; break;
+    case 9: cfg.clean = cfg.clean == CleanSource::Spectral ? CleanSource::Fir : CleanSource::Spectral; break;
+    case 10: cfg.firHigh = cfg.firHigh == 50.0f ? 70.0f : 50.0f; break;
+    }
+}
+
+void test_update()
+{
+    struct Case
+    {
+        int points, channels;
+    };
+    for (Case c : { Case{ 4096, 1 }, Case{ 5000, 1 }, Case{ 65536, 1 }, Case{ 5000, 20 } })
+    {
+        const int points = c.points;
+        SignalProcessor::Config cfg;
+        cfg.pointCount = points;
+        cfg.channels = c.channels;
+        cfg.harmonics = { { 10, 10, 0 }, { 2, 33, 1 } };
+        cfg.comparePrecision = true;
+
+        SignalProcessor processor;
+        processor.Update(cfg);
+
+        // Warm-up: one pass through every edit and every filter kind.
+        for (int step = 0; step < kEdits * int(kFilterKindCount); ++step)
+        {
+            edit(cfg, step);
+            processor.Update(cfg);
+        }
+
+        size_t before = g_Allocations.load();
+        for (int step = 0; step < kEdits * int(kFilterKindCount); ++step)
+        {
+            edit(cfg, step);
+            processor.Update(cfg);
+        }
+        size_t allocations = g_Allocations.load() - before;
+        if (allocations != 0) std::printf("  n=%d x %d: %zu allocations\n", points, c.channels, allocations);
+        CHECK(allocations == 0);
+    }
+}
+
+void test_streaming()
+{
+    StreamingFilter::Config cfg;
+    cfg.frameSize = 1000;
+    cfg.hopSize = 250;
+    cfg.filter = FilterKind::Wiener;
+    StreamingFilter filter(cfg);
+
+    std::vector<double> input(4096, 0.0), output(4096);
+    for (size_t i = 0; i < input.size(); ++i) input[i] = double(i % 17) - 8;
+
+    auto pump = [&]
+    {
+        size_t pushed = 0;
+        while (pushed < input.size())
+        {
+            pushed += filter.Push(input.data() + pushed, input.size() - pushed);
+            while (filter.Pull(output.data(), output.size()) > 0) {}
+        }
+    };
+
+    pump();
+    size_t before = g_Allocations.load();
+    pump();
+    pump();
+    CHECK(g_Allocations.load() == before);
+}
+}
+
+int main()
+{
+    test_update();
+    test_streaming();
+    return check_result();
+}
@@ -0,0 +1,402 @@
+// FFT correctness: every plan type against a naive DFT, inverse round
+// trips, the real-input transform, float plans against the double ones,
+// bit-identical SIMD levels in both precisions, batches against single
+// transforms and four-step plans at the sizes where they take over or
+// from a tuned threshold.
+
+#include "Check.h"
+#include "math/fft.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+// Sizes covering radix 2/4, mixed radix 3/5/7 and Bluestein primes.
+const size_t kSizes[] = { 1, 2, 3, 4, 5, 7, 8, 12, 16, 30, 49, 64, 97, 100, 128,
+                          210, 243, 256, 343, 1000, 1024, 1031, 2310, 4096 };
+
+std::vector<Complex> random_signal(size_t n, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<Complex> x(n);
+    for (auto& v : x) v = { dist(rng), dist(rng) };
+    return x;
+}
+
+std::vector<Complex> naive_dft(const std::vector<Complex>& x)
+{
+    size_t n = x.size();
+    std::vector<Complex> y(n);
+    for (size_t k = 0; k < n; ++k)
+    {
+        Complex sum = 0;
+        for (size_t j = 0; j < n; ++j)
+        {
+            // k * j mod n keeps the angle small and the reference accurate.
+            double angle = -2 * PI * double((k * j) % n) / n;
+            sum += x[j] * Complex(std::cos(angle), std::sin(angle));
+        }
+        y[k] = sum;
+    }
+    return y;
+}
+
+// ||a - b|| / ||b||
+double relative_error(const std::vector<Complex>& a, const std::vector<Complex>& b)
+{
+    double diff = 0, norm = 0;
+    for (size_t i = 0; i < b.size(); ++i)
+    {
+        diff += std::norm(a[i] - b[i]);
+        norm += std::norm(b[i]);
+    }
+    return norm > 0 ? std::sqrt(diff / norm) : std::sqrt(diff);
+}
+
+void test_against_dft()
+{
+    for (size_t n : kSizes)
+    {
+        auto x = random_signal(n, unsigned(n));
+        auto expected = naive_dft(x);
+
+        auto y = fft(x);
+        CHECK(y.size() == n);
+        double error = relative_error(y, expected);
+        if (error > 1e-12) std::printf("  fft n=%zu\n", n);
+        CHECK(error <= 1e-12);
+
+        auto back = ifft(y);
+        error = relative_error(back, x);
+        if (error > 1e-12) std::printf("  ifft n=%zu\n", n);
+        CHECK(error <= 1e-12);
+    }
+}
+
+void test_real_transform()
+{
+    for (size_t n : kSizes)
+    {
+        auto z = random_signal(n, unsigned(n) + 1);
+        std::vector<double> x(n);
+        std::vector<Complex> complexX(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            x[i] = z[i].real();
+            complexX[i] = x[i];
+        }
+
+        auto expected = naive_dft(complexX);
+        expected.resize(n / 2 + 1);
+
+        auto bins = rfft(x);
+        CHECK(bins.size() == n / 2 + 1);
+        double error = relative_error(bins, expected);
+        if (error > 1e-12) std::printf("  rfft n=%zu\n", n);
+        CHECK(error <= 1e-12);
+
+        auto back = irfft(bins, n);
+        double maxError = 0;
+        for (size_t i = 0; i < n; ++i) maxError = std::max(maxError, std::abs(back[i] - x[i]));
+        if (maxError > 1e-12) std::printf("  irfft n=%zu\n", n);
+        CHECK(maxError <= 1e-12);
+    }
+}
+
+std::vector<ComplexF> to_float(const std::vector<Complex>& x)
+{
+    std::vector<ComplexF> y(x.size());
+    for (size_t i = 0; i < x.size(); ++i) y[i] = ComplexF(float(x[i].real()), float(x[i].imag()));
+    return y;
+}
+
+std::vector<Complex> to_double(const std::vector<ComplexF>& x)
+{
+    return std::vector<Complex>(x.begin(), x.end());
+}
+
+void test_float_transform()
+{
+    for (size_t n : kSizes)
+    {
+        auto x = random_signal(n, unsigned(n) + 3);
+        auto expected = fft(x);
+
+        auto y = to_float(x);
+        get_fft_plan<float>(n).Forward(y.data());
+        double error = relative_error(to_double(y), expected);
+        if (error > 1e-5) std::printf("  float fft n=%zu: %g\n", n, error);
+        CHECK(error <= 1e-5);
+
+        std::vector<float> real(n);
+        for (size_t i = 0; i < n; ++i) real[i] = float(x[i].real());
+        std::vector<double> realD(real.begin(), real.end());
+        const auto& plan = get_real_fft_plan<float>(n);
+        std::vector<ComplexF> bins(plan.Bins());
+        plan.Forward(real.data(), bins.data());
+        error = relative_error(to_double(bins), rfft(realD));
+        if (error > 1e-5) std::printf("  float rfft n=%zu: %g\n", n, error);
+        CHECK(error <= 1e-5);
+
+        std::vector<float> back(n);
+        plan.Inverse(bins.data(), back.data());
+        double maxError = 0;
+        for (size_t i = 0; i < n; ++i) maxError = std::max(maxError, double(std::abs(back[i] - real[i])));
+        CHECK(maxError <= 1e-5);
+    }
+}
+
+void test_simd_parity()
+{
+    SimdLevel max = fft_max_simd_level();
+    std::printf("max SIMD level: %s\n", to_string(max));
+
+    for (size_t n : kSizes)
+    {
+        auto x = random_signal(n, unsigned(n) + 2);
+
+        fft_set_simd_level(SimdLevel::Scalar);
+        auto reference = fft(x);
+
+        for (int level = int(SimdLevel::Sse2); level <= int(max); ++level)
+        {
+            fft_set_simd_level(SimdLevel(level));
+            auto y = fft(x);
+            bool same = y == reference;
+            if (!same) std::printf("  %s differs at n=%zu\n", to_string(SimdLevel(level)), n);
+            CHECK(same);
+        }
+
+        auto xf = to_float(x);
+        fft_set_simd_level(SimdLevel::Scalar);
+        auto referenceF = xf;
+        get_fft_plan<float>(n).Forward(referenceF.data());
+
+        for (int level = int(SimdLevel::Sse2); level <= int(max); ++level)
+        {
+            fft_set_simd_level(SimdLevel(level));
+            auto y = xf;
+            get_fft_plan<float>(n).Forward(y.data());
+            bool same = y == referenceF;
+            if (!same) std::printf("  %s float differs at n=%zu\n", to_string(SimdLevel(level)), n);
+            CHECK(same);
+        }
+    }
+    fft_set_simd_level(max);
+}
+
+// Channel c of a batch holds random_signal(n, c); point i is stored at
+// batch_index(layout, ...) like in the plan.
+template <class T>
+void fill_batch(size_t n, size_t channels, BatchLayout layout, std::vector<T>& re, std::vector<T>& im)
+{
+    re.resize(n * channels);
+    im.resize(n * channels);
+    for (size_t c = 0; c < channels; ++c)
+    {
+        auto x = random_signal(n, unsigned(c));
+        for (size_t i = 0; i < n; ++i)
+        {
+            size_t at = layout == BatchLayout::Interleaved ? i * channels + c : c * n + i;
+            re[at] = T(x[i].real());
+            im[at] = T(x[i].imag());
+        }
+    }
+}
+
+template <class T>
+bool batch_matches_single(size_t n, size_t channels, BatchLayout layout)
+{
+    const auto& plan = get_fft_plan<T>(n);
+    const auto& real = get_real_fft_plan<T>(n);
+    std::vector<T> re, im;
+    fill_batch(n, channels, layout, re, im);
+    const std::vector<T> input = re;
+
+    auto at = [&](size_t i, size_t c, size_t length)
+    {
+        return layout == BatchLayout::Interleaved ? i * channels + c : c * length + i;
+    };
+
+    std::vector<T> forwardRe = re, forwardIm = im;
+    plan.ForwardBatch(forwardRe.data(), forwardIm.data(), channels, layout);
+    std::vector<T> inverseRe = re, inverseIm = im;
+    plan.InverseBatch(inverseRe.data(), inverseIm.data(), channels, layout);
+
+    size_t bins = real.Bins();
+    std::vector<std::complex<T>> spectra(bins * channels);
+    real.ForwardBatch(input.data(), spectra.data(), channels, layout);
+    std::vector<T> restored(n * channels);
+    real.InverseBatch(spectra.data(), restored.data(), channels, layout);
+
+    bool same = true;
+    std::vector<T> sr(n), si(n), fr(n), fi(n), ir(n), ii(n), samples(n), back(n);
+    std::vector<std::complex<T>> half(bins);
+    for (size_t c = 0; c < channels; ++c)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            sr[i] = re[at(i, c, n)];
+            si[i] = im[at(i, c, n)];
+        }
+        fr = sr, fi = si, ir = sr, ii = si;
+        plan.Forward(fr.data(), fi.data());
+        plan.Inverse(ir.data(), ii.data());
+        real.Forward(sr.data(), half.data());
+        real.Inverse(half.data(), back.data());
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            same = same && forwardRe[at(i, c, n)] == fr[i] && forwardIm[at(i, c, n)] == fi[i];
+            same = same && inverseRe[at(i, c, n)] == ir[i] && inverseIm[at(i, c, n)] == ii[i];
+            same = same && restored[at(i, c, n)] == back[i];
+        }
+        for (size_t k = 0; k < bins; ++k)
+        {
+            same = same && spectra[at(k, c, bins)] == half[k];
+        }
+    }
+    return same;
+}
+
+void test_batch_transform()
+{
+    const size_t sizes[] = { 1, 2, 7, 12, 64, 97, 210, 1000, 1031, 1024 };
+    const size_t channelCounts[] = { 1, 3, 17, 64 };
+
+    for (size_t n : sizes)
+    {
+        for (size_t channels : channelCounts)
+        {
+            for (BatchLayout layout : { BatchLayout::Interleaved, BatchLayout::Split })
+            {
+                bool same = batch_matches_single<double>(n, channels, layout);
+                if (!same) std::printf("  batch differs at n=%zu channels=%zu\n", n, channels);
+                CHECK(same);
+            }
+        }
+    }
+
+    // Float spot checks, including a Bluestein size.
+    for (size_t n : { 30, 97, 1024 })
+    {
+        for (BatchLayout layout : { BatchLayout::Interleaved, BatchLayout::Split })
+        {
+            CHECK(batch_matches_single<float>(n, 17, layout));
+        }
+    }
+}
+
+// A few tones on whole bins, so every bin of the spectrum is known:
+// n * amplitude on the tones and zero elsewhere.
+struct Tone
+{
+    size_t bin;
+    Complex amplitude;
+};
+
+template <class T>
+void check_four_step(size_t n, double tolerance)
+{
+    const auto& plan = get_fft_plan<T>(n);
+    CHECK(plan.IsFourStep());
+
+    const Tone tones[] = { { 0, { 0.5, 0 } }, { 1, { 0.25, -1 } }, { n / 3 + 17, { -0.75, 0.5 } },
+                           { n - 1, { 1, 1 } } };
+    std::vector<Complex> roots(n);
+    for (size_t m = 0; m < n; ++m) roots[m] = std::polar(1.0, 2 * PI * double(m) / n);
+    std::vector<T> re(n), im(n);
+    for (size_t j = 0; j < n; ++j)
+    {
+        Complex x = 0;
+        for (const auto& t : tones) x += t.amplitude * roots[(uint64_t(t.bin) * j) % n];
+        re[j] = T(x.real());
+        im[j] = T(x.imag());
+    }
+    const std::vector<T> inputRe = re, inputIm = im;
+
+    plan.Forward(re.data(), im.data());
+    std::vector<Complex> expected(n);
+    for (const auto& t : tones) expected[t.bin] = t.amplitude * double(n);
+    double error = 0;
+    for (size_t k = 0; k < n; ++k) error = std::max(error, std::abs(Complex(re[k], im[k]) - expected[k]));
+    error /= double(n);
+    if (error > tolerance) std::printf("  four-step n=%zu error %g\n", n, error);
+    CHECK(error <= tolerance);
+
+    plan.Inverse(re.data(), im.data());
+    error = 0;
+    for (size_t j = 0; j < n; ++j)
+    {
+        error = std::max(error, std::abs(Complex(re[j] - inputRe[j], im[j] - inputIm[j])));
+    }
+    if (error > tolerance) std::printf("  four-step n=%zu round trip %g\n", n, error);
+    CHECK(error <= tolerance);
+}
+
+void test_four_step()
+{
+    const size_t n = four_step_min_size();
+    CHECK(!get_fft_plan<double>(n / 2).IsFourStep());
+    check_four_step<double>(n, 1e-14);
+    check_four_step<double>(n / 2 * 3, 1e-14);
+    check_four_step<float>(n, 1e-5);
+    CHECK(!get_fft_plan<double>(n + 1).IsFourStep());
+
+    // The real plan runs its half transform as a four-step one.
+    const size_t m = 2 * n;
+    std::vector<double> samples(m), back(m);
+    for (size_t j = 0; j < m; ++j) samples[j] = 0.5 + std::cos(2 * PI * double((uint64_t(5) * j) % m) / m);
+    const auto& real = get_real_fft_plan<double>(m);
+    std::vector<Complex> half(real.Bins());
+    real.Forward(samples.data(), half.data());
+    CHECK_NEAR(half[0].real(), 0.5 * double(m), 1e-6);
+    CHECK_NEAR(half[5].real(), 0.5 * double(m), 1e-6);
+    CHECK_NEAR(std::abs(half[6]), 0, 1e-6);
+    real.Inverse(half.data(), back.data());
+    double error = 0;
+    for (size_t j = 0; j < m; ++j) error = std::max(error, std::abs(back[j] - samples[j]));
+    CHECK(error <= 1e-14);
+
+    // Batches of a four-step size match single transforms bit for bit.
+    const size_t channels = 2;
+    std::vector<double> re, im;
+    fill_batch(n, channels, BatchLayout::Split, re, im);
+    std::vector<double> batchRe = re, batchIm = im;
+    const auto& plan = get_fft_plan<double>(n);
+    plan.ForwardBatch(batchRe.data(), batchIm.data(), channels, BatchLayout::Split);
+    for (size_t c = 0; c < channels; ++c)
+    {
+        plan.Forward(re.data() + c * n, im.data() + c * n);
+    }
+    bool same = re == batchRe && im == batchIm;
+    plan.InverseBatch(batchRe.data(), batchIm.data(), channels, BatchLayout::Split);
+    for (size_t c = 0; c < channels; ++c)
+    {
+        plan.Inverse(re.data() + c * n, im.data() + c * n);
+    }
+    same = same && re == batchRe && im == batchIm;
+    CHECK(same);
+
+    // A lowered threshold applies to sizes planned afterwards.
+    const size_t defaultSize = four_step_min_size();
+    set_four_step_min_size(5 << 11);
+    CHECK(four_step_min_size() == 5 << 11);
+    check_four_step<double>(5 << 11, 1e-14);
+    set_four_step_min_size(0);
+    CHECK(four_step_min_size() == defaultSize);
+}
+}
+
+int main()
+{
+    test_against_dft();
+    test_real_transform();
+    test_float_transform();
+    test_simd_parity();
+    test_batch_transform();
+    test_four_step();
+    return check_result();
+}
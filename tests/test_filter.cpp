@@ -0,0 +1,289 @@
+// Filter round trips: with nothing to remove, every kernel and the
+// streaming path must give the input back; a DC offset must survive the
+// threshold kernels; the streaming filter must match block mode when its
+// single frame spans the whole signal; the parameter sweep must agree
+// with SignalProcessor's Delta and refuse the configs it does not model.
+
+#include "Check.h"
+#include "ParameterSweep.h"
+#include "SignalProcessor.h"
+#include "StreamingFilter.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+const FilterKind kKinds[] = { FilterKind::EnergyCutoff, FilterKind::HardThreshold,
+                              FilterKind::SoftThreshold, FilterKind::Wiener,
+                              FilterKind::SpectralSubtraction };
+
+double max_difference(const std::vector<double>& a, const std::vector<double>& b)
+{
+    double error = 0;
+    for (size_t i = 0; i < std::min(a.size(), b.size()); ++i)
+    {
+        error = std::max(error, std::abs(a[i] - b[i]));
+    }
+    return error;
+}
+
+// gamma = 1 keeps all energy and threshold = 0 estimates no noise, so
+// every kernel must reproduce the noisy input.
+void test_block_round_trip()
+{
+    for (int points : { 1024, 1000, 4097 })
+    {
+        for (FilterKind kind : kKinds)
+        {
+            SignalProcessor::Config cfg;
+            cfg.pointCount = points;
+            cfg.filter = kind;
+            cfg.gamma = 1.0f;
+            cfg.threshold = 0.0f;
+            cfg.harmonics = { { 10, 10, 0 }, { 3, 47, 1 } };
+
+            SignalProcessor processor;
+            CHECK(processor.Update(cfg));
+            CHECK(processor.GetCleanSignal().size() == size_t(points));
+
+            double error = max_difference(processor.GetCleanSignal(), processor.GetInputSignal());
+            if (error > 1e-9) std::printf("  %s n=%d error %g\n", to_string(kind), points, error);
+            CHECK(error <= 1e-9);
+        }
+    }
+}
+
+// Every kernel at its defaults must bring the result closer to the ideal
+// signal than the unfiltered input is.
+void test_filters_reduce_noise()
+{
+    SignalProcessor::Config cfg;
+    cfg.pointCount = 4096;
+    cfg.gamma = 1.0f;
+    cfg.threshold = 0.0f;
+
+    SignalProcessor processor;
+    processor.Update(cfg);
+    double unfiltered = processor.GetDelta();
+
+    cfg.gamma = 0.9f;
+    cfg.threshold = 3.0f;
+    for (FilterKind kind : kKinds)
+    {
+        cfg.filter = kind;
+        processor.Update(cfg);
+        if (processor.GetDelta() >= unfiltered)
+        {
+            std::printf("  %s delta %g, unfiltered %g\n", to_string(kind), processor.GetDelta(), unfiltered);
+        }
+        CHECK(processor.GetDelta() < unfiltered);
+    }
+}
+
+double mean(const std::vector<double>& x)
+{
+    double sum = 0;
+    for (double v : x) sum += v;
+    return x.empty() ? 0 : sum / double(x.size());
+}
+
+// A DC offset is no noise: the threshold kernels must keep it, judged by
+// its real level rather than the zero the amplitude spectrum shows. Soft
+// thresholding shrinks it by the cut like any kept bin, hence the margin.
+void test_dc_offset()
+{
+    SignalProcessor::Config cfg;
+    cfg.pointCount = 4096;
+    cfg.threshold = 3.0f;
+    cfg.harmonics = { { 5, 0, float(PI / 2) }, { 10, 10, 0 } };
+
+    SignalProcessor processor;
+    for (FilterKind kind : kKinds)
+    {
+        if (kind == FilterKind::EnergyCutoff) continue;
+        cfg.filter = kind;
+        processor.Update(cfg);
+        double input = mean(processor.GetInputSignal()), clean = mean(processor.GetCleanSignal());
+        if (std::abs(clean - input) > 0.1 * std::abs(input))
+        {
+            std::printf("  %s mean %g, input %g\n", to_string(kind), clean, input);
+        }
+        CHECK_NEAR(clean, input, 0.1 * std::abs(input));
+    }
+}
+
+std::vector<double> run_stream(StreamingFilter& filter, const std::vector<double>& input, size_t chunk)
+{
+    std::vector<double> output;
+    double buffer[256];
+    size_t pushed = 0;
+    while (pushed < input.size())
+    {
+        pushed += filter.Push(input.data() + pushed, std::min(chunk, input.size() - pushed));
+        while (size_t n = filter.Pull(buffer, std::size(buffer))) output.insert(output.end(), buffer, buffer + n);
+    }
+    filter.Finish();
+    while (size_t n = filter.Pull(buffer, std::size(buffer))) output.insert(output.end(), buffer, buffer + n);
+    CHECK(filter.IsDrained());
+    return output;
+}
+
+void test_streaming_matches_block()
+{
+    SignalProcessor::Config cfg;
+    cfg.pointCount = 4000;
+    cfg.gamma = 0.9f;
+
+    SignalProcessor processor;
+    processor.Update(cfg);
+    const auto& input = processor.GetInputSignal();
+
+    StreamingFilter::Config streamCfg;
+    streamCfg.frameSize = cfg.pointCount;
+    streamCfg.hopSize = cfg.pointCount;
+    streamCfg.window = StreamingFilter::Window::Rectangular;
+    streamCfg.gamma = cfg.gamma;
+
+    StreamingFilter filter(streamCfg);
+    auto output = run_stream(filter, input, 333);
+    CHECK(output.size() == input.size());
+    CHECK(max_difference(output, processor.GetCleanSignal()) <= 1e-9);
+}
+
+void test_streaming_round_trip()
+{
+    SignalProcessor processor;
+    SignalProcessor::Config cfg;
+    cfg.pointCount = 5000;
+    processor.Update(cfg);
+    const auto& input = processor.GetInputSignal();
+
+    using Window = StreamingFilter::Window;
+    for (auto [frame, hop, window] : { std::tuple{ 256, 128, Window::Hann }, { 512, 128, Window::Hann },
+                                       { 1000, 250, Window::Hann }, { 500, 500, Window::Rectangular } })
+    {
+        StreamingFilter::Config streamCfg;
+        streamCfg.frameSize = frame;
+        streamCfg.hopSize = hop;
+        streamCfg.window = window;
+        streamCfg.gamma = 1.0f;
+
+        StreamingFilter filter(streamCfg);
+        auto output = run_stream(filter, input, 777);
+        CHECK(output.size() == input.size());
+
+        double error = max_difference(output, input);
+        if (error > 1e-9) std::printf("  frame %d hop %d error %g\n", frame, hop, error);
+        CHECK(error <= 1e-9);
+    }
+
+    // Without overlap the Hann window is zero at the start of every frame,
+    // which no other frame covers.
+    StreamingFilter::Config uncovered;
+    uncovered.frameSize = uncovered.hopSize = 500;
+    bool threw = false;
+    try
+    {
+        StreamingFilter filter(uncovered);
+    }
+    catch (const std::invalid_argument&)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+// Every sweep point must equal Delta from a full SignalProcessor run,
+// averaged over the seeds.
+void test_sweep_matches_processor()
+{
+    for (FilterKind kind : { FilterKind::EnergyCutoff, FilterKind::Wiener })
+    {
+        SignalProcessor::Config cfg;
+        cfg.pointCount = 3000;
+        cfg.filter = kind;
+        cfg.harmonics = { { 10, 10, 0 }, { 3, 47, 1 } };
+
+        ParameterSweep::Grid grid;
+        grid.params = kind == FilterKind::EnergyCutoff ? ParameterSweep::Linspace(0.5f, 1.0f, 4)
+                                                       : ParameterSweep::Linspace(1.0f, 4.0f, 4);
+        grid.noiseAlphas = { 0.1f, 0.5f, 1.0f };
+        grid.seeds = { 1, 2, 3 };
+
+        ParameterSweep sweep;
+        CHECK(sweep.Run(cfg, grid));
+        CHECK(sweep.GetPoints().size() == grid.params.size() * grid.noiseAlphas.size());
+
+        SignalProcessor processor;
+        for (size_t a = 0; a < grid.noiseAlphas.size(); ++a)
+        {
+            for (size_t p = 0; p < grid.params.size(); ++p)
+            {
+                cfg.noiseAlpha = grid.noiseAlphas[a];
+                if (kind == FilterKind::EnergyCutoff) cfg.gamma = grid.params[p];
+                else cfg.threshold = grid.params[p];
+
+                double sum = 0;
+                for (uint64_t seed : grid.seeds)
+                {
+                    cfg.seed = seed;
+                    processor.Update(cfg);
+                    sum += processor.GetDelta();
+                }
+                const auto& point = sweep.At(a, p);
+                double expected = sum / grid.seeds.size();
+                if (std::abs(point.meanDelta - expected) > 1e-9 * expected)
+                {
+                    std::printf("  %s alpha %g param %g: sweep %.12g, processor %.12g\n", to_string(kind),
+                                point.noiseAlpha, point.param, point.meanDelta, expected);
+                }
+                CHECK_NEAR(point.meanDelta, expected, 1e-9 * expected);
+                CHECK(point.minDelta <= point.meanDelta && point.meanDelta <= point.maxDelta);
+            }
+        }
+    }
+
+    std::atomic<bool> cancel{ true };
+    ParameterSweep sweep;
+    CHECK(!sweep.Run(SignalProcessor::Config{}, { { 1.0f }, { 0.2f }, {} }, &cancel));
+    CHECK(sweep.GetPoints().empty());
+
+    auto rejects = [](const SignalProcessor::Config& cfg)
+    {
+        bool threw = false;
+        try
+        {
+            ParameterSweep().Run(cfg, { { 1.0f }, { 0.2f }, {} });
+        }
+        catch (const std::invalid_argument&)
+        {
+            threw = true;
+        }
+        return threw && ParameterSweep::Unsupported(cfg);
+    };
+    SignalProcessor::Config cfg;
+    CHECK(!ParameterSweep::Unsupported(cfg));
+    cfg.precision = Precision::Float;
+    CHECK(rejects(cfg));
+    cfg = {};
+    cfg.clean = CleanSource::Fir;
+    CHECK(rejects(cfg));
+    cfg = {};
+    cfg.channels = 2;
+    CHECK(rejects(cfg));
+}
+}
+
+int main()
+{
+    test_block_round_trip();
+    test_filters_reduce_noise();
+    test_dc_offset();
+    test_streaming_matches_block();
+    test_streaming_round_trip();
+    test_sweep_matches_processor();
+    return check_result();
+}
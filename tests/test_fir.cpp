@@ -0,0 +1,180 @@
+// FIR filters: the designed responses, direct-form and overlap-save
+// kernels against a naive convolution, streams cut into uneven calls,
+// the delay-compensated whole-signal path, float against double and
+// bit-identical SIMD levels of the direct form.
+
+#include "Check.h"
+#include "math/fir.h"
+#include "math/noise.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+std::vector<double> noise(size_t n, uint64_t seed)
+{
+    std::vector<double> x(n);
+    gaussian_noise(seed, 0, x.data(), n);
+    return x;
+}
+
+// Causal y[i] = sum h[k] x[i - k] with zeros before x[0].
+std::vector<double> naive_fir(const std::vector<double>& h, const std::vector<double>& x)
+{
+    std::vector<double> y(x.size());
+    for (size_t i = 0; i < x.size(); ++i)
+    {
+        for (size_t k = 0; k < h.size() && k <= i; ++k) y[i] += h[k] * x[i - k];
+    }
+    return y;
+}
+
+double gain(const std::vector<double>& h, double f)
+{
+    Complex sum = 0;
+    for (size_t k = 0; k < h.size(); ++k) sum += h[k] * std::polar(1.0, -2 * PI * f * double(k));
+    return std::abs(sum);
+}
+
+double max_difference(const std::vector<double>& a, const std::vector<double>& b)
+{
+    double error = 0;
+    for (size_t i = 0; i < std::min(a.size(), b.size()); ++i) error = std::max(error, std::abs(a[i] - b[i]));
+    return error;
+}
+
+void test_design()
+{
+    auto lowPass = design_fir(0, 0.1, 101);
+    CHECK_NEAR(gain(lowPass, 0), 1, 1e-12);
+    CHECK_NEAR(gain(lowPass, 0.05), 1, 1e-3);
+    CHECK(gain(lowPass, 0.2) < 1e-3);
+    CHECK(gain(lowPass, 0.45) < 1e-3);
+    CHECK(lowPass[0] == lowPass[100] && lowPass[30] == lowPass[70]);
+
+    auto bandPass = design_fir(0.1, 0.2, 151);
+    CHECK_NEAR(gain(bandPass, 0.15), 1, 1e-12);
+    CHECK(gain(bandPass, 0) < 1e-3);
+    CHECK(gain(bandPass, 0.35) < 1e-3);
+
+    bool threw = false;
+    try
+    {
+        design_fir(0.3, 0.2, 11);
+    }
+    catch (const std::invalid_argument&)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+// Both engines, a stream cut into calls of every size from one sample to
+// several blocks, and the whole-signal path.
+void test_against_naive()
+{
+    const auto x = noise(20000, 3);
+    const size_t direct = fir_direct_max_taps();
+    const size_t tapCounts[] = { 1, 5, 31, direct, direct + 1, 513 };
+    for (size_t taps : tapCounts)
+    {
+        auto h = design_fir(0, 0.2, taps);
+        const auto expected = naive_fir(h, x);
+
+        FirFilter filter(h);
+        CHECK(filter.IsDirect() == (taps <= direct));
+
+        std::vector<double> y(x.size());
+        filter.Process(x.data(), y.data(), x.size());
+        double error = max_difference(y, expected);
+        if (error > 1e-12) std::printf("  taps=%zu error %g\n", taps, error);
+        CHECK(error <= 1e-12);
+
+        filter.Reset();
+        std::vector<double> pieces(x.size());
+        const size_t sizes[] = { 1, 7, 300, 1, 4097, 2 * filter.BlockSize() + 5 };
+        for (size_t done = 0, i = 0; done < x.size(); ++i)
+        {
+            size_t count = std::min(sizes[i % 6], x.size() - done);
+            filter.Process(x.data() + done, pieces.data() + done, count);
+            done += count;
+        }
+        CHECK(max_difference(pieces, expected) <= 1e-12);
+        // Direct-form outputs never depend on how the stream was cut.
+        if (filter.IsDirect()) CHECK(pieces == y);
+
+        // In place works as well.
+        filter.Reset();
+        std::vector<double> inPlace = x;
+        filter.Process(inPlace.data(), inPlace.data(), inPlace.size());
+        CHECK(max_difference(inPlace, expected) <= 1e-12);
+
+        // Apply: advanced by the delay, zeros after the end.
+        std::vector<double> padded(x.size() + filter.Delay());
+        std::copy(x.begin(), x.end(), padded.begin());
+        const auto tail = naive_fir(h, padded);
+        std::vector<double> same(x.size());
+        filter.Apply(x.data(), same.data(), x.size());
+        error = 0;
+        for (size_t i = 0; i < x.size(); ++i) error = std::max(error, std::abs(same[i] - tail[i + filter.Delay()]));
+        CHECK(error <= 1e-12);
+    }
+}
+
+void test_float()
+{
+    const auto x = noise(10000, 4);
+    std::vector<float> xf(x.begin(), x.end());
+    for (size_t taps : { size_t(33), fir_direct_max_taps() + 2 })
+    {
+        auto h = design_fir(0.05, 0.25, taps);
+        FirFilter filter(h);
+        FirFilterF filterF(h);
+        std::vector<double> y(x.size());
+        std::vector<float> yf(x.size());
+        filter.Apply(x.data(), y.data(), x.size());
+        filterF.Apply(xf.data(), yf.data(), xf.size());
+        double error = 0;
+        for (size_t i = 0; i < y.size(); ++i) error = std::max(error, std::abs(double(yf[i]) - y[i]));
+        CHECK(error <= 1e-5);
+    }
+}
+
+void test_simd_parity()
+{
+    const SimdLevel max = fft_max_simd_level();
+    const auto x = noise(5003, 5);
+    std::vector<float> xf(x.begin(), x.end());
+    FirFilter filter(design_fir(0, 0.3, 37));
+    FirFilterF filterF(design_fir(0, 0.3, 37));
+
+    fft_set_simd_level(SimdLevel::Scalar);
+    std::vector<double> reference(x.size());
+    std::vector<float> referenceF(x.size());
+    filter.Apply(x.data(), reference.data(), x.size());
+    filterF.Apply(xf.data(), referenceF.data(), xf.size());
+
+    for (int level = int(SimdLevel::Sse2); level <= int(max); ++level)
+    {
+        fft_set_simd_level(SimdLevel(level));
+        std::vector<double> y(x.size());
+        std::vector<float> yf(x.size());
+        filter.Apply(x.data(), y.data(), x.size());
+        filterF.Apply(xf.data(), yf.data(), xf.size());
+        bool same = y == reference && yf == referenceF;
+        if (!same) std::printf("  %s differs\n", to_string(SimdLevel(level)));
+        CHECK(same);
+    }
+    fft_set_simd_level(max);
+}
+}
+
+int main()
+{
+    test_design();
+    test_against_naive();
+    test_float();
+    test_simd_parity();
+    return check_result();
+}
@@ -0,0 +1,198 @@
+// Signal files: writer/reader round trips for every format with writes
+// larger than the writer's buffer, WAV header fields and channel
+// selection, int16 scaling and clipping, and a pipeline fed from a
+// mapped file against one fed from a vector.
+
+#include "Check.h"
+#include "SignalProcessor.h"
+#include "io/SignalFile.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+std::string temp_path(const std::string& name)
+{
+    return (std::filesystem::temp_directory_path() / ("signalfilter_test_" + name)).string();
+}
+
+// Frames of `channels` samples where channel c of frame i is distinct
+// and stays inside [-1, 1).
+std::vector<double> make_frames(size_t frames, int channels)
+{
+    std::vector<double> samples(frames * size_t(channels));
+    for (size_t i = 0; i < frames; ++i)
+    {
+        for (int c = 0; c < channels; ++c)
+        {
+            samples[i * channels + c] = 0.9 * std::sin(0.001 * double(i) * (c + 1) + c);
+        }
+    }
+    return samples;
+}
+
+void write_file(const std::string& path, const SignalFileFormat& format, const std::vector<double>& samples)
+{
+    // Uneven pieces cross the writer's buffer boundary at odd offsets.
+    SignalFileWriter writer(path, format);
+    const size_t frames = samples.size() / size_t(format.channels);
+    for (size_t begin = 0; begin < frames;)
+    {
+        size_t count = std::min<size_t>(frames - begin, 77777);
+        writer.Write(samples.data() + begin * format.channels, count);
+        begin += count;
+    }
+    CHECK(writer.FramesWritten() == frames);
+    writer.Close();
+}
+
+void test_round_trip()
+{
+    // 2 * 300000 float64 samples are several times the writer's buffer.
+    const size_t frames = 300000;
+    const int channels = 2;
+    const auto samples = make_frames(frames, channels);
+
+    for (const char* name : { "wav", "wav16", "wav64", "f32", "f64", "s16" })
+    {
+        SignalFileFormat format;
+        CHECK(parse_signal_format(name, format));
+        format.channels = channels;
+        format.sampleRate = 48000;
+        const std::string path = temp_path(std::string("round_trip.") + name);
+        write_file(path, format, samples);
+
+        // One LSB for int16, float rounding for float32.
+        const double tolerance = format.encoding == SampleEncoding::Int16   ? 1.0 / 32768
+                                 : format.encoding == SampleEncoding::Float32 ? 1e-7
+                                                                             : 0.0;
+        for (int c = 0; c < channels; ++c)
+        {
+            MappedSignalFile file(path, format, c);
+            CHECK(file.Size() == frames);
+            CHECK(file.GetFormat().wav == format.wav);
+            CHECK(file.GetFormat().encoding == format.encoding);
+
+            std::vector<double> read(frames);
+            CHECK(file.Read(0, read.data(), frames) == frames);
+            double error = 0;
+            for (size_t i = 0; i < frames; ++i)
+            {
+                error = std::max(error, std::abs(read[i] - samples[i * channels + c]));
+            }
+            CHECK(error <= tolerance);
+
+            // Reads past the end are cut short.
+            std::vector<float> tail(10);
+            CHECK(file.Read(frames - 4, tail.data(), tail.size()) == 4);
+            CHECK_NEAR(tail[3], samples[(frames - 1) * channels + c], 1.0 / 32768);
+            CHECK(file.Read(frames, tail.data(), tail.size()) == 0);
+            file.ReleaseBefore(frames / 2);
+            CHECK(file.Read(0, read.data(), 1) == 1);
+        }
+        std::filesystem::remove(path);
+    }
+}
+
+void test_wav_header()
+{
+    SignalFileFormat format;
+    parse_signal_format("wav16", format);
+    format.channels = 3;
+    format.sampleRate = 22050;
+    const std::string path = temp_path("header.wav");
+    write_file(path, format, make_frames(1000, 3));
+
+    // A raw format of the wrong width must be ignored for WAV input.
+    SignalFileFormat raw;
+    raw.channels = 1;
+    MappedSignalFile file(path, raw, 2);
+    CHECK(file.GetFormat().wav);
+    CHECK(file.GetFormat().encoding == SampleEncoding::Int16);
+    CHECK(file.GetFormat().channels == 3);
+    CHECK(file.GetFormat().sampleRate == 22050);
+    CHECK(file.Size() == 1000);
+    CHECK(std::filesystem::file_size(path) == 44 + 1000 * 3 * 2);
+
+    bool threw = false;
+    try
+    {
+        MappedSignalFile missing(path, raw, 3);
+    }
+    catch (const std::runtime_error&)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+    std::filesystem::remove(path);
+}
+
+void test_int16_scaling()
+{
+    SignalFileFormat format;
+    parse_signal_format("s16", format);
+    const std::string path = temp_path("scaling.s16");
+    write_file(path, format, { -1.0, 0.5, 1.0, 2.0, -3.0 });
+
+    // Full scale is 32768, so +1 clips to the largest code.
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    int16_t codes[5] = {};
+    CHECK(f && std::fread(codes, sizeof(int16_t), 5, f) == 5);
+    if (f) std::fclose(f);
+    CHECK(codes[0] == -32768 && codes[1] == 16384 && codes[2] == 32767 && codes[3] == 32767 && codes[4] == -32768);
+
+    MappedSignalFile file(path, format);
+    double read[5];
+    CHECK(file.Read(0, read, 5) == 5);
+    CHECK(read[0] == -1.0 && read[1] == 0.5 && read[2] == 32767.0 / 32768);
+    std::filesystem::remove(path);
+}
+
+// A mapped source must drive the pipeline exactly like the same samples
+// held in memory.
+void test_mapped_pipeline()
+{
+    const size_t points = 5000;
+    std::vector<double> samples(points);
+    for (size_t i = 0; i < points; ++i) samples[i] = std::sin(0.05 * double(i)) + 0.3 * std::sin(0.4 * double(i));
+
+    SignalFileFormat format;
+    parse_signal_format("f64", format);
+    const std::string path = temp_path("pipeline.f64");
+    write_file(path, format, samples);
+
+    SignalProcessor::Config cfg;
+    cfg.pointCount = int(points) + 100;
+    cfg.filter = FilterKind::Wiener;
+
+    SignalProcessor fromVector, fromFile;
+    fromVector.SetExternalSignal(samples);
+    fromFile.SetExternalSignal(std::make_shared<MappedSignalFile>(path, format));
+    CHECK(fromFile.HasExternalSignal());
+    fromVector.Update(cfg);
+    fromFile.Update(cfg);
+
+    CHECK(fromFile.GetIdealSignal() == fromVector.GetIdealSignal());
+    CHECK(fromFile.GetCleanSignal() == fromVector.GetCleanSignal());
+    CHECK(fromFile.GetDelta() == fromVector.GetDelta());
+
+    fromFile.SetExternalSignal(nullptr);
+    CHECK(!fromFile.HasExternalSignal());
+    std::filesystem::remove(path);
+}
+}
+
+int main()
+{
+    test_round_trip();
+    test_wav_header();
+    test_int16_scaling();
+    test_mapped_pipeline();
+    return check_result();
+}
@@ -0,0 +1,277 @@
+// Live ingestion: ring wrap-around, in-place blocks and the overrun and
+// underrun counters, element order across two threads, synthetic samples
+// independent of read boundaries, a live monitor fed by the producer
+// thread against the same samples filtered, tracked and analysed offline,
+// and underruns counted per stall rather than per empty poll.
+
+#include "Check.h"
+#include "LiveMonitor.h"
+#include "io/SampleFeed.h"
+#include "io/SyntheticSignal.h"
+#include "util/SpscRing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace
+{
+void test_ring_blocks()
+{
+    SpscRing<int> ring(6);
+    CHECK(ring.Capacity() == 8);
+
+    int values[12];
+    for (int i = 0; i < 12; ++i) values[i] = i;
+
+    CHECK(ring.Write(values, 6) == 6);
+    int out[4];
+    CHECK(ring.Read(out, 4) == 4);
+    CHECK(out[0] == 0 && out[3] == 3);
+
+    // 6 more wrap around the end: 4 through 9 sit at slots 4..7, 0..1.
+    CHECK(ring.Write(values + 6, 6) == 6);
+    CHECK(ring.Size() == 8);
+    auto block = ring.Peek();
+    CHECK(block.size == 4 && block.data[0] == 4 && block.data[3] == 7);
+    ring.Consume(block.size);
+    block = ring.Peek();
+    CHECK(block.size == 4 && block.data[0] == 8 && block.data[3] == 11);
+    ring.Consume(block.size);
+    CHECK(ring.Overruns() == 0 && ring.Underruns() == 0);
+
+    // A full ring drops the excess; a short read counts an underrun, an
+    // empty Peek does not.
+    CHECK(ring.Write(values, 12) == 8);
+    CHECK(ring.Overruns() == 4);
+    CHECK(ring.TryWrite(values, 1) == 0);
+    CHECK(ring.Overruns() == 4);
+    int all[12];
+    CHECK(ring.Read(all, 12) == 8);
+    CHECK(all[7] == 7);
+    CHECK(ring.Underruns() == 1);
+    CHECK(ring.Peek().size == 0);
+    CHECK(ring.Underruns() == 1);
+    CHECK(ring.Read(all, 1) == 0);
+    CHECK(ring.Underruns() == 2);
+}
+
+// Sequence numbers written in uneven blocks must arrive complete and in
+// order on the other thread.
+void test_ring_threads()
+{
+    const uint32_t total = 1 << 20;
+    SpscRing<uint32_t> ring(1000);
+
+    std::thread producer([&]
+    {
+        std::vector<uint32_t> block(97);
+        uint32_t next = 0;
+        while (next < total)
+        {
+            size_t count = std::min<size_t>(block.size(), total - next);
+            for (size_t i = 0; i < count; ++i) block[i] = next + uint32_t(i);
+            for (size_t done = 0; done < count;)
+            {
+                done += ring.TryWrite(block.data() + done, count - done);
+                if (done < count) std::this_thread::yield();
+            }
+            next += uint32_t(count);
+        }
+    });
+
+    uint32_t expected = 0;
+    bool ordered = true;
+    while (expected < total)
+    {
+        auto block = ring.Peek();
+        if (block.size == 0)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t i = 0; i < block.size; ++i) ordered &= block.data[i] == expected + i;
+        expected += uint32_t(block.size);
+        ring.Consume(block.size);
+    }
+    producer.join();
+
+    CHECK(ordered);
+    CHECK(expected == total);
+    CHECK(ring.Overruns() == 0);
+}
+
+void test_synthetic_reads()
+{
+    SyntheticSignal signal(1000, { { 1.0f, 50.0f, 0.5f }, { 0.3f, 170.0f, 0.0f } }, 0.5f, 3);
+    std::vector<double> whole(3000), pieces(3000);
+    CHECK(signal.Read(100, whole.data(), whole.size()) == whole.size());
+    for (size_t done = 0; done < pieces.size(); done += 37)
+    {
+        signal.Read(100 + done, pieces.data() + done, std::min<size_t>(37, pieces.size() - done));
+    }
+    CHECK(whole == pieces);
+
+    std::vector<float> floats(3000);
+    signal.Read(100, floats.data(), floats.size());
+    CHECK(floats[2999] == float(whole[2999]));
+}
+
+// An unpaced feed never drops, so the monitor sees exactly the feed's
+// samples and its output must equal an offline run of the same filter.
+void test_monitor()
+{
+    LiveMonitor::Config cfg;
+    cfg.ringCapacity = 4096;
+    cfg.sampleRate = 8000;
+    cfg.filter.frameSize = 512;
+    cfg.filter.hopSize = 128;
+    cfg.filter.filter = FilterKind::Wiener;
+    cfg.history = 2048;
+    cfg.tones = { 440, 1200 };
+    cfg.toneWindow = 4000;
+    cfg.publishSeconds = 0;
+
+    SampleFeed::Config feedCfg;
+    feedCfg.sampleRate = cfg.sampleRate;
+    feedCfg.blockSize = 300;
+    feedCfg.paced = false;
+    auto source = std::make_shared<SyntheticSignal>(cfg.sampleRate, std::vector<SinParam>{ { 1.0f, 440.0f, 0.0f },
+                                                    { 0.5f, 1200.0f, 1.0f } }, 0.2f, 1);
+
+    LiveMonitor monitor(cfg);
+    std::shared_ptr<const LiveSnapshot> snapshot;
+    {
+        SampleFeed feed(feedCfg, source, monitor.Input());
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+        do
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            snapshot = monitor.Latest();
+        } while (snapshot->filtered < 50000 && std::chrono::steady_clock::now() < deadline);
+
+        CHECK(feed.Produced() >= snapshot->consumed);
+    }
+
+    CHECK(snapshot->overruns == 0);
+    CHECK(snapshot->ringCapacity == 4096);
+    CHECK(snapshot->filtered >= 50000);
+    CHECK(snapshot->clean.size() == cfg.history);
+    CHECK(snapshot->input.size() == cfg.history);
+
+    // The same samples, filtered in one pass. Pushing more than was
+    // consumed only fills the filter further ahead.
+    const size_t end = size_t(snapshot->filtered);
+    std::vector<double> samples(size_t(snapshot->consumed) + cfg.filter.frameSize);
+    source->Read(0, samples.data(), samples.size());
+
+    StreamingFilter filter(cfg.filter);
+    std::vector<double> clean(end);
+    size_t pushed = 0, pulled = 0;
+    while (pulled < end)
+    {
+        pushed += filter.Push(samples.data() + pushed, samples.size() - pushed);
+        pulled += filter.Pull(clean.data() + pulled, end - pulled);
+    }
+
+    const size_t first = end - cfg.history;
+    double inputError = 0, cleanError = 0;
+    for (size_t i = 0; i < cfg.history; ++i)
+    {
+        inputError = std::max(inputError, std::abs(snapshot->input[i] - samples[first + i]));
+        cleanError = std::max(cleanError, std::abs(snapshot->clean[i] - clean[first + i]));
+    }
+    CHECK(inputError == 0);
+    CHECK(cleanError == 0);
+    CHECK_NEAR(snapshot->time[0], double(first) / cfg.sampleRate, 1e-12);
+
+    // The tracker saw exactly the consumed samples.
+    ToneTracker tracker({ cfg.sampleRate, cfg.tones, cfg.toneWindow, ToneTracker::Window::Hann });
+    tracker.Process(samples.data(), size_t(snapshot->consumed));
+    std::vector<ToneEstimate> tones(tracker.Tones());
+    tracker.Estimates(tones.data());
+    CHECK(snapshot->tonesSettled);
+    CHECK(snapshot->tones.size() == 2);
+    bool same = true;
+    for (size_t t = 0; t < tones.size(); ++t)
+    {
+        same &= snapshot->tones[t].amplitude == tones[t].amplitude && snapshot->tones[t].phase == tones[t].phase;
+    }
+    CHECK(same);
+    CHECK_NEAR(snapshot->tones[0].amplitude, 1.0, 0.05);
+    CHECK_NEAR(snapshot->tones[1].amplitude, 0.5, 0.05);
+    CHECK_NEAR(snapshot->tones[1].phase, 1.0, 0.1);
+
+    // Spectrogram rows come out once each: the retained ones first, then
+    // only frames finished since. Each row equals an offline analysis of
+    // the same samples.
+    const size_t bins = monitor.SpectrogramBins();
+    const size_t rows = cfg.spectrogram.rows;
+    std::vector<float> copied(rows * bins), later(rows * bins);
+    auto part = monitor.CopySpectrogram(false, 0, copied.data(), rows);
+    CHECK(part.count > 0 && part.count <= rows);
+    const uint64_t frames = part.first + part.count;
+    auto next = monitor.CopySpectrogram(false, frames, later.data(), rows);
+    CHECK(next.first == frames);
+    CHECK(monitor.CopySpectrogram(true, 0, later.data(), rows).count > 0);
+
+    Spectrogram spectrogram(cfg.spectrogram);
+    std::vector<double> analysed(size_t(frames - 1) * cfg.spectrogram.hopSize + cfg.spectrogram.frameSize);
+    source->Read(0, analysed.data(), analysed.size());
+    spectrogram.Push(analysed.data(), analysed.size());
+    CHECK(spectrogram.Frames() == frames);
+    bool sameRows = true;
+    for (size_t r = 0; r < part.count; ++r)
+    {
+        sameRows &= std::equal(copied.begin() + r * bins, copied.begin() + (r + 1) * bins,
+                               spectrogram.Row(part.first + r));
+    }
+    CHECK(sameRows);
+}
+
+// A paced feed that keeps up never underruns, however often the monitor
+// finds the ring empty between blocks; a producer that stalls counts one
+// underrun per stall.
+void test_monitor_underruns()
+{
+    LiveMonitor::Config cfg;
+    cfg.sampleRate = 8000;
+    cfg.filter.frameSize = 256;
+    cfg.filter.hopSize = 128;
+    cfg.publishSeconds = 0;
+    cfg.lateSeconds = 0.15;
+
+    SampleFeed::Config feedCfg;
+    feedCfg.sampleRate = cfg.sampleRate;
+    feedCfg.blockSize = 80;
+    auto source = std::make_shared<SyntheticSignal>(cfg.sampleRate, std::vector<SinParam>{ { 1.0f, 440.0f, 0.0f } },
+                                                    0.2f, 1);
+    {
+        LiveMonitor monitor(cfg);
+        SampleFeed feed(feedCfg, source, monitor.Input());
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        CHECK(monitor.Consumed() > 0);
+        CHECK(monitor.Input().Underruns() == 0);
+    }
+
+    LiveMonitor monitor(cfg);
+    std::vector<double> block(800);
+    for (int stall = 1; stall <= 2; ++stall)
+    {
+        monitor.Input().Write(block.data(), block.size());
+        std::this_thread::sleep_for(std::chrono::milliseconds(400));
+        CHECK(monitor.Input().Underruns() == uint64_t(stall));
+    }
+}
+}
+
+int main()
+{
+    test_ring_blocks();
+    test_ring_threads();
+    test_synthetic_reads();
+    test_monitor();
+    test_monitor_underruns();
+    return check_result();
+}
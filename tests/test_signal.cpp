@@ -0,0 +1,377 @@
+// Signal sources and pipeline bookkeeping: Philox known answers, chunk
+// independence and the distribution of the noise out to its tail, the
+// phasor oscillator against sin(), incremental updates against a fresh
+// run, float against double pipelines, channel 0 of a multi-channel run
+// against a single-channel one, the FIR filter as the clean source, and
+// peak-preserving plot decimation.
+
+#include "Check.h"
+#include "SignalProcessor.h"
+#include "math/fir.h"
+#include "math/noise.h"
+#include "math/oscillator.h"
+#include "util/MinMaxPyramid.h"
+#include "util/ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+void test_philox_known_answers()
+{
+    // Random123 known-answer vectors for Philox4x32-10.
+    uint32_t zero[4] = { 0, 0, 0, 0 };
+    philox4x32(zero, 0);
+    CHECK(zero[0] == 0x6627e8d5 && zero[1] == 0xe169c58d && zero[2] == 0xbc57ac4c && zero[3] == 0x9b00dbd8);
+
+    uint32_t ones[4] = { ~0u, ~0u, ~0u, ~0u };
+    philox4x32(ones, ~0ull);
+    CHECK(ones[0] == 0x408f276d && ones[1] == 0x41c83b0e && ones[2] == 0xa20bc7c6 && ones[3] == 0x6d5451fd);
+}
+
+void test_noise_chunks()
+{
+    const size_t n = 100001;
+    std::vector<double> whole(n), chunked(n);
+    gaussian_noise(42, 0, whole.data(), n);
+
+    // Odd chunk sizes start and end inside the pairs that share a block.
+    parallel_for(0, n, 777, [&](size_t begin, size_t end)
+    {
+        gaussian_noise(42, begin, chunked.data() + begin, end - begin);
+    });
+    CHECK(whole == chunked);
+
+    double mean = 0, variance = 0;
+    for (double x : whole) mean += x;
+    mean /= n;
+    for (double x : whole) variance += (x - mean) * (x - mean);
+    variance /= n;
+    CHECK_NEAR(mean, 0.0, 0.02);
+    CHECK_NEAR(variance, 1.0, 0.02);
+
+    // Tail fractions against the normal distribution, within four
+    // standard deviations of the count. Beyond 3.44 the ziggurat switches
+    // to its tail sampler.
+    for (double t : { 0.5, 1.0, 2.0, 3.0, 3.44 })
+    {
+        double expected = std::erfc(t / std::sqrt(2.0));
+        double fraction = double(std::count_if(whole.begin(), whole.end(),
+                                               [t](double x) { return std::abs(x) > t; })) / n;
+        double sigma = std::sqrt(expected * (1 - expected) / n);
+        if (std::abs(fraction - expected) > 4 * sigma)
+        {
+            std::printf("  P(|x| > %g) = %g, expected %g\n", t, fraction, expected);
+        }
+        CHECK_NEAR(fraction, expected, 4 * sigma);
+    }
+
+    // The float stream is the double one rounded.
+    std::vector<float> narrow(n);
+    gaussian_noise(42, 0, narrow.data(), n);
+    bool rounded = true;
+    for (size_t i = 0; i < n; ++i) rounded &= narrow[i] == float(whole[i]);
+    CHECK(rounded);
+
+    std::vector<double> other(n);
+    gaussian_noise(43, 0, other.data(), n);
+    CHECK(other != whole);
+}
+
+// The tail beyond t = 3 from 2^24 samples, enough to resolve a percent
+// of the mass there. Past 3.44 every sample comes from the tail sampler.
+void test_noise_tail()
+{
+    const size_t n = size_t(1) << 24, block = size_t(1) << 16;
+    const double thresholds[] = { 3.0, 3.3, 3.44, 3.6, 3.8 };
+    size_t counts[std::size(thresholds)] = {};
+    std::vector<double> x(block);
+    for (size_t first = 0; first < n; first += block)
+    {
+        gaussian_noise(7, first, x.data(), block);
+        for (double v : x)
+        {
+            for (size_t j = 0; j < std::size(thresholds); ++j) counts[j] += std::abs(v) > thresholds[j];
+        }
+    }
+
+    for (size_t j = 0; j < std::size(thresholds); ++j)
+    {
+        const double expected = n * std::erfc(thresholds[j] / std::sqrt(2.0));
+        const double sigma = std::sqrt(expected);
+        if (std::abs(double(counts[j]) - expected) > 4 * sigma)
+        {
+            std::printf("  %zu samples beyond %g, expected %g\n", counts[j], thresholds[j], expected);
+        }
+        CHECK_NEAR(double(counts[j]), expected, 4 * sigma);
+    }
+}
+
+void test_oscillator()
+{
+    const Sinusoid tones[] = { { 10, 0.01, 0.3 }, { 2, 2.5, -1 }, { 1, 1e-6, 0 }, { 0.5, PI, 0 } };
+    const size_t n = 3 * kOscillatorBlock + 5;
+
+    std::vector<double> out(n);
+    synthesize_sinusoids(tones, std::size(tones), out.data(), n);
+
+    double error = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        double expected = 0;
+        for (const auto& tone : tones) expected += tone.amplitude * std::sin(tone.omega * i + tone.phase);
+        error = std::max(error, std::abs(out[i] - expected));
+    }
+    CHECK(error < 1e-11);
+
+    // Every SIMD level runs the same operations, in both precisions, and
+    // blocks do not depend on the chunks they are synthesized in.
+    const size_t m = 40 * kOscillatorBlock + 77;
+    std::vector<double> wide(m), prefix(m);
+    std::vector<float> narrow(m), narrowMax(m);
+    synthesize_sinusoids(tones, std::size(tones), wide.data(), m);
+    synthesize_sinusoids(tones, std::size(tones), narrowMax.data(), m);
+    CHECK(std::equal(out.begin(), out.end(), wide.begin()));
+
+    SimdLevel max = fft_max_simd_level();
+    for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2 })
+    {
+        if (level > max) continue;
+        fft_set_simd_level(level);
+        synthesize_sinusoids(tones, std::size(tones), prefix.data(), m);
+        synthesize_sinusoids(tones, std::size(tones), narrow.data(), m);
+        CHECK(prefix == wide);
+        CHECK(narrow == narrowMax);
+    }
+    fft_set_simd_level(max);
+
+    double narrowError = 0;
+    for (size_t i = 0; i < m; ++i) narrowError = std::max(narrowError, std::abs(narrow[i] - wide[i]));
+    CHECK(narrowError < 1e-4);
+}
+
+// Incremental updates must land on the same result as a fresh run.
+void test_incremental_update()
+{
+    SignalProcessor::Config cfg;
+    cfg.pointCount = 3000;
+
+    SignalProcessor incremental;
+    incremental.Update(cfg);
+
+    cfg.gamma = 0.8f;
+    incremental.Update(cfg);
+    CHECK(incremental.GetLastRunStages() ==
+          (SignalProcessor::StageFilter | SignalProcessor::StageInverse | SignalProcessor::StageDelta));
+
+    cfg.noiseAlpha = 0.5f;
+    cfg.harmonics.push_back({ 4, 33, 0.5f });
+    incremental.Update(cfg);
+    CHECK((incremental.GetLastRunStages() & SignalProcessor::StageNoise) == 0);
+
+    cfg.showNoise = !cfg.showNoise;
+    incremental.Update(cfg);
+    CHECK(incremental.GetLastRunStages() == 0);
+
+    SignalProcessor fresh;
+    fresh.Update(cfg);
+    CHECK(fresh.GetCleanSignal() == incremental.GetCleanSignal());
+    CHECK(fresh.GetDelta() == incremental.GetDelta());
+}
+
+void test_precision()
+{
+    SignalProcessor::Config cfg;
+    cfg.pointCount = 5000;
+    cfg.filter = FilterKind::Wiener;
+
+    SignalProcessor processor;
+    processor.Update(cfg);
+    const double doubleDelta = processor.GetDelta();
+    const std::vector<double> doubleClean = processor.GetCleanSignal();
+    CHECK(std::isnan(processor.GetComparedDelta()));
+
+    cfg.precision = Precision::Float;
+    processor.Update(cfg);
+    CHECK(processor.GetLastRunStages() == SignalProcessor::StageAll);
+    CHECK(processor.GetCleanSignal().size() == doubleClean.size());
+    const double floatDelta = processor.GetDelta();
+    if (std::abs(floatDelta - doubleDelta) > 1e-4 * doubleDelta)
+    {
+        std::printf("  delta: double %.9g, float %.9g\n", doubleDelta, floatDelta);
+    }
+    CHECK_NEAR(floatDelta, doubleDelta, 1e-4 * doubleDelta);
+
+    double maxError = 0;
+    for (size_t i = 0; i < doubleClean.size(); ++i)
+    {
+        maxError = std::max(maxError, std::abs(processor.GetCleanSignal()[i] - doubleClean[i]));
+    }
+    CHECK(maxError <= 1e-3);
+
+    // The comparison reports the double Delta next to the float one.
+    cfg.comparePrecision = true;
+    processor.Update(cfg);
+    CHECK(processor.GetLastRunStages() == SignalProcessor::StageDelta);
+    CHECK(processor.GetComparedDelta() == doubleDelta);
+
+    // Switching back reuses the double results untouched.
+    cfg.precision = Precision::Double;
+    processor.Update(cfg);
+    CHECK(processor.GetCleanSignal() == doubleClean);
+    CHECK(processor.GetComparedDelta() == floatDelta);
+}
+
+void test_channels()
+{
+    SignalProcessor::Config cfg;
+    cfg.pointCount = 3000;
+    cfg.filter = FilterKind::Wiener;
+
+    SignalProcessor single;
+    single.Update(cfg);
+
+    // 20 channels: more than one batch group, with a remainder.
+    const size_t channels = 20;
+    const size_t n = size_t(cfg.pointCount), bins = n / 2 + 1;
+    cfg.channels = int(channels);
+    SignalProcessor multi;
+    multi.Update(cfg);
+    CHECK(multi.GetChannelCount() == channels);
+    CHECK(multi.GetCleanSignal().size() == channels * n);
+    CHECK(multi.GetCleanSpectrum().size() == channels * bins);
+    CHECK(multi.GetIdealSignal() == single.GetIdealSignal());
+
+    const auto& clean = multi.GetCleanSignal();
+    const auto& spectrum = multi.GetInputSpectrum();
+    CHECK(std::equal(single.GetCleanSignal().begin(), single.GetCleanSignal().end(), clean.begin()));
+    CHECK(std::equal(single.GetInputSpectrum().begin(), single.GetInputSpectrum().end(), spectrum.begin()));
+    CHECK(multi.GetChannelDelta(0) == single.GetDelta());
+
+    // The other channels see other noise, and Delta is their mean.
+    CHECK(!std::equal(clean.begin(), clean.begin() + n, clean.begin() + n));
+    double sum = 0;
+    for (size_t c = 0; c < channels; ++c) sum += multi.GetChannelDelta(c);
+    CHECK_NEAR(multi.GetDelta(), sum / channels, 1e-15);
+
+    // Filter edits rerun per channel without touching the noise.
+    cfg.threshold = 2.0f;
+    multi.Update(cfg);
+    CHECK(!(multi.GetLastRunStages() & SignalProcessor::StageNoise));
+    cfg.channels = 1;
+    multi.Update(cfg);
+    CHECK(multi.GetLastRunStages() & SignalProcessor::StageNoise);
+    CHECK(multi.GetCleanSignal().size() == n);
+}
+
+// Selecting the FIR filter only reruns its own stage and Delta; its output
+// is the filter's Apply on each noisy channel, and the spectral Delta
+// stays available for comparison.
+void test_fir_source()
+{
+    SignalProcessor::Config cfg;
+    cfg.pointCount = 4000;
+    cfg.channels = 3;
+    cfg.noiseAlpha = 0.5f;
+    cfg.harmonics = { { 10, 10, 0 }, { 3, 40, 1 } };
+
+    SignalProcessor processor;
+    processor.Update(cfg);
+    const double spectralDelta = processor.GetDelta();
+    const std::vector<double> spectralClean = processor.GetCleanSignal();
+    CHECK(processor.GetSpectralDelta() == spectralDelta);
+    CHECK(std::isnan(processor.GetFirDelta()));
+
+    cfg.clean = CleanSource::Fir;
+    cfg.firHigh = 60;
+    cfg.firTaps = 150;
+    processor.Update(cfg);
+    CHECK(processor.GetLastRunStages() == (SignalProcessor::StageFir | SignalProcessor::StageDelta));
+    CHECK(processor.GetSpectralDelta() == spectralDelta);
+    CHECK(processor.GetFirDelta() == processor.GetDelta());
+
+    std::vector<double> taps;
+    SignalProcessor::DesignFir(cfg, taps);
+    CHECK(taps.size() == 151);
+    FirFilter filter(taps);
+    const size_t n = size_t(cfg.pointCount);
+    const auto& input = processor.GetInputSignal();
+    std::vector<double> expected(n);
+    double noiseDelta = 0, idealEnergy = 0;
+    for (size_t c = 0; c < 3; ++c)
+    {
+        filter.Apply(input.data() + c * n, expected.data(), n);
+        CHECK(std::equal(expected.begin(), expected.end(), processor.GetCleanSignal().begin() + c * n));
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        double error = input[i] - processor.GetIdealSignal()[i];
+        noiseDelta += error * error;
+        idealEnergy += processor.GetIdealSignal()[i] * processor.GetIdealSignal()[i];
+    }
+    // Away from the edges a 60 Hz low-pass removes most of the noise.
+    CHECK(processor.GetChannelDelta(0) < 0.25 * noiseDelta / idealEnergy);
+    CHECK(processor.GetCleanSpectrum().size() == 3 * (n / 2 + 1));
+
+    // Float runs the same filter.
+    cfg.precision = Precision::Float;
+    processor.Update(cfg);
+    CHECK(processor.GetFirDelta() == processor.GetDelta());
+    std::vector<double> fir = processor.GetCleanSignal();
+    cfg.precision = Precision::Double;
+    processor.Update(cfg);
+    double error = 0;
+    for (size_t i = 0; i < fir.size(); ++i) error = std::max(error, std::abs(fir[i] - processor.GetCleanSignal()[i]));
+    CHECK(error <= 1e-3);
+
+    cfg.clean = CleanSource::Spectral;
+    processor.Update(cfg);
+    CHECK(processor.GetCleanSignal() == spectralClean);
+    CHECK(processor.GetDelta() == spectralDelta);
+    CHECK(std::isnan(processor.GetFirDelta()));
+}
+
+void test_pyramid()
+{
+    const size_t n = 1 << 20;
+    std::vector<double> x(n), y(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        x[i] = double(i);
+        y[i] = std::sin(i * 1e-3);
+    }
+    y[123457] = 50;
+    y[654321] = -40;
+
+    MinMaxPyramid pyramid;
+    pyramid.Build(x.data(), y.data(), n);
+
+    std::vector<double> xs, ys;
+    pyramid.Query(0, double(n), 1000, xs, ys);
+    CHECK(xs.size() == ys.size());
+    CHECK(xs.size() <= 8 * 1000);
+    CHECK(*std::max_element(ys.begin(), ys.end()) == 50);
+    CHECK(*std::min_element(ys.begin(), ys.end()) == -40);
+
+    // Zoomed in far enough, the raw samples come back.
+    pyramid.Query(1000, 1100, 1000, xs, ys);
+    CHECK(xs.size() == 103);
+    CHECK(xs.front() == 999 && ys[1] == y[1000]);
+}
+}
+
+int main()
+{
+    test_philox_known_answers();
+    test_noise_chunks();
+    test_noise_tail();
+    test_oscillator();
+    test_incremental_update();
+    test_precision();
+    test_channels();
+    test_fir_source();
+    test_pyramid();
+    return check_result();
+}
@@ -0,0 +1,135 @@
+// Spectrogram: levels of bin-centred tones, rows against a windowed DFT of
+// their frames, the ring of retained frames, streams cut into uneven
+// pushes and a tone that changes frequency mid-stream.
+
+#include "Check.h"
+#include "Spectrogram.h"
+#include "math/noise.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+size_t peak_bin(const float* row, size_t bins) { return size_t(std::max_element(row, row + bins) - row); }
+
+void test_tone_levels()
+{
+    Spectrogram::Config cfg;
+    cfg.frameSize = 512;
+    cfg.hopSize = 128;
+    cfg.rows = 64;
+    Spectrogram spectrogram(cfg);
+    CHECK(spectrogram.Bins() == 257);
+
+    const size_t n = 512 + 128 * 99;
+    std::vector<double> x(n);
+    for (size_t i = 0; i < n; ++i) x[i] = 0.5 * std::sin(2 * PI * 32 * double(i) / 512 + 0.7);
+    spectrogram.Push(x.data(), n);
+
+    CHECK(spectrogram.Frames() == 100);
+    CHECK(spectrogram.FirstRetained() == 36);
+    for (uint64_t f = spectrogram.FirstRetained(); f < spectrogram.Frames(); ++f)
+    {
+        const float* row = spectrogram.Row(f);
+        CHECK(peak_bin(row, spectrogram.Bins()) == 32);
+        CHECK_NEAR(row[32], 20 * std::log10(0.5), 1e-3);
+        CHECK(row[100] == cfg.floorDb);
+    }
+
+    bool threw = false;
+    try
+    {
+        cfg.hopSize = 513;
+        Spectrogram invalid(cfg);
+    }
+    catch (const std::invalid_argument&)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+// Every retained row against a double-precision Hann-windowed DFT of its
+// frame, and the same rows from a stream pushed in uneven pieces.
+void test_against_dft()
+{
+    Spectrogram::Config cfg;
+    cfg.frameSize = 256;
+    cfg.hopSize = 100;
+    cfg.rows = 20;
+    const size_t n = 10007;
+    std::vector<double> x(n);
+    gaussian_noise(11, 0, x.data(), n);
+
+    Spectrogram whole(cfg), pieces(cfg);
+    whole.Push(x.data(), n);
+    const size_t sizes[] = { 1, 255, 256, 3, 1000, 99 };
+    for (size_t done = 0, i = 0; done < n; ++i)
+    {
+        size_t count = std::min(sizes[i % 6], n - done);
+        pieces.Push(x.data() + done, count);
+        done += count;
+    }
+    CHECK(whole.Frames() == (n - 256) / 100 + 1);
+    CHECK(pieces.Frames() == whole.Frames());
+
+    const size_t frameSize = 256, bins = whole.Bins();
+    double windowSum = 0;
+    for (size_t i = 0; i < frameSize; ++i) windowSum += 0.5 - 0.5 * std::cos(2 * PI * double(i) / frameSize);
+
+    double error = 0;
+    bool same = true;
+    for (uint64_t f = whole.FirstRetained(); f < whole.Frames(); ++f)
+    {
+        same &= std::equal(whole.Row(f), whole.Row(f) + bins, pieces.Row(f));
+        for (size_t k = 0; k < bins; ++k)
+        {
+            Complex sum = 0;
+            for (size_t i = 0; i < frameSize; ++i)
+            {
+                double w = 0.5 - 0.5 * std::cos(2 * PI * double(i) / frameSize);
+                sum += x[f * 100 + i] * w * std::polar(1.0, -2 * PI * double(k * i % frameSize) / frameSize);
+            }
+            double level = 20 * std::log10(2 * std::abs(sum) / windowSum);
+            // Float rounding only matters far below the signal.
+            if (level > -60) error = std::max(error, std::abs(whole.Row(f)[k] - level));
+        }
+    }
+    CHECK(same);
+    CHECK(error < 1e-3);
+}
+
+// Rows follow a tone that jumps from bin 20 to bin 60 halfway through.
+void test_time_varying()
+{
+    Spectrogram::Config cfg;
+    cfg.frameSize = 128;
+    cfg.hopSize = 64;
+    cfg.rows = 1000;
+    const size_t n = 64 * 200;
+    std::vector<double> x(n);
+    for (size_t i = 0; i < n; ++i) x[i] = std::sin(2 * PI * (i < n / 2 ? 20 : 60) * double(i) / 128);
+
+    Spectrogram spectrogram(cfg);
+    spectrogram.Push(x.data(), n);
+    CHECK(spectrogram.FirstRetained() == 0);
+    for (uint64_t f = 0; f < spectrogram.Frames(); ++f)
+    {
+        const size_t first = size_t(f) * 64, last = first + 127;
+        const float* row = spectrogram.Row(f);
+        if (last < n / 2) CHECK(peak_bin(row, spectrogram.Bins()) == 20);
+        if (first >= n / 2) CHECK(peak_bin(row, spectrogram.Bins()) == 60);
+    }
+}
+}
+
+int main()
+{
+    test_tone_levels();
+    test_against_dft();
+    test_time_varying();
+    return check_result();
+}
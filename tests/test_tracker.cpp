@@ -0,0 +1,180 @@
+// Tone tracking: exact amplitudes and phases of whole-cycle tones, the
+// Hann window on tones between bins, the sliding sums against a windowed
+// DFT of the last samples, streams cut into uneven calls and rounding
+// drift over a long run.
+
+#include "Check.h"
+#include "SignalProcessor.h"
+#include "math/fft.h"
+#include "math/noise.h"
+#include "math/tone_tracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+std::vector<double> tones(const std::vector<SinParam>& params, int sampleRate, size_t n)
+{
+    std::vector<double> x(n);
+    for (const auto& p : params)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            x[i] += p.amplitude * std::sin(2 * PI * p.frequency * double(i) / sampleRate + p.phase);
+        }
+    }
+    return x;
+}
+
+ToneTracker::Config config(int sampleRate, const std::vector<SinParam>& params, size_t window,
+                           ToneTracker::Window kind)
+{
+    ToneTracker::Config cfg;
+    cfg.sampleRate = sampleRate;
+    for (const auto& p : params) cfg.frequencies.push_back(p.frequency);
+    cfg.windowSize = window;
+    cfg.window = kind;
+    return cfg;
+}
+
+double phase_difference(double a, double b) { return std::abs(std::remainder(a - b, 2 * PI)); }
+
+// Every tracked tone against its parameters.
+void check_estimates(const ToneTracker& tracker, const std::vector<SinParam>& params, double tolerance)
+{
+    std::vector<ToneEstimate> estimates(tracker.Tones());
+    tracker.Estimates(estimates.data());
+    for (size_t t = 0; t < params.size(); ++t)
+    {
+        CHECK(estimates[t].frequency == params[t].frequency);
+        CHECK_NEAR(estimates[t].amplitude, params[t].amplitude, tolerance);
+        CHECK(phase_difference(estimates[t].phase, params[t].phase) <= tolerance);
+    }
+}
+
+// Whole cycles in the window: exact with either window, and half the
+// amplitude with a rectangular window half filled.
+void test_whole_cycles()
+{
+    const std::vector<SinParam> params{ { 1.0f, 50.0f, 0.3f }, { 0.5f, 120.0f, -2.0f }, { 0.25f, 310.0f, 3.0f } };
+    const auto x = tones(params, 1000, 5000);
+
+    ToneTracker rectangular(config(1000, params, 1000, ToneTracker::Window::Rectangular));
+    rectangular.Process(x.data(), 500);
+    CHECK(!rectangular.IsSettled());
+    std::vector<ToneEstimate> half(rectangular.Tones());
+    rectangular.Estimates(half.data());
+    for (size_t t = 0; t < params.size(); ++t) CHECK_NEAR(half[t].amplitude, 0.5 * params[t].amplitude, 1e-12);
+
+    rectangular.Process(x.data() + 500, x.size() - 500);
+    CHECK(rectangular.IsSettled());
+    CHECK(rectangular.Samples() == x.size());
+    check_estimates(rectangular, params, 1e-12);
+
+    ToneTracker hann(config(1000, params, 1000, ToneTracker::Window::Hann));
+    hann.Process(x.data(), x.size());
+    check_estimates(hann, params, 1e-12);
+}
+
+// Tones between bins leak through the rectangular window but not much
+// through the Hann window.
+void test_between_bins()
+{
+    const std::vector<SinParam> params{ { 1.0f, 440.0f, 0.0f }, { 0.3f, 1234.5f, 1.0f }, { 0.1f, 3000.7f, -1.0f } };
+    const auto x = tones(params, 8000, 20000);
+
+    ToneTracker hann(config(8000, params, 4096, ToneTracker::Window::Hann));
+    hann.Process(x.data(), x.size());
+    check_estimates(hann, params, 1e-6);
+
+    ToneTracker rectangular(config(8000, params, 4096, ToneTracker::Window::Rectangular));
+    rectangular.Process(x.data(), x.size());
+    std::vector<ToneEstimate> estimates(rectangular.Tones());
+    rectangular.Estimates(estimates.data());
+    double error = 0;
+    for (size_t t = 0; t < params.size(); ++t)
+    {
+        error = std::max(error, std::abs(estimates[t].amplitude - params[t].amplitude));
+    }
+    CHECK(error > 1e-4);
+}
+
+// Sliding sums against the Hann-windowed DFT of the last window, on noisy
+// input cut into calls of uneven sizes.
+void test_against_dft()
+{
+    const int sampleRate = 1000;
+    const size_t window = 700, n = 30011;
+    const std::vector<SinParam> params{ { 1.0f, 33.3f, 0.5f }, { 0.2f, 210.0f, 2.5f } };
+    auto x = tones(params, sampleRate, n);
+    std::vector<double> noise(n);
+    gaussian_noise(9, 0, noise.data(), n);
+    for (size_t i = 0; i < n; ++i) x[i] += 0.1 * noise[i];
+
+    ToneTracker whole(config(sampleRate, params, window, ToneTracker::Window::Hann));
+    whole.Process(x.data(), n);
+
+    ToneTracker pieces(config(sampleRate, params, window, ToneTracker::Window::Hann));
+    const size_t sizes[] = { 1, 699, 700, 3, 1024, 2500 };
+    for (size_t done = 0, i = 0; done < n; ++i)
+    {
+        size_t count = std::min(sizes[i % 6], n - done);
+        pieces.Process(x.data() + done, count);
+        done += count;
+    }
+
+    std::vector<ToneEstimate> a(whole.Tones()), b(pieces.Tones());
+    whole.Estimates(a.data());
+    pieces.Estimates(b.data());
+    bool same = true;
+    for (size_t t = 0; t < a.size(); ++t) same &= a[t].amplitude == b[t].amplitude && a[t].phase == b[t].phase;
+    CHECK(same);
+
+    for (size_t t = 0; t < params.size(); ++t)
+    {
+        const double omega = 2 * PI * params[t].frequency / sampleRate;
+        Complex sum = 0;
+        for (size_t j = 0; j < window; ++j)
+        {
+            const size_t m = n - window + j;
+            const double w = 0.5 - 0.5 * std::cos(2 * PI * double(j) / double(window));
+            sum += x[m] * w * std::polar(1.0, -std::fmod(omega * double(m), 2 * PI));
+        }
+        const double amplitude = 4 * std::abs(sum) / double(window);
+        CHECK_NEAR(a[t].amplitude, amplitude, 1e-10);
+        CHECK(phase_difference(a[t].phase, std::arg(sum) + 0.5 * PI) <= 1e-10);
+        // The noise moves the estimate only a little.
+        CHECK_NEAR(a[t].amplitude, params[t].amplitude, 0.05);
+    }
+}
+
+// Half an hour at 2 kHz: the sums must not drift away.
+void test_long_run()
+{
+    const int sampleRate = 2000;
+    const std::vector<SinParam> params{ { 1.0f, 100.0f, 1.0f }, { 0.5f, 437.0f, 0.0f } };
+    const size_t block = 2000, blocks = 1800;
+    ToneTracker tracker(config(sampleRate, params, 2000, ToneTracker::Window::Hann));
+
+    std::vector<double> x(block);
+    for (size_t k = 0; k < blocks; ++k)
+    {
+        // Whole seconds, so every block repeats the first.
+        if (k == 0) x = tones(params, sampleRate, block);
+        tracker.Process(x.data(), x.size());
+    }
+    CHECK(tracker.Samples() == block * blocks);
+    check_estimates(tracker, params, 1e-9);
+}
+}
+
+int main()
+{
+    test_whole_cycles();
+    test_between_bins();
+    test_against_dft();
+    test_long_run();
+    return check_result();
+}